@@ -0,0 +1,42 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_AFPACKET_H
+#define NETWORK_TRAFFIC_ANALYZER_AFPACKET_H
+
+/* Parâmetros padrão do anel TPACKET_V3 (compartilhado entre kernel e user-space) */
+#define RING_BLOCK_SIZE     (1 << 22)   // 4 MiB por bloco (múltiplo de PAGE_SIZE)
+#define RING_BLOCK_COUNT    64          // 64 blocos = 256 MiB de anel
+#define RING_FRAME_SIZE     2048        // Tamanho nominal do frame (exigido pelo kernel no V3)
+#define RING_RETIRE_MS      60          // Tempo máximo que um bloco parcial fica preso no kernel
+#define RING_STATS_INTERVAL 10          // Intervalo (em segundos) do relatório de estatísticas
+
+/**
+ * @struct RingConfig
+ * @brief Dimensionamento do anel de blocos AF_PACKET escolhido na inicialização.
+ */
+typedef struct {
+    unsigned int block_size;            // Tamanho de cada bloco em bytes
+    unsigned int block_count;           // Quantidade de blocos do anel
+    unsigned int retire_ms;             // Timeout de aposentadoria de blocos parciais
+    unsigned int workers;               // Threads de captura no grupo PACKET_FANOUT (1 = sem fanout)
+    const char *filter;                 // Expressão BPF anexada a cada socket (NULL = padrão dos detectores)
+    int snaplen;                        // Bytes copiados por frame para o anel
+    int burst;                          // Frames por lote de análise (1 = caminho por pacote)
+} RingConfig;
+
+/**
+ * @struct RingStats
+ * @brief Contadores acumulados do anel, usados para dimensionar block_size/block_count.
+ */
+typedef struct {
+    unsigned long long blocks;          // Blocos entregues ao user-space
+    unsigned long long blocks_timeout;  // Blocos aposentados por timeout (anel ocioso)
+    unsigned long long blocks_losing;   // Blocos marcados com TP_STATUS_LOSING (houve descarte)
+    unsigned long long packets;         // Pacotes contabilizados pelo kernel
+    unsigned long long drops;           // Pacotes descartados por falta de bloco livre
+    unsigned long long freezes;         // Vezes em que a fila congelou por anel cheio
+} RingStats;
+
+void ring_config_defaults(RingConfig *cfg);
+void start_afpacket_sniffer(const char *device, const RingConfig *cfg);
+void stop_afpacket_sniffer(void);
+
+#endif
@@ -2,5 +2,208 @@
 #define NETWORK_TRAFFIC_ANALYZER_ANALYZER_H
 
 #include <pcap.h>
-int analyze_packet(const u_char *packet, int length);
+#include <time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ip6_table.h"
+
+// Estado do IDS (opaco); um shard por worker de captura
+typedef struct IdsShard IdsShard;
+
+/* Detectores que podem ser habilitados individualmente (--detectors) */
+#define DETECT_PORT_SCAN   (1u << 0)
+#define DETECT_ICMP_FLOOD  (1u << 1)
+#define DETECT_HOST_SWEEP  (1u << 2)
+#define DETECT_STEALTH     (1u << 3)
+#define DETECT_SYN_FLOOD   (1u << 4)
+#define DETECT_UDP_SCAN    (1u << 5)
+#define DETECT_UDP_FLOOD   (1u << 6)
+#define DETECT_ALL         (DETECT_PORT_SCAN | DETECT_ICMP_FLOOD | DETECT_HOST_SWEEP | DETECT_STEALTH | DETECT_SYN_FLOOD | \
+                            DETECT_UDP_SCAN | DETECT_UDP_FLOOD)
+
+typedef enum {
+    SHARD_LIVE,         // Memória fixa (orçamento), despejo, expiração de inativos e publicação
+    SHARD_FORENSIC      // Cresce sem limite, sem expiração e sem publicação (modo batch)
+} ShardMode;
+
+// Orçamento padrão de memória do rastreador de origens (--tracker-mb)
+#define TRACKER_BUDGET_MB 16
+
+// Portas distintas que caracterizam um TCP Port Scan (--scan-threshold)
+#define SCAN_THRESHOLD 15
+
+// Segmentos NULL/FIN/Xmas/SYN-FIN de uma origem que caracterizam um stealth scan (--stealth-threshold)
+#define STEALTH_THRESHOLD 3
+
+// Portas UDP distintas que caracterizam um UDP scan (--udp-scan-threshold); respostas ICMP
+// port-unreachable à origem confirmam a sondagem e reduzem o limiar à metade
+#define UDP_SCAN_THRESHOLD 15
+#define UDP_UNREACH_CONFIRM 3       // Port-unreachables recebidos que confirmam a sondagem (--udp-unreach)
+
+// UDP flood: taxa máxima tolerada por origem, medida em janelas de 1 s
+#define UDP_PPS_THRESHOLD 5000      // Pacotes/s (--udp-pps)
+#define UDP_BPS_THRESHOLD 12500000  // Bytes/s, ~100 Mbit/s (--udp-bps)
+
+// ICMP flood: taxa máxima tolerada por origem e largura da janela deslizante
+#define ICMP_PPS_THRESHOLD 20       // Pacotes/s (--icmp-pps)
+#define ICMP_BPS_THRESHOLD 125000   // Bytes/s, ~1 Mbit/s (--icmp-bps)
+#define ICMP_WINDOW_MS 1000         // Janela em ms (--icmp-window)
+
+// SYN flood por serviço (destino, porta), medido em janelas de 1 s
+#define SYNFLOOD_RATE 200           // Handshakes meio-abertos/s (--synflood-rate)
+#define SYNFLOOD_RATIO 3            // SYN/s acima de N x SYN-ACK/s, com ao menos SYNFLOOD_RATE SYN/s (--synflood-ratio)
+
+// Pacotes (acima do ruído do sketch) para uma origem nova entrar no rastreador sob pressão
+#define PROMOTE_THRESHOLD 4         // --promote-threshold; 1 desliga o estágio de admissão
+
+// Resumo periódico de maiores emissores (Space-Saving)
+#define TOPK_SIZE 10                // Posições por ranking (--top-k; 0 desliga)
+#define TOPK_INTERVAL_S 10          // Intervalo entre resumos em segundos (--top-interval)
+
+// Tabela de fluxos bidirecionais (registros exportados no lugar da telemetria por pacote)
+#define FLOW_TABLE_MB 8             // Orçamento de memória (--flow-mb; 0 desliga)
+#define FLOW_IDLE_S 15              // Inatividade que encerra um fluxo (--flow-idle)
+#define FLOW_ACTIVE_S 120           // Duração máxima antes de um registro parcial (--flow-active)
+
+// Bits iniciais do endereço IPv6 de origem que identificam uma origem no rastreador
+// (--ipv6-prefix; 0 descarta o IPv6). O /64 agrega os endereços temporários de um host
+#define IPV6_PREFIX 64
+
+// Túneis aninhados (GRE, VXLAN, ERSPAN) removidos antes da detecção (--tunnel-depth; 0 desliga)
+#define TUNNEL_DEPTH 2
+
+// Destinos distintos (estimados por HyperLogLog) que caracterizam um Host Sweep (--sweep-threshold)
+#define SWEEP_THRESHOLD 64
+
+/**
+ * @struct TrackerStats
+ * @brief Ocupação e pressão do rastreador de origens de um shard.
+ */
+typedef struct {
+    unsigned long long tracked;             // Origens rastreadas no momento
+    unsigned long long capacity;            // Máximo de origens que cabem no orçamento
+    unsigned long long memory_bytes;        // Memória do pool + índice
+    unsigned long long evictions;           // Origens despejadas para abrir espaço
+    unsigned long long evictions_pressure;  // Despejos sem nenhuma entrada ociosa e benigna à mão
+    unsigned long long evictions_suspects;  // Despejos de origens a meio caminho de um alerta
+    unsigned long long expirations;         // Origens esquecidas por inatividade
+    unsigned long long admission_held;      // Pacotes de origens retidas no sketch de admissão
+    unsigned long long admission_promoted;  // Origens admitidas no rastreador exato
+    unsigned long long set_bytes;           // Heap dos conjuntos de portas e sketches (fora do orçamento fixo)
+    unsigned long long flows;               // Fluxos abertos na tabela de fluxos
+    unsigned long long flows_exported;      // Registros de fluxo exportados (todos os motivos)
+} TrackerStats;
+
+// Tamanho máximo de um lote processado de uma vez por analyze_batch()
+#define ANALYZE_BATCH_MAX 64
+
+// Maior valor de required_snaplen(): IPv6 com --tunnel-depth no teto e citação ICMPv6
+#define REQUIRED_SNAPLEN_MAX 640
+
+// Referência a um pacote já capturado; o buffer pertence ao backend de captura
+typedef struct {
+    const u_char *data;     // Bytes capturados a partir do cabeçalho de enlace
+    uint32_t caplen;        // Bytes válidos em data
+    uint32_t len;           // Tamanho original no fio
+    uint64_t ts_ns;         // Timestamp de captura (ns desde a época); 0 = indisponível
+} PacketRef;
+
+/**
+ * @struct DecodedPacket
+ * @brief Descritor compacto de um pacote, único insumo dos detectores.
+ * * A decodificação valida cada pacote uma única vez: todo campo daqui já foi
+ * conferido contra o caplen e contra os tamanhos que o próprio pacote declara
+ * (ip_hl, comprimento total, carga IPv6), e nenhum detector volta a ler o
+ * buffer bruto. Os offsets são relativos ao início do buffer de captura, de
+ * modo que um detector novo chega à carga sem refazer o parsing.
+ * * Num pacote IPv6, src_ip e dst_ip recebem o hash de 32 bits dos endereços
+ * completos: as estruturas chaveadas por IPv4 (handshakes, sketch de destinos)
+ * funcionam sem alteração, e só o rastreador de origens usa o prefixo de 128 bits.
+ * * Num pacote encapsulado (GRE, VXLAN, ERSPAN) todos os campos descrevem o
+ * pacote interno; do túnel fica só a identificação da camada mais externa.
+ * * Os campos estão ordenados por alinhamento e ocupam exatamente uma linha de
+ * cache; o kernel de extração escreve a segunda metade com registradores
+ * vetoriais, então a disposição dos bytes é parte do contrato.
+ */
+typedef struct DecodedPacket {
+    Ip6Key src6;                        // Origem IPv6 completa (sem máscara)
+    Ip6Key dst6;                        // Destino IPv6 completo
+    uint32_t src_ip;                    // Endereço de origem (formato de rede)
+    uint32_t dst_ip;                    // Endereço de destino (formato de rede)
+    uint32_t tunnel_id;                 // VNI, sessão ERSPAN ou chave GRE do túnel externo
+    int length;                         // Tamanho no fio do pacote analisado (descontados os cabeçalhos de túnel)
+    uint16_t src_port;                  // Porta de origem (TCP/UDP), em ordem do host
+    uint16_t dst_port;                  // Porta de destino (TCP/UDP), em ordem do host
+    uint16_t frame_offset;              // Início do quadro analisado (depois dos túneis removidos)
+    uint16_t l3_offset;                 // Início do cabeçalho IP analisado
+    uint16_t l4_offset;                 // Início do cabeçalho de transporte
+    uint16_t l4_length;                 // Bytes de transporte capturados dentro do datagrama IP
+    uint8_t proto;                      // IPPROTO_* (ICMPv6 normalizado para IPPROTO_ICMP); 0 indica pacote descartado
+    uint8_t tcp_flags;                  // Byte de flags do segmento TCP (0 nos demais protocolos)
+    uint8_t unreachable : 1;            // ICMP port-unreachable citando um datagrama UDP enviado por dst_ip
+    uint8_t ipv6 : 1;                   // 1 = endereços completos em src6/dst6
+    uint8_t tunnel : 3;                 // TunnelType da camada mais externa removida (TUNNEL_NONE = sem túnel)
+    uint8_t tunnel_depth : 3;           // Túneis removidos até aqui (<= TUNNEL_DEPTH_MAX)
+} DecodedPacket;
+
+_Static_assert(sizeof(DecodedPacket) == 64, "DecodedPacket deve ocupar exatamente uma linha de cache");
+
+// Resultado de benchmark_decoder(): custo por pacote e cobertura do kernel de cabeçalhos
+typedef struct {
+    double ns_per_packet;
+    size_t fast;            // Pacotes resolvidos pelo kernel (caminho rápido)
+    size_t mismatches;      // Descritores do kernel diferentes dos do decodificador de enlace
+} DecodeBenchmark;
+
+void set_enabled_detectors(unsigned int mask);
+unsigned int get_enabled_detectors(void);
+
+void set_scan_threshold(unsigned int ports);
+void set_stealth_threshold(unsigned int segments);
+void set_sweep_threshold(unsigned int hosts);
+void set_udp_scan_threshold(unsigned int ports);
+void set_udp_unreach_confirm(unsigned int replies);
+void set_udp_pps_threshold(unsigned int pps);
+void set_udp_bps_threshold(unsigned int bps);
+void set_icmp_pps_threshold(unsigned int pps);
+void set_icmp_bps_threshold(unsigned int bps);
+void set_icmp_window(unsigned int ms);
+void set_synflood_rate(unsigned int half_open);
+void set_synflood_ratio(unsigned int ratio);
+void set_promote_threshold(unsigned int packets);
+void set_topk_size(unsigned int k);
+void set_topk_interval(unsigned int seconds);
+void set_sketch_audit(int enabled);
+void set_tracker_budget(size_t bytes);
+size_t get_tracker_budget(void);
+void set_flow_budget(size_t bytes);
+size_t get_flow_budget(void);
+void set_flow_idle(unsigned int seconds);
+void set_flow_active(unsigned int seconds);
+void set_ipv6_prefix(unsigned int bits);
+unsigned int get_ipv6_prefix(void);
+void set_tunnel_depth(unsigned int levels);
+unsigned int get_tunnel_depth(void);
+
+IdsShard *create_ids_shard(ShardMode mode, size_t memory_budget);
+void destroy_ids_shard(IdsShard *shard);
+IdsShard *get_default_shard(void);
+int set_shard_datalink(IdsShard *shard, int datalink);
+int set_datalink(int datalink);
+int benchmark_decoder(int datalink, int kernel, const PacketRef *pkts, size_t count, unsigned int rounds,
+                      DecodeBenchmark *result);
+void get_tracker_stats(const IdsShard *shard, TrackerStats *stats);
+void print_tracker_stats(const char *tag, const IdsShard *shard);
+void flush_ids_shard(IdsShard *shard);
+
+int analyze_packet(const u_char *packet, int caplen, int length, uint64_t ts_ns);
+int analyze_packet_shard(IdsShard *shard, const u_char *packet, int caplen, int length, uint64_t ts_ns);
+int analyze_batch(const PacketRef *pkts, size_t count);
+int analyze_batch_shard(IdsShard *shard, const PacketRef *pkts, size_t count);
+int required_snaplen(unsigned int detectors);
+
+// Mesclagem determinística de estados (modo batch)
+void restart_rate_windows(IdsShard *shard);
+void merge_ids_shard(IdsShard *dst, IdsShard *src);
+int report_ids_shard(IdsShard *shard);
 #endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_BATCH_H
+#define NETWORK_TRAFFIC_ANALYZER_BATCH_H
+
+/**
+ * @struct BatchConfig
+ * @brief Parâmetros da análise forense em lote de um diretório de capturas.
+ */
+typedef struct {
+    const char *directory;              // Diretório com os pcaps rotacionados do incidente
+    unsigned int jobs;                  // Threads do pool (0 = uma por CPU)
+    const char *filter;                 // Expressão BPF aplicada a cada arquivo (NULL = padrão dos detectores)
+} BatchConfig;
+
+int run_batch(const BatchConfig *cfg);
+
+#endif
@@ -3,8 +3,41 @@
 
 #include <pcap.h>
 #define SNAP_LEN 1518
+#define SNAP_LEN_HEADERS 128    // Perfil "somente cabeçalhos" (--headers-only)
 
-void start_sniffer(char *device);
+#include "analyzer.h"
+#include "stats.h"
+
+// Bytes de cada pacote copiados para o lote: o maior snaplen que os detectores podem
+// exigir (todos os níveis de túnel com IPv6), para que o lote nunca corte o que o
+// snaplen da captura entregou
+#define BATCH_SLOT_SIZE REQUIRED_SNAPLEN_MAX
+
+/**
+ * @struct PacketBatch
+ * @brief Lote de pacotes copiados do buffer da libpcap, que só é válido durante o callback.
+ * * Apenas os primeiros BATCH_SLOT_SIZE bytes são copiados: os detectores leem
+ * somente cabeçalhos, e o tamanho original continua disponível em len.
+ */
+typedef struct {
+    PacketRef refs[ANALYZE_BATCH_MAX];
+    u_char data[ANALYZE_BATCH_MAX][BATCH_SLOT_SIZE];
+    size_t count;
+    int nano;               // Timestamps da libpcap em ns (PCAP_TSTAMP_PRECISION_NANO)
+} PacketBatch;
+
+/**
+ * @brief Converte o timestamp da libpcap para ns desde a época.
+ * * Com PCAP_TSTAMP_PRECISION_NANO o campo tv_usec carrega nanossegundos.
+ */
+static inline uint64_t pcap_timestamp_ns(const struct pcap_pkthdr *header, int nano) {
+    uint64_t frac = (uint64_t)header->ts.tv_usec;
+    return (uint64_t)header->ts.tv_sec * NSEC_PER_SEC + (nano ? frac : frac * 1000ull);
+}
+
+void batch_append(PacketBatch *batch, const struct pcap_pkthdr *header, const u_char *packet);
+void start_sniffer(char *device, const char *filter, int snaplen, int burst);
+void stop_sniffer(void);
 void packet_handler(u_char *args, const struct pcap_pkthdr *header, const u_char *packet);
 
 #endif
\ No newline at end of file
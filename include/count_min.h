@@ -0,0 +1,41 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_COUNT_MIN_H
+#define NETWORK_TRAFFIC_ANALYZER_COUNT_MIN_H
+
+#include <stdint.h>
+
+/* Geometria do sketch: 4 linhas de 8192 contadores de 16 bits (64 KiB por geração) */
+#define CMS_DEPTH      4
+#define CMS_WIDTH_BITS 13
+#define CMS_WIDTH      (1 << CMS_WIDTH_BITS)
+
+/**
+ * @struct CountMinSketch
+ * @brief Contagem aproximada por chave, com duas gerações que giram a cada janela.
+ * * A estimativa soma a geração corrente à anterior, então cobre entre uma e
+ * duas janelas de tráfego e nunca subestima a contagem real dentro delas.
+ * O total de atualizações das duas gerações mede o ruído de colisão.
+ */
+typedef struct {
+    uint16_t *counters[2];              // [geração][linha * CMS_WIDTH + coluna]
+    uint32_t total[2];                  // Atualizações recebidas por geração
+    int current;                        // Geração que recebe as atualizações
+    uint64_t epoch;                     // Índice da janela corrente (ts / window_ns)
+    uint64_t window_ns;                 // Largura da janela de rotação
+} CountMinSketch;
+
+void count_min_init(CountMinSketch *sketch, uint64_t window_ns);
+void count_min_free(CountMinSketch *sketch);
+uint32_t count_min_add(CountMinSketch *sketch, uint32_t key, uint64_t now);
+
+/**
+ * @brief Contagem média por contador nas duas gerações (colisões esperadas por chave).
+ */
+static inline uint32_t count_min_noise(const CountMinSketch *sketch) {
+    return (uint32_t)(((uint64_t)sketch->total[0] + sketch->total[1]) >> CMS_WIDTH_BITS);
+}
+
+static inline uint64_t count_min_bytes(void) {
+    return 2ull * CMS_DEPTH * CMS_WIDTH * sizeof(uint16_t);
+}
+
+#endif
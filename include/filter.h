@@ -0,0 +1,14 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_FILTER_H
+#define NETWORK_TRAFFIC_ANALYZER_FILTER_H
+
+#include <stddef.h>
+#include <pcap.h>
+
+#define FILTER_MAX_LEN 512
+
+void build_default_filter(unsigned int detectors, int flows, int datalink, char *buffer, size_t size);
+int apply_pcap_filter(pcap_t *handle, const char *expression, int verbose);
+int apply_capture_filter(pcap_t *handle, const char *expression, int flows, int verbose);
+int attach_socket_filter(int fd, const char *expression, int snaplen, int datalink, int verbose);
+
+#endif
\ No newline at end of file
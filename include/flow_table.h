@@ -0,0 +1,57 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_FLOW_TABLE_H
+#define NETWORK_TRAFFIC_ANALYZER_FLOW_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "publisher.h"
+#include "timing_wheel.h"
+
+#define FLOW_EXPORT_BATCH 64            // Registros acumulados antes de cada publicação
+
+// Destino dos registros exportados (Ex: publish_flows)
+typedef void (*FlowExportFn)(const FlowRecord *flows, size_t count);
+
+/**
+ * @struct FlowSlot
+ * @brief Slot do índice: hash simétrico da 5-tupla e posição do fluxo no pool.
+ */
+typedef struct {
+    uint32_t hash;
+    int32_t index;                      // -1 quando livre
+} FlowSlot;
+
+/**
+ * @struct FlowTable
+ * @brief Tabela de fluxos bidirecionais com memória fixa.
+ * * O índice é de endereçamento aberto com hash simétrico, então os dois
+ * sentidos de uma conversa caem no mesmo fluxo. O pool é denso e cada fluxo
+ * tem um prazo na roda de temporização (inatividade, tempo ativo ou espera
+ * após FIN/RST); com a tabela cheia, o fluxo sob o ponteiro do relógio é
+ * exportado para abrir espaço.
+ */
+typedef struct {
+    FlowRecord *flows;
+    FlowSlot *slots;
+    uint32_t mask;                      // Slots do índice - 1 (ocupação <= 50%)
+    int count;
+    int capacity;
+    int clock_hand;
+    TimingWheel expiry;
+    uint64_t idle_ns;
+    uint64_t active_ns;
+    FlowExportFn export_fn;
+    FlowRecord pending[FLOW_EXPORT_BATCH];
+    int pending_count;
+    unsigned long long exported[FLOW_END_COUNT];
+} FlowTable;
+
+void flow_table_init(FlowTable *table, size_t budget, uint64_t idle_ns, uint64_t active_ns, FlowExportFn export_fn);
+void flow_table_free(FlowTable *table);
+void flow_table_update(FlowTable *table, uint32_t src_ip, uint32_t dst_ip, uint16_t src_port, uint16_t dst_port,
+                       uint8_t proto, uint8_t tcp_flags, int length, uint64_t now);
+void flow_table_expire(FlowTable *table, uint64_t now);
+void flow_table_drain(FlowTable *table);
+void flow_table_flush(FlowTable *table);
+size_t flow_table_bytes(const FlowTable *table);
+
+#endif
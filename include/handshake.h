@@ -0,0 +1,66 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_HANDSHAKE_H
+#define NETWORK_TRAFFIC_ANALYZER_HANDSHAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Geometria das tabelas: conjuntos de 4 vias, memória fixa */
+#define HANDSHAKE_WAYS         4
+#define HANDSHAKE_PENDING_BITS 15       // 32768 SYNs pendentes (256 KiB)
+#define HANDSHAKE_SERVICE_BITS 10       // 1024 serviços (destino, porta) acompanhados
+#define HANDSHAKE_TIMEOUT_NS   (3ull * 1000000000ull)  // Prazo para o ACK que completa o handshake
+#define HANDSHAKE_WINDOW_NS    (1ull * 1000000000ull)  // Janela das taxas por serviço
+
+enum { HS_SYN, HS_SYNACK, HS_DONE, HS_COUNTERS };
+
+/**
+ * @struct HandshakePending
+ * @brief SYN aguardando o ACK do cliente: impressão digital da 4-tupla e instante.
+ */
+typedef struct {
+    uint32_t tag;                       // Hash da 4-tupla (0 = slot livre)
+    uint32_t stamp;                     // Instante do SYN em unidades de 2^20 ns (~1 ms)
+} HandshakePending;
+
+/**
+ * @struct HandshakeService
+ * @brief Contadores de janela deslizante de um serviço (destino, porta).
+ * * Como em RateWindow, a taxa soma a janela corrente à fração ainda coberta
+ * da anterior; os três contadores giram juntos.
+ */
+typedef struct {
+    uint64_t key;                       // destino << 16 | porta, com o bit 48 ligado (0 = livre)
+    uint64_t epoch;                     // Índice da janela corrente
+    uint32_t counts[HS_COUNTERS][2];    // [contador][0 = anterior, 1 = corrente]
+    uint64_t alerted;                   // Janela do último alerta + 1 (limita a um por janela)
+} HandshakeService;
+
+/**
+ * @struct HandshakeTable
+ * @brief Estado de handshakes TCP por destino, com memória fixa e despejo aproximado.
+ * * Os SYNs pendentes e os serviços ficam em tabelas associativas por conjunto:
+ * cada operação examina só as HANDSHAKE_WAYS vias do conjunto, então o custo
+ * por pacote é constante. Com o conjunto cheio, sai o SYN mais antigo ou o
+ * serviço com menos SYNs recentes.
+ */
+typedef struct {
+    HandshakePending *pending;
+    HandshakeService *services;
+} HandshakeTable;
+
+void handshake_init(HandshakeTable *table);
+void handshake_free(HandshakeTable *table);
+int handshake_open(HandshakeTable *table, uint32_t client, uint16_t client_port,
+                   uint32_t server, uint16_t server_port, uint64_t now);
+int handshake_close(HandshakeTable *table, uint32_t client, uint16_t client_port,
+                    uint32_t server, uint16_t server_port, uint64_t now);
+HandshakeService *handshake_service(HandshakeTable *table, uint32_t server, uint16_t port, int create);
+void handshake_count(HandshakeService *service, int counter, uint64_t now);
+void handshake_rates(const HandshakeService *service, uint64_t now, uint32_t rates[HS_COUNTERS]);
+
+static inline size_t handshake_bytes(void) {
+    return ((size_t)1 << HANDSHAKE_PENDING_BITS) * sizeof(HandshakePending)
+         + ((size_t)1 << HANDSHAKE_SERVICE_BITS) * sizeof(HandshakeService);
+}
+
+#endif
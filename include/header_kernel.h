@@ -0,0 +1,24 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_HEADER_KERNEL_H
+#define NETWORK_TRAFFIC_ANALYZER_HEADER_KERNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "analyzer.h"
+
+#define HEADER_KERNEL_MAX 32            // Pacotes por chamada (um bit do retorno por pacote)
+
+/* Implementações do kernel, da mais simples à mais larga */
+typedef enum {
+    HEADER_KERNEL_NONE = 0,             // Sem caminho rápido: todo pacote passa pelo decodificador de enlace
+    HEADER_KERNEL_SCALAR,               // Mesmo perfil, com leituras byte a byte
+    HEADER_KERNEL_SSE42,                // Um pacote por registrador de 128 bits
+    HEADER_KERNEL_AVX2,                 // Dois pacotes por registrador de 256 bits
+    HEADER_KERNEL_COUNT
+} HeaderKernel;
+
+HeaderKernel header_kernel_detect(void);
+const char *header_kernel_name(HeaderKernel kernel);
+uint32_t header_kernel_extract(HeaderKernel kernel, const PacketRef *pkts, size_t count, uint16_t tunnel_port,
+                               DecodedPacket *out);
+
+#endif
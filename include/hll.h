@@ -0,0 +1,53 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_HLL_H
+#define NETWORK_TRAFFIC_ANALYZER_HLL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HLL_PRECISION     8             // p: os 8 bits altos do hash escolhem o registrador
+#define HLL_REGISTERS     (1 << HLL_PRECISION) // m = 256 registradores; erro padrão 1,04/sqrt(m) = 6,5%
+#define HLL_SPARSE_INLINE 4             // Registradores guardados dentro da própria estrutura
+#define HLL_SPARSE_MAX    64            // Acima disso a lista esparsa vira o vetor denso
+#define HLL_DENSE         UINT16_MAX    // Valor de capacity que indica o modo denso
+
+/**
+ * @struct HllSketch
+ * @brief Estimador HyperLogLog de cardinalidade (16 bytes + no máximo 256 no heap).
+ * * No modo esparso guarda só os registradores não nulos, como uma lista ordenada
+ * de (índice << 8 | rho), primeiro inline e depois no heap; a partir de
+ * HLL_SPARSE_MAX registradores passa ao vetor denso de HLL_REGISTERS bytes.
+ * A estimativa é recalculada apenas quando algum registrador muda.
+ */
+typedef struct {
+    uint16_t count;                     // Registradores não nulos (modo esparso)
+    uint16_t capacity;                  // 0 = inline; HLL_DENSE = denso; senão, capacidade da lista
+    uint32_t estimate;                  // Última estimativa de cardinalidade
+    union {
+        uint16_t small[HLL_SPARSE_INLINE];
+        uint16_t *sparse;               // Lista ordenada por índice (modo intermediário)
+        uint8_t *dense;                 // HLL_REGISTERS registradores
+    };
+} HllSketch;
+
+/**
+ * @brief Mistura de 64 bits (finalizador do MurmurHash3) aplicada às chaves antes do sketch.
+ */
+static inline uint64_t hll_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+static inline uint32_t hll_count(const HllSketch *sketch) {
+    return sketch->estimate;
+}
+
+int hll_add(HllSketch *sketch, uint64_t hash);
+void hll_merge(HllSketch *dst, const HllSketch *src);
+void hll_free(HllSketch *sketch);
+size_t hll_heap_bytes(const HllSketch *sketch);
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_IP6_TABLE_H
+#define NETWORK_TRAFFIC_ANALYZER_IP6_TABLE_H
+
+#include <stdint.h>
+#include "ip_table.h"
+
+/**
+ * @struct Ip6Key
+ * @brief Endereço (ou prefixo) IPv6 como dois inteiros de 64 bits.
+ * * hi guarda os bytes 0-7 e lo os bytes 8-15, ambos lidos em big-endian: a
+ * ordem numérica de (hi, lo) é a ordem dos endereços.
+ */
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} Ip6Key;
+
+/**
+ * @struct Ip6Slot
+ * @brief Slot da tabela: chave IPv6, índice no pool e o hash da chave.
+ * * O hash ocupa o preenchimento da struct (24 bytes) e evita recalcular o hash
+ * de 128 bits nas comparações e no backward-shift.
+ */
+typedef struct {
+    Ip6Key key;
+    int32_t value;                      // Índice no pool; IP_TABLE_EMPTY quando livre
+    uint32_t hash;
+} Ip6Slot;
+
+/**
+ * @struct Ip6Table
+ * @brief Variante de IpTable com chaves de 128 bits (mesma sondagem linear e ocupação <= 50%).
+ */
+typedef struct {
+    Ip6Slot *slots;
+    uint32_t mask;                      // capacidade - 1
+    uint32_t count;                     // Slots ocupados
+} Ip6Table;
+
+static inline uint64_t ip6_load64(const uint8_t *bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value = value << 8 | bytes[i];
+    return value;
+}
+
+static inline void ip6_store64(uint8_t *bytes, uint64_t value) {
+    for (int i = 7; i >= 0; i--, value >>= 8) bytes[i] = (uint8_t)value;
+}
+
+/**
+ * @brief Monta a chave a partir dos 16 bytes do endereço (ordem de rede).
+ */
+static inline Ip6Key ip6_key(const uint8_t addr[16]) {
+    return (Ip6Key){ ip6_load64(addr), ip6_load64(addr + 8) };
+}
+
+/**
+ * @brief Mantém só os 'prefix' bits iniciais da chave.
+ * * Com prefix = 64, todos os endereços temporários (RFC 4941) de uma mesma rede
+ * /64 caem na mesma chave.
+ */
+static inline Ip6Key ip6_key_mask(Ip6Key key, unsigned int prefix) {
+    if (prefix <= 64) {
+        key.hi = prefix ? key.hi & ~0ull << (64 - prefix) : 0;
+        key.lo = 0;
+    } else if (prefix < 128) {
+        key.lo &= ~0ull << (128 - prefix);
+    }
+    return key;
+}
+
+static inline void ip6_key_bytes(Ip6Key key, uint8_t addr[16]) {
+    ip6_store64(addr, key.hi);
+    ip6_store64(addr + 8, key.lo);
+}
+
+static inline int ip6_key_equal(Ip6Key a, Ip6Key b) {
+    return a.hi == b.hi && a.lo == b.lo;
+}
+
+/**
+ * @brief Hash de 128 bits -> 32 bits: uma multiplicação por metade e um finalizador.
+ * * Prefixos /64 diferem só em hi e endereços da mesma rede só em lo; a mistura
+ * final espalha as duas metades por todos os bits do resultado.
+ */
+static inline uint32_t ip6_table_hash(Ip6Key key) {
+    uint64_t h = key.hi * 0x9e3779b97f4a7c15ull ^ key.lo * 0xc2b2ae3d27d4eb4full;
+
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ull;
+    h ^= h >> 32;
+    return (uint32_t)h;
+}
+
+static inline void ip6_table_prefetch(const Ip6Table *table, uint32_t hash) {
+    __builtin_prefetch(&table->slots[hash & table->mask], 0);
+}
+
+void ip6_table_init(Ip6Table *table, uint32_t min_capacity);
+void ip6_table_free(Ip6Table *table);
+void ip6_table_clear(Ip6Table *table);
+int32_t ip6_table_find(const Ip6Table *table, Ip6Key key);
+int32_t ip6_table_find_hashed(const Ip6Table *table, Ip6Key key, uint32_t hash);
+void ip6_table_insert(Ip6Table *table, Ip6Key key, int32_t value);
+void ip6_table_update(Ip6Table *table, Ip6Key key, int32_t value);
+void ip6_table_remove(Ip6Table *table, Ip6Key key);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_IP_TABLE_H
+#define NETWORK_TRAFFIC_ANALYZER_IP_TABLE_H
+
+#include <stdint.h>
+
+#define IP_TABLE_EMPTY (-1)     // Valor de um slot livre (a chave 0.0.0.0 é válida)
+
+/**
+ * @struct IpSlot
+ * @brief Slot da tabela: chave IPv4 e índice da entrada no pool do chamador.
+ * * 8 bytes por slot: oito slots por linha de cache de 64 bytes.
+ */
+typedef struct {
+    uint32_t key;                       // Endereço IPv4 (formato de rede)
+    int32_t value;                      // Índice no pool; IP_TABLE_EMPTY quando livre
+} IpSlot;
+
+/**
+ * @struct IpTable
+ * @brief Índice hash de endereçamento aberto (sondagem linear) de IPv4 -> índice.
+ * * A capacidade é sempre potência de dois e a ocupação fica abaixo de 50%, de
+ * modo que as sondagens continuam curtas e contíguas em memória. A remoção usa
+ * backward-shift: não há tombstones, e a tabela não degrada com o churn.
+ */
+typedef struct {
+    IpSlot *slots;
+    uint32_t mask;                      // capacidade - 1
+    uint32_t count;                     // Slots ocupados
+} IpTable;
+
+/**
+ * @brief Hash inteiro do IPv4 (finalizador do MurmurHash3): espalha prefixos
+ * sequenciais, comuns em varreduras e floods, por toda a tabela.
+ */
+static inline uint32_t ip_table_hash(uint32_t key) {
+    key ^= key >> 16;
+    key *= 0x85ebca6bu;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35u;
+    key ^= key >> 16;
+    return key;
+}
+
+/**
+ * @brief Traz para o cache o primeiro slot da sondagem de um hash já calculado.
+ */
+static inline void ip_table_prefetch(const IpTable *table, uint32_t hash) {
+    __builtin_prefetch(&table->slots[hash & table->mask], 0);
+}
+
+void ip_table_init(IpTable *table, uint32_t min_capacity);
+void ip_table_free(IpTable *table);
+void ip_table_clear(IpTable *table);
+int32_t ip_table_find(const IpTable *table, uint32_t key);
+int32_t ip_table_find_hashed(const IpTable *table, uint32_t key, uint32_t hash);
+void ip_table_insert(IpTable *table, uint32_t key, int32_t value);
+void ip_table_update(IpTable *table, uint32_t key, int32_t value);
+void ip_table_remove(IpTable *table, uint32_t key);
+
+#endif
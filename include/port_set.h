@@ -0,0 +1,42 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_PORT_SET_H
+#define NETWORK_TRAFFIC_ANALYZER_PORT_SET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PORT_SET_INLINE     4           // Portas guardadas dentro da própria estrutura
+#define PORT_SET_ARRAY_MAX  64          // Acima disso o vetor ordenado vira bitmap
+#define PORT_SET_WORDS      (65536 / 64) // Bitmap completo: 65536 bits = 8 KiB
+#define PORT_SET_BITMAP     UINT16_MAX  // Valor de capacity que indica o modo bitmap
+
+/**
+ * @struct PortSet
+ * @brief Conjunto adaptativo de portas de destino distintas (16 bytes).
+ * * Começa com até PORT_SET_INLINE portas inline, cresce como vetor ordenado no
+ * heap (busca binária em no máximo PORT_SET_ARRAY_MAX itens) e, a partir daí,
+ * vira um bitmap de 65536 bits com pertinência O(1). A contagem é exata em
+ * todos os modos, então a amplitude de uma varredura pode ser reportada.
+ */
+typedef struct {
+    uint32_t count;                     // Portas distintas registradas
+    uint16_t capacity;                  // 0 = inline; PORT_SET_BITMAP = bitmap; senão, capacidade do vetor
+    uint16_t reserved;
+    union {
+        uint16_t small[PORT_SET_INLINE];
+        uint16_t *array;                // Vetor ordenado (modo intermediário)
+        uint64_t *bitmap;               // PORT_SET_WORDS palavras
+    };
+} PortSet;
+
+static inline uint32_t port_set_count(const PortSet *set) {
+    return set->count;
+}
+
+int port_set_add(PortSet *set, uint16_t port);
+int port_set_contains(const PortSet *set, uint16_t port);
+void port_set_union(PortSet *dst, const PortSet *src);
+uint32_t port_set_difference_count(const PortSet *a, const PortSet *b);
+void port_set_free(PortSet *set);
+size_t port_set_heap_bytes(const PortSet *set);
+
+#endif
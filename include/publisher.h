@@ -1,10 +1,112 @@
 #ifndef  PUBLISHER_H
 #define  PUBLISHER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+// Assinatura sinalizada por um evento (publicada como "scan_type" no JSON)
+typedef enum {
+    SCAN_NONE = 0,          // Tráfego benigno
+    SCAN_PORT,              // Portas distintas acima do limiar (SYN/connect)
+    SCAN_HOST_SWEEP,        // Destinos distintos acima do limiar
+    SCAN_ICMP_FLOOD,        // Taxa ICMP acima do limiar
+    SCAN_NULL,              // TCP sem nenhuma flag
+    SCAN_FIN,               // FIN isolado
+    SCAN_XMAS,              // FIN + PSH + URG
+    SCAN_SYN_FIN,           // SYN e FIN no mesmo segmento
+    SCAN_ACK,               // ACK isolado para muitas portas (mapeamento de firewall)
+    SCAN_SYN_FLOOD,         // Handshakes meio-abertos contra um serviço (destino, porta)
+    SCAN_UDP,               // Portas UDP distintas acima do limiar (Ex: nmap -sU)
+    SCAN_UDP_FLOOD,         // Taxa UDP acima do limiar
+    SCAN_TYPE_COUNT
+} ScanType;
+
+// Encapsulamento removido antes da análise (publicado como "tunnel" no JSON)
+typedef enum {
+    TUNNEL_NONE = 0,        // Pacote analisado como capturado
+    TUNNEL_GRE,             // GRE com carga IP ou Ethernet; tunnel_id = chave GRE (0 sem chave)
+    TUNNEL_VXLAN,           // tunnel_id = VNI
+    TUNNEL_ERSPAN,          // ERSPAN tipos I, II e III sobre GRE; tunnel_id = ID da sessão
+    TUNNEL_TYPE_COUNT
+} TunnelType;
+
+// Evento de telemetria acumulado pelo analisador e publicado em lote
+typedef struct {
+    uint32_t src_ip;        // Endereço de origem (formato de rede)
+    uint32_t dst_ip;        // Endereço de destino (formato de rede; 0 = não se aplica)
+    uint16_t port;          // Porta de destino (0 para ICMP)
+    const char *proto;      // "TCP", "ICMP"...
+    int bytes;              // Tamanho do pacote no fio
+    ScanType scan_type;     // Assinatura que o pacote disparou (SCAN_NONE se benigno)
+    uint32_t scan_ports;    // Portas distintas já varridas pela origem (0 = não se aplica)
+    uint32_t scan_hosts;    // Destinos distintos estimados para a origem (0 = não se aplica)
+    uint8_t ipv6;           // 1 = endereços em src6/dst6 (src_ip/dst_ip ficam sem significado)
+    uint8_t src6[16];       // Origem IPv6 (ordem de rede); prefixo agregado nos relatórios
+    uint8_t dst6[16];       // Destino IPv6 (ordem de rede)
+    uint8_t tunnel;         // TunnelType da camada mais externa removida
+    uint32_t tunnel_id;     // VNI, sessão ERSPAN ou chave GRE
+} IdsEvent;
+
+// Estado TCP de um fluxo no momento da exportação (FLOW_STATE_NONE para UDP/ICMP)
+typedef enum {
+    FLOW_STATE_NONE = 0,
+    FLOW_STATE_SYN_SENT,
+    FLOW_STATE_SYN_RECEIVED,
+    FLOW_STATE_ESTABLISHED,
+    FLOW_STATE_CLOSING,     // FIN visto em um dos sentidos
+    FLOW_STATE_CLOSED,      // FIN visto nos dois sentidos
+    FLOW_STATE_RESET,
+    FLOW_STATE_COUNT
+} FlowState;
+
+// Motivo da exportação de um registro de fluxo
+typedef enum {
+    FLOW_END_IDLE = 0,      // Sem pacotes por --flow-idle
+    FLOW_END_ACTIVE,        // Ativo há mais de --flow-active
+    FLOW_END_FIN,           // Encerrado por FIN nos dois sentidos
+    FLOW_END_RST,           // Encerrado por RST
+    FLOW_END_EVICTED,       // Tabela cheia
+    FLOW_END_SHUTDOWN,      // Fim da captura
+    FLOW_END_COUNT
+} FlowEndReason;
+
+// Registro de um fluxo bidirecional (5-tupla), orientado pelo primeiro pacote visto
+typedef struct {
+    uint32_t src_ip;        // Iniciador (formato de rede)
+    uint32_t dst_ip;        // Respondedor (formato de rede)
+    uint16_t src_port;      // Portas em ordem do host (0 para ICMP)
+    uint16_t dst_port;
+    uint8_t proto;          // IPPROTO_*
+    uint8_t state;          // FlowState
+    uint8_t reason;         // FlowEndReason (preenchido na exportação)
+    uint8_t tcp_flags[2];   // OR das flags TCP por sentido ([0] = iniciador -> respondedor)
+    uint32_t packets[2];    // Por sentido
+    uint64_t bytes[2];      // Por sentido (tamanho no fio)
+    uint64_t first_ns;      // Timestamp do primeiro pacote
+    uint64_t last_ns;       // Timestamp do último pacote
+} FlowRecord;
+
+// Maior emissor de um intervalo segundo uma métrica (resumo top-K)
+typedef struct {
+    uint32_t src_ip;        // Endereço de origem (formato de rede)
+    uint64_t value;         // Estimativa; superestima o valor real em no máximo 'error'
+    uint64_t error;
+} TopTalker;
+
+// Ranking de uma métrica ("bytes", "packets", "ports"), em ordem decrescente
+typedef struct {
+    const char *metric;
+    const TopTalker *talkers;
+    int count;
+} TopTalkerList;
+
 // starta conexao com o rabbit
 
 void init_queue();
 
+// desliga a mensageria (replay/benchmark sem broker)
+void disable_queue();
+
 //Envia o JSON
 static void send_message(const char *message);
 
@@ -12,7 +114,20 @@ static void send_message(const char *message);
 
 void close_queue();
 
-void publish_packet(const char* src_ip, int port, const char* proto, int bytes, int is_scan);
+// nome da assinatura para o console (Ex: "XMAS SCAN") e identificador do JSON (Ex: "xmas")
+const char *scan_type_label(ScanType type);
+const char *scan_type_id(ScanType type);
+
+void publish_packet(const char* src_ip, int port, const char* proto, int bytes, ScanType scan_type);
+
+// publica um lote de eventos do analisador
+void publish_events(const IdsEvent *events, size_t count);
+
+// publica registros de fluxo exportados (uma mensagem por fluxo)
+void publish_flows(const FlowRecord *flows, size_t count);
+
+// publica o resumo periódico de maiores emissores
+void publish_top_talkers(uint64_t ts_ns, unsigned int interval_s, const TopTalkerList *lists, int list_count);
 
 
 
@@ -0,0 +1,72 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_RATE_WINDOW_H
+#define NETWORK_TRAFFIC_ANALYZER_RATE_WINDOW_H
+
+#include <stdint.h>
+
+/**
+ * @struct RateWindow
+ * @brief Contador de janela deslizante (janela corrente + anterior) em 24 bytes.
+ * * O tempo é dividido em janelas fixas de 'width' ns. A taxa nos últimos
+ * 'width' ns é aproximada somando a janela corrente à fração ainda coberta da
+ * anterior, supondo chegadas uniformes dentro dela. Atualizar e consultar
+ * custam O(1) e dependem apenas dos timestamps dos pacotes.
+ */
+typedef struct {
+    uint64_t epoch;                     // Índice da janela corrente (ts / width)
+    uint32_t bytes[2];                  // [0] = janela anterior, [1] = corrente (saturam)
+    uint32_t packets[2];
+} RateWindow;
+
+static inline uint32_t rate_saturating_add(uint32_t value, uint32_t amount) {
+    return value > UINT32_MAX - amount ? UINT32_MAX : value + amount;
+}
+
+/**
+ * @brief Contabiliza um pacote de 'bytes' no instante now (ns).
+ * * Timestamps fora de ordem (anteriores à janela corrente) contam na corrente.
+ */
+static inline void rate_window_add(RateWindow *window, uint64_t now, uint64_t width, uint32_t bytes) {
+    uint64_t epoch = now / width;
+
+    if (epoch > window->epoch) {
+        int adjacent = epoch == window->epoch + 1;
+        window->packets[0] = adjacent ? window->packets[1] : 0;
+        window->bytes[0] = adjacent ? window->bytes[1] : 0;
+        window->packets[1] = 0;
+        window->bytes[1] = 0;
+        window->epoch = epoch;
+    }
+
+    window->packets[1] = rate_saturating_add(window->packets[1], 1);
+    window->bytes[1] = rate_saturating_add(window->bytes[1], bytes);
+}
+
+/**
+ * @brief Estima pacotes e bytes vistos nos últimos 'width' ns até now.
+ */
+static inline void rate_window_count(const RateWindow *window, uint64_t now, uint64_t width,
+                                     uint64_t *packets, uint64_t *bytes) {
+    uint64_t epoch = now / width;
+    if (epoch < window->epoch) epoch = window->epoch;
+
+    if (epoch > window->epoch + 1) {
+        *packets = 0;
+        *bytes = 0;
+        return;
+    }
+
+    // A janela "corrente" do instante now pode já ser a seguinte à última atualizada
+    int advanced = epoch > window->epoch;
+    uint64_t current_packets = advanced ? 0 : window->packets[1];
+    uint64_t current_bytes = advanced ? 0 : window->bytes[1];
+    uint64_t previous_packets = advanced ? window->packets[1] : window->packets[0];
+    uint64_t previous_bytes = advanced ? window->bytes[1] : window->bytes[0];
+
+    // Parcela da janela anterior que ainda cai dentro dos últimos 'width' ns
+    uint64_t remaining = now / width == epoch ? width - now % width : width;
+
+    *packets = current_packets + (uint64_t)((unsigned __int128)previous_packets * remaining / width);
+    *bytes = current_bytes + (uint64_t)((unsigned __int128)previous_bytes * remaining / width);
+}
+
+#endif
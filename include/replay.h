@@ -0,0 +1,19 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_REPLAY_H
+#define NETWORK_TRAFFIC_ANALYZER_REPLAY_H
+
+/**
+ * @struct ReplayConfig
+ * @brief Parâmetros da reanálise offline de capturas pcap/pcapng.
+ */
+typedef struct {
+    const char *path;                   // Arquivo pcap/pcapng ou "-" para stdin
+    double speed;                       // 0 = o mais rápido possível; >0 = multiplicador sobre os timestamps originais
+    const char *filter;                 // Expressão BPF aplicada à leitura (NULL = padrão dos detectores)
+    int burst;                          // Pacotes por lote de análise (1 = caminho por pacote)
+    unsigned int bench_decode;          // > 0: só mede a decodificação (decodificador e kernels), em N passadas (--bench-decode)
+} ReplayConfig;
+
+void start_replay(const ReplayConfig *cfg);
+void stop_replay(void);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_SPACE_SAVING_H
+#define NETWORK_TRAFFIC_ANALYZER_SPACE_SAVING_H
+
+#include <stdint.h>
+#include "ip_table.h"
+
+/**
+ * @struct SpaceSavingEntry
+ * @brief Chave monitorada: count superestima o peso real em no máximo 'error'.
+ */
+typedef struct {
+    uint32_t key;                       // Endereço IPv4 (formato de rede)
+    uint64_t count;
+    uint64_t error;                     // Peso herdado da chave que ocupava o contador
+} SpaceSavingEntry;
+
+/**
+ * @struct SpaceSaving
+ * @brief Resumo Space-Saving (Metwally et al.) com 'capacity' contadores fixos.
+ * * Toda chave com peso acima de total/capacity está garantidamente no resumo.
+ * Os contadores formam um min-heap por count, de modo que a chave substituída
+ * (o mínimo) é encontrada em O(1) e cada atualização custa O(log capacity).
+ */
+typedef struct {
+    SpaceSavingEntry *heap;
+    IpTable index;                      // Chave -> posição no heap
+    int size;
+    int capacity;
+} SpaceSaving;
+
+void space_saving_init(SpaceSaving *summary, int capacity);
+void space_saving_free(SpaceSaving *summary);
+void space_saving_clear(SpaceSaving *summary);
+void space_saving_add(SpaceSaving *summary, uint32_t key, uint64_t weight);
+int space_saving_top(const SpaceSaving *summary, SpaceSavingEntry *out, int k);
+
+#endif
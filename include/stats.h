@@ -0,0 +1,44 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_STATS_H
+#define NETWORK_TRAFFIC_ANALYZER_STATS_H
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @struct StageStats
+ * @brief Tempo acumulado (ns) por estágio do pipeline, usado nos relatórios de benchmark.
+ */
+typedef struct {
+    uint64_t read_ns;                   // Leitura do pacote (pcap_next_ex / anel)
+    uint64_t analyze_ns;                // analyze_packet() completo, incluindo a publicação
+    uint64_t publish_ns;                // Serialização + envio AMQP (subconjunto de analyze_ns)
+    uint64_t published;                 // Mensagens publicadas
+} StageStats;
+
+// Contadores da thread corrente; só são alimentados quando stage_timing_enabled != 0
+extern _Thread_local StageStats stage_stats;
+extern int stage_timing_enabled;
+
+#define NSEC_PER_SEC 1000000000ull
+
+/**
+ * @brief Relógio monotônico em nanossegundos para medição de estágios.
+ */
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Relógio de parede grosso (resolução do tick, ~1-4 ms) em nanossegundos.
+ * * CLOCK_REALTIME_COARSE é servido pelo vDSO a partir do último tick, sem
+ * syscall. Usado quando o backend não fornece o timestamp do pacote.
+ */
+static inline uint64_t coarse_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_TIMING_WHEEL_H
+#define NETWORK_TRAFFIC_ANALYZER_TIMING_WHEEL_H
+
+#include <stdint.h>
+
+/* Geometria da roda: 3 níveis de 64 slots; o tick é 2^27 ns (~134 ms) */
+#define WHEEL_BITS       6
+#define WHEEL_SLOTS      (1 << WHEEL_BITS)
+#define WHEEL_LEVELS     3
+#define WHEEL_TICK_SHIFT 27             // Nível 0 cobre ~8,6 s, nível 1 ~9 min, nível 2 ~9,8 h
+
+#define WHEEL_NONE (-1)
+
+/**
+ * @struct WheelLink
+ * @brief Encadeamento de uma entrada na roda, indexado pela posição no pool do chamador.
+ */
+typedef struct {
+    int32_t prev;                       // Entrada anterior no slot (WHEEL_NONE = cabeça)
+    int32_t next;                       // Próxima entrada no slot (WHEEL_NONE = cauda)
+    int32_t bucket;                     // nível * WHEEL_SLOTS + slot; WHEEL_NONE = fora da roda
+    uint64_t deadline;                  // Tick de expiração
+} WheelLink;
+
+/**
+ * @struct TimingWheel
+ * @brief Roda de temporização hierárquica guiada pelos timestamps dos pacotes.
+ * * As listas são intrusivas por índice: links[i] pertence à entrada i do pool
+ * do chamador, então agendar, cancelar e mover custam O(1) sem alocação.
+ */
+typedef struct {
+    int32_t heads[WHEEL_LEVELS][WHEEL_SLOTS];
+    uint64_t occupied[WHEEL_LEVELS];    // Bit s ligado quando o slot s do nível tem entradas
+    WheelLink *links;
+    uint64_t current;                   // Tick corrente (slots anteriores já foram drenados)
+    int count;                          // Entradas agendadas
+} TimingWheel;
+
+static inline uint64_t wheel_tick(uint64_t ns) {
+    return ns >> WHEEL_TICK_SHIFT;
+}
+
+void timing_wheel_init(TimingWheel *wheel, int capacity);
+void timing_wheel_free(TimingWheel *wheel);
+void timing_wheel_schedule(TimingWheel *wheel, int32_t id, uint64_t deadline_ns);
+void timing_wheel_cancel(TimingWheel *wheel, int32_t id);
+void timing_wheel_move(TimingWheel *wheel, int32_t from, int32_t to);
+int32_t timing_wheel_expire(TimingWheel *wheel, uint64_t now_ns);
+
+#endif
@@ -1,146 +1,2257 @@
+#include <net/ethernet.h>
 #include <netinet/ip.h>
+#include <netinet/ip6.h>
 #include <netinet/tcp.h>
 #include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
 #include <arpa/inet.h>
 #include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "../include/analyzer.h"
 #include "../include/publisher.h"
+#include "../include/stats.h"
+#include "../include/ip_table.h"
+#include "../include/ip6_table.h"
+#include "../include/timing_wheel.h"
+#include "../include/port_set.h"
+#include "../include/hll.h"
+#include "../include/rate_window.h"
+#include "../include/count_min.h"
+#include "../include/space_saving.h"
+#include "../include/handshake.h"
+#include "../include/flow_table.h"
+#include "../include/header_kernel.h"
 
 /* Configurações e limites operacionais do IDS */
-#define MAX_SUSPECTS 100       // Quantidade máxima de IPs rastreados simultaneamente
-#define SCAN_THRESHOLD 15      // Quantidade de portas distintas para classificar um TCP Port Scan
-#define ICMP_THRESHOLD 20      // Máximo de pacotes ICMP por IP antes de alertar um Flood
-#define CLEANUP_INTERVAL 60    // Intervalo mínimo (em segundos) entre as execuções da limpeza
-#define INACTIVE_TIMEOUT 300   // Tempo (em segundos) de inatividade para um IP ser esquecido
+#define MAX_SUSPECTS 100       // Capacidade inicial do modo forense (cresce sob demanda)
+#define INACTIVE_TIMEOUT (300 * NSEC_PER_SEC)   // Tempo de inatividade para um IP ser esquecido
+#define EXPIRE_BUDGET 16       // Máximo de entradas da roda processadas por pacote
+
+/* Política de despejo do rastreador ao vivo (CLOCK com créditos) */
+#define CREDIT_MAX 3           // Créditos acumulados por hits recentes (protegem a entrada)
+#define EVICT_SCAN 8           // Entradas examinadas pelo ponteiro do relógio a cada despejo
+#define SCORE_MAX 16           // Score de uma origem que atingiu o limiar de algum detector
+
+/* Estágio de admissão (Count-Min Sketch) à frente do rastreador ao vivo */
+#define ADMISSION_WINDOW (1 * NSEC_PER_SEC)     // Rotação das gerações do sketch
+#define ADMISSION_OCCUPANCY 2                   // Filtra quando o pool passa de 1/2 da capacidade
+
+/* Detectores UDP: janela das taxas do flood e portas de cliente */
+#define UDP_WINDOW (1 * NSEC_PER_SEC)
+#define UDP_EPHEMERAL_MIN 1024  // Portas a partir daqui são tratadas como efêmeras (lado cliente)
+
+/* Resumo periódico de maiores emissores (Space-Saving) */
+#define TOPK_COUNTERS_PER_ENTRY 8               // Contadores monitorados por posição do ranking
+
+enum { TOP_BYTES, TOP_PACKETS, TOP_PORTS, TOP_METRICS };
+static const char *const top_metric_names[TOP_METRICS] = { "bytes", "packets", "ports" };
+
+/* ========================================================================= *
+ * CLASSIFICAÇÃO DAS FLAGS TCP (STEALTH SCANS)                               *
+ * ========================================================================= *
+ * Uma tabela de 256 entradas, indexada pelo byte de flags, dá a classe de   *
+ * cada segmento com um único acesso à memória. As decisões ficam todas na   *
+ * geração da tabela, em tempo de compilação; ECE e CWR (ECN) são ignoradas. */
+enum {
+    STEALTH_NONE,                       // Combinação usual (SYN, SYN/ACK, ACK com dados, FIN/ACK...)
+    STEALTH_NULL,                       // Nenhuma flag
+    STEALTH_FIN,                        // FIN isolado
+    STEALTH_XMAS,                       // FIN + PSH + URG sem ACK
+    STEALTH_SYN_FIN,                    // SYN e FIN juntos
+    STEALTH_ACK,                        // ACK isolado (só é suspeito em muitas portas)
+    STEALTH_CLASSES
+};
+
+#define TCP_FLAG_BITS(f) ((f) & (TH_FIN | TH_SYN | TH_RST | TH_PUSH | TH_ACK | TH_URG))
+#define TCP_FLAG_CLASS(f) \
+    (TCP_FLAG_BITS(f) == 0 ? STEALTH_NULL : \
+     TCP_FLAG_BITS(f) == TH_FIN ? STEALTH_FIN : \
+     ((f) & (TH_FIN | TH_PUSH | TH_URG | TH_ACK)) == (TH_FIN | TH_PUSH | TH_URG) ? STEALTH_XMAS : \
+     ((f) & (TH_SYN | TH_FIN)) == (TH_SYN | TH_FIN) ? STEALTH_SYN_FIN : \
+     TCP_FLAG_BITS(f) == TH_ACK ? STEALTH_ACK : STEALTH_NONE)
+
+#define TCP_FLAG_CLASS_4(f)  TCP_FLAG_CLASS(f), TCP_FLAG_CLASS((f) + 1), TCP_FLAG_CLASS((f) + 2), TCP_FLAG_CLASS((f) + 3)
+#define TCP_FLAG_CLASS_16(f) TCP_FLAG_CLASS_4(f), TCP_FLAG_CLASS_4((f) + 4), TCP_FLAG_CLASS_4((f) + 8), TCP_FLAG_CLASS_4((f) + 12)
+#define TCP_FLAG_CLASS_64(f) TCP_FLAG_CLASS_16(f), TCP_FLAG_CLASS_16((f) + 16), TCP_FLAG_CLASS_16((f) + 32), TCP_FLAG_CLASS_16((f) + 48)
+
+static const uint8_t tcp_flag_class[256] = {
+    TCP_FLAG_CLASS_64(0), TCP_FLAG_CLASS_64(64), TCP_FLAG_CLASS_64(128), TCP_FLAG_CLASS_64(192)
+};
+
+// Assinatura publicada para cada classe
+static const ScanType stealth_scan_type[STEALTH_CLASSES] = {
+    SCAN_NONE, SCAN_NULL, SCAN_FIN, SCAN_XMAS, SCAN_SYN_FIN, SCAN_ACK
+};
+
+/* Bytes de cabeçalho que cada detector precisa enxergar (dimensionam o snaplen) */
+#define ETH_HEADER_LEN 14      // Cabeçalho Ethernet sem VLAN
+#define VLAN_HEADROOM 8        // Folga para até duas tags 802.1Q/802.1ad
+#define SLL2_HEADER_LEN 20     // Maior cabeçalho de enlace suportado (Linux cooked v2)
+#define TUNNEL_HEADROOM (GRE_MAX_HEADER + ERSPAN3_HEADER_LEN + ERSPAN3_PLATFORM_LEN + ETH_HEADER_LEN + VLAN_HEADROOM)  // Por nível, além do IP externo
+#define IP_MAX_HEADER 60       // IPv4 com o máximo de opções (ip_hl = 15)
+#define UDP_PORTS_END 4        // Portas de origem e destino do datagrama UDP
+#define TCP_MIN_HEADER 20      // Portas + flags; opções TCP não são inspecionadas
+#define TCP_FLAGS_END 14       // Bytes do cabeçalho TCP até o byte de flags, inclusive
+#define ICMP_MIN_HEADER 8      // Tipo, código, checksum e identificador
+#define ICMP_QUOTE_END (ICMP_MIN_HEADER + 20)  // Até o fim do cabeçalho IPv4 citado por um erro ICMP
+#define IPV6_HEADROOM 64       // Cabeçalho IPv6 fixo (40) + folga para extensões curtas (Ex: hop-by-hop e fragmento)
+#define ICMP6_QUOTE_END (ICMP_MIN_HEADER + 40) // Até o fim do cabeçalho IPv6 citado por um erro ICMPv6
+
+/* Cadeia de cabeçalhos de extensão IPv6 percorrida pelo decodificador */
+#define IPV6_MAX_EXTENSIONS 8  // Cadeias mais longas são descartadas (não há uso legítimo)
+
+/* Cabeçalhos de rede lidos pelo decodificador */
+#define IPV4_HEADER_LEN 20     // Cabeçalho IPv4 sem opções
+#define IPV6_HEADER_LEN 40     // Cabeçalho IPv6 fixo
+#define IPV6_FRAGMENT_LEN 8    // Cabeçalho de extensão de fragmento
+#define IPV6_FRAGMENT_OFFSET 0xfff8     // Offset do fragmento (bytes 2-3, ordem do host)
+#define DECODE_MAX_OFFSET UINT16_MAX    // Offsets do descritor são de 16 bits
+#define KERNEL_BACKOFF 16      // Trechos de HEADER_KERNEL_MAX pacotes sem kernel após um trecho sem nenhum acerto
+
+/* Cabeçalhos de enlace reconhecidos pelos decodificadores especializados */
+#define VLAN_TAG_LEN 4         // TCI (2) + EtherType encapsulado (2)
+#define VLAN_MAX_TAGS 2        // Tags empilhadas aceitas (Ex: 802.1Q sob 802.1ad); cabem no VLAN_HEADROOM
+#define SLL_HEADER_LEN 16      // Linux cooked v1 ("any"): protocolo nos bytes 14-15
+#define NULL_HEADER_LEN 4      // Loopback BSD: família do endereço (DLT_NULL na ordem do host, DLT_LOOP na de rede)
+#define ETHERTYPE_8021AD 0x88a8         // Tag de serviço 802.1ad (QinQ)
+#define ETHERTYPE_QINQ_LEGACY 0x9100    // Tag externa de QinQ pré-padrão
+
+/* Túneis removidos antes da detecção (espelhamento em nuvem) */
+#define TUNNEL_DEPTH_MAX 4     // Teto de --tunnel-depth
+#define VXLAN_PORT 4789        // Porta UDP de destino do VXLAN (RFC 7348)
+#define VXLAN_HEADER_LEN 8     // Flags (I = VNI válido), reservado, VNI de 24 bits
+#define VXLAN_FLAG_VNI 0x08
+#define UDP_HEADER_LEN 8
+#define GRE_HEADER_LEN 4       // Flags/versão + protocolo; checksum, chave e sequência são opcionais
+#define GRE_FLAG_CHECKSUM 0x80
+#define GRE_FLAG_ROUTING 0x40
+#define GRE_FLAG_KEY 0x20
+#define GRE_FLAG_SEQUENCE 0x10
+#define GRE_VERSION_MASK 0x07
+#define GRE_MAX_HEADER 16      // Cabeçalho base com checksum, chave e sequência
+#define ERSPAN2_HEADER_LEN 8   // ERSPAN tipo II (versão 1)
+#define ERSPAN3_HEADER_LEN 12  // ERSPAN tipo III (versão 2), sem o sub-cabeçalho de plataforma
+#define ERSPAN3_PLATFORM_LEN 8 // Sub-cabeçalho opcional do tipo III (bit O)
+#define ETHERTYPE_TEB 0x6558            // Transparent Ethernet Bridging (NVGRE, GRE em modo gretap)
+#define ETHERTYPE_ERSPAN 0x88be         // ERSPAN tipos I e II
+#define ETHERTYPE_ERSPAN3 0x22eb        // ERSPAN tipo III
+#define DECAP_NONE -1          // A carga não é um túnel suportado: o pacote externo segue para os detectores
+
+// O lote da libpcap (BATCH_SLOT_SIZE) copia REQUIRED_SNAPLEN_MAX bytes: o pior caso de required_snaplen() tem de caber
+_Static_assert(SLL2_HEADER_LEN + VLAN_HEADROOM + TUNNEL_DEPTH_MAX * (IPV6_HEADROOM + TUNNEL_HEADROOM) + IPV6_HEADROOM + ICMP6_QUOTE_END
+               <= REQUIRED_SNAPLEN_MAX, "REQUIRED_SNAPLEN_MAX menor que o maior snaplen exigido pelos detectores");
+
+// Decodificador do tipo de enlace da captura, escolhido uma vez por set_shard_datalink()
+typedef int (*LinkDecoder)(const u_char *packet, int caplen, int length, DecodedPacket *out);
+
+/**
+ * @struct AckPorts
+ * @brief Portas TCP de uma origem separadas pelo tipo de segmento (somente modo forense).
+ * * Ao vivo, um ACK isolado conta quando abre uma porta nova; essa ordem não
+ * sobrevive à mesclagem, já que cada shard vê uma parte diferente das capturas.
+ * No modo forense o ACK scan sai de conjuntos, cuja união independe da
+ * partição: conta a porta que recebeu ACKs isolados e nenhum outro segmento.
+ */
+typedef struct {
+    PortSet lone;                       // Portas que receberam um ACK isolado
+    PortSet other;                      // Portas que receberam qualquer outro segmento (SYN, dados, FIN...)
+} AckPorts;
+
+/**
+ * @struct Suspect
+ * @brief Estrutura responsável por rastrear as métricas comportamentais de um IP de origem.
+ */
+typedef struct {
+    uint32_t ip;                        // Endereço IP de origem (formato de rede); hash de ip6 nas origens IPv6
+    Ip6Key ip6;                         // Prefixo IPv6 de origem (--ipv6-prefix bits iniciais)
+    uint8_t ipv6;                       // 1 = origem identificada por ip6 (índice index6)
+    uint8_t credit;                     // Créditos do CLOCK (hits desde a última passada do ponteiro)
+    PortSet ports;                      // Portas de destino distintas (contagem exata = amplitude da varredura)
+    HllSketch hosts;                    // Estimativa de destinos distintos (varredura horizontal)
+    RateWindow icmp;                    // Pacotes/bytes ICMP na janela deslizante
+    uint32_t icmp_peak_pps;             // Maior taxa ICMP observada (pacotes/s)
+    uint32_t icmp_peak_bps;             // Maior taxa ICMP observada (bytes/s)
+    PortSet udp_ports;                  // Portas UDP de destino distintas
+    RateWindow udp;                     // Pacotes/bytes UDP na janela deslizante
+    uint32_t udp_peak_pps;              // Maior taxa UDP observada (pacotes/s)
+    uint32_t udp_peak_bps;              // Maior taxa UDP observada (bytes/s)
+    uint16_t unreachable;               // ICMP port-unreachable devolvidos à origem por datagramas UDP (satura)
+    uint16_t stealth[STEALTH_CLASSES];  // Segmentos TCP por classe de flags (saturam; [0] = usuais, ACK = portas novas)
+    AckPorts *ack_ports;                // Portas do ACK scan no modo forense (NULL ao vivo e até o primeiro segmento)
+    uint64_t last_seen;                 // Timestamp (ns) do último pacote recebido deste IP
+} Suspect;
+
+/**
+ * @struct IdsShard
+ * @brief Fatia independente do estado do IDS.
+ * * No modo multi-worker cada thread possui o seu próprio shard; como o fanout do
+ * kernel entrega todos os pacotes de uma origem ao mesmo worker, nenhum lock é
+ * necessário no caminho quente. No modo forense (batch) o shard cresce sem limite,
+ * não expira entradas e não publica eventos: o veredito sai do estado mesclado.
+ * * No modo ao vivo o pool e o índice são alocados uma única vez a partir do
+ * orçamento de memória; com a tabela cheia, uma nova origem despeja outra.
+ */
+struct IdsShard {
+    Suspect *suspects;                  // Pool denso de entradas (sem buracos)
+    int suspect_count;
+    int capacity;
+    LinkDecoder decode;                 // Decodificador do tipo de enlace da captura (padrão: Ethernet)
+    HeaderKernel kernel;                // Caminho rápido do lote (HEADER_KERNEL_NONE fora do Ethernet)
+    unsigned int kernel_backoff;        // Trechos do lote que ainda pulam o kernel (ver decode_batch)
+    IpTable index;                      // IP de origem -> posição no pool
+    Ip6Table index6;                    // Prefixo IPv6 de origem -> posição no pool (slots NULL sem IPv6)
+    ShardMode mode;
+    TimingWheel expiry;                 // Prazos de inatividade (somente no modo ao vivo)
+    CountMinSketch admission;           // Pacotes por (origem, protocolo) ainda não rastreados (ao vivo)
+    HandshakeTable handshakes;          // SYNs pendentes e taxas por serviço (ao vivo)
+    SpaceSaving top[TOP_METRICS];       // Maiores emissores do intervalo corrente (ao vivo)
+    uint64_t top_deadline;              // Fim do intervalo corrente (ns); 0 = ainda não iniciado
+    FlowTable flows;                    // Fluxos bidirecionais em andamento (ao vivo)
+    int clock_hand;                     // Próxima entrada examinada pelo despejo
+    unsigned int generation;            // Incrementado a cada remoção (invalida índices)
+    unsigned long long evictions;
+    unsigned long long evictions_pressure;
+    unsigned long long evictions_suspects;
+    unsigned long long expirations;
+    unsigned long long admission_held;  // Pacotes de origens retidas no sketch (sem estado exato)
+    unsigned long long admission_promoted;
+    size_t set_bytes;                   // Heap ocupado pelos conjuntos de portas e sketches promovidos
+    uint64_t *audit_pairs;              // Pares (origem, destino) exatos para --sketch-audit (modo forense)
+    size_t audit_count;
+    size_t audit_capacity;
+};
+
+// Detectores ativos; definido na inicialização e somente lido pelas threads
+static unsigned int enabled_detectors = DETECT_ALL;
+
+// Portas distintas que caracterizam uma varredura (--scan-threshold)
+static unsigned int scan_threshold = SCAN_THRESHOLD;
+
+// Segmentos com flags anômalas (NULL, FIN, Xmas, SYN/FIN) que caracterizam um stealth scan (--stealth-threshold)
+static unsigned int stealth_threshold = STEALTH_THRESHOLD;
+
+// Destinos distintos (estimados) que caracterizam uma varredura horizontal (--sweep-threshold)
+static unsigned int sweep_threshold = SWEEP_THRESHOLD;
+
+// Portas UDP distintas de um UDP scan e port-unreachables que confirmam a sondagem (--udp-scan-threshold, --udp-unreach)
+static unsigned int udp_scan_threshold = UDP_SCAN_THRESHOLD;
+static unsigned int udp_unreach_confirm = UDP_UNREACH_CONFIRM;
+
+// Limiares do detector de UDP flood (--udp-pps, --udp-bps)
+static unsigned int udp_pps_threshold = UDP_PPS_THRESHOLD;
+static unsigned int udp_bps_threshold = UDP_BPS_THRESHOLD;
+
+// Limiares e largura da janela do detector de ICMP flood (--icmp-pps, --icmp-bps, --icmp-window)
+static unsigned int icmp_pps_threshold = ICMP_PPS_THRESHOLD;
+static unsigned int icmp_bps_threshold = ICMP_BPS_THRESHOLD;
+static uint64_t icmp_window_ns = (uint64_t)ICMP_WINDOW_MS * 1000000;
+
+// Handshakes meio-abertos por segundo e razão SYN/SYN-ACK que caracterizam um SYN flood (--synflood-rate, --synflood-ratio)
+static unsigned int synflood_rate = SYNFLOOD_RATE;
+static unsigned int synflood_ratio = SYNFLOOD_RATIO;
+
+// Pacotes de uma origem nova, acima do ruído do sketch, antes da promoção (--promote-threshold)
+static unsigned int promote_threshold = PROMOTE_THRESHOLD;
+
+// Tamanho dos rankings e duração do intervalo do resumo top-K (--top-k, --top-interval)
+static unsigned int topk_size = TOPK_SIZE;
+static uint64_t topk_interval_ns = (uint64_t)TOPK_INTERVAL_S * NSEC_PER_SEC;
+
+// Guarda os pares exatos no modo forense para medir o erro do sketch (--sketch-audit)
+static int sketch_audit = 0;
+
+// Orçamento de memória (bytes) do rastreador ao vivo, repartido entre os workers
+static size_t tracker_budget = (size_t)TRACKER_BUDGET_MB << 20;
+
+// Orçamento (bytes, repartido como o do rastreador) e prazos da tabela de fluxos (--flow-mb, --flow-idle, --flow-active)
+static size_t flow_budget = (size_t)FLOW_TABLE_MB << 20;
+static uint64_t flow_idle_ns = (uint64_t)FLOW_IDLE_S * NSEC_PER_SEC;
+static uint64_t flow_active_ns = (uint64_t)FLOW_ACTIVE_S * NSEC_PER_SEC;
+
+// Bits do endereço IPv6 que identificam uma origem (--ipv6-prefix; 0 descarta o IPv6)
+static unsigned int ipv6_prefix = IPV6_PREFIX;
+
+// Túneis aninhados removidos pelo decodificador (--tunnel-depth; 0 analisa o pacote externo)
+static unsigned int tunnel_depth = TUNNEL_DEPTH;
+
+// Shard padrão utilizado pelo modo single-thread (analyze_packet), criado no primeiro uso
+static IdsShard *default_shard = NULL;
+
+void set_enabled_detectors(unsigned int mask) {
+    enabled_detectors = mask;
+}
+
+unsigned int get_enabled_detectors(void) {
+    return enabled_detectors;
+}
+
+void set_scan_threshold(unsigned int ports) {
+    scan_threshold = ports > 0 ? ports : 1;
+}
+
+void set_stealth_threshold(unsigned int segments) {
+    stealth_threshold = segments > 0 ? segments : 1;
+}
+
+void set_sweep_threshold(unsigned int hosts) {
+    sweep_threshold = hosts > 0 ? hosts : 1;
+}
+
+void set_udp_scan_threshold(unsigned int ports) {
+    udp_scan_threshold = ports > 0 ? ports : 1;
+}
+
+void set_udp_unreach_confirm(unsigned int replies) {
+    udp_unreach_confirm = replies > 0 ? replies : 1;
+}
+
+void set_udp_pps_threshold(unsigned int pps) {
+    udp_pps_threshold = pps > 0 ? pps : 1;
+}
+
+void set_udp_bps_threshold(unsigned int bps) {
+    udp_bps_threshold = bps > 0 ? bps : 1;
+}
+
+void set_icmp_pps_threshold(unsigned int pps) {
+    icmp_pps_threshold = pps > 0 ? pps : 1;
+}
+
+void set_icmp_bps_threshold(unsigned int bps) {
+    icmp_bps_threshold = bps > 0 ? bps : 1;
+}
+
+void set_icmp_window(unsigned int ms) {
+    icmp_window_ns = (uint64_t)(ms > 0 ? ms : 1) * 1000000;
+}
+
+void set_synflood_rate(unsigned int half_open) {
+    synflood_rate = half_open > 0 ? half_open : 1;
+}
+
+void set_synflood_ratio(unsigned int ratio) {
+    synflood_ratio = ratio > 0 ? ratio : 1;
+}
+
+void set_promote_threshold(unsigned int packets) {
+    promote_threshold = packets;
+}
+
+void set_topk_size(unsigned int k) {
+    topk_size = k;
+}
+
+void set_topk_interval(unsigned int seconds) {
+    topk_interval_ns = (uint64_t)(seconds > 0 ? seconds : 1) * NSEC_PER_SEC;
+}
+
+void set_sketch_audit(int enabled) {
+    sketch_audit = enabled;
+}
+
+void set_tracker_budget(size_t bytes) {
+    tracker_budget = bytes;
+}
+
+size_t get_tracker_budget(void) {
+    return tracker_budget;
+}
+
+void set_flow_budget(size_t bytes) {
+    flow_budget = bytes;
+}
+
+size_t get_flow_budget(void) {
+    return flow_budget;
+}
+
+void set_flow_idle(unsigned int seconds) {
+    flow_idle_ns = (uint64_t)(seconds > 0 ? seconds : 1) * NSEC_PER_SEC;
+}
+
+void set_flow_active(unsigned int seconds) {
+    flow_active_ns = (uint64_t)(seconds > 0 ? seconds : 1) * NSEC_PER_SEC;
+}
+
+void set_ipv6_prefix(unsigned int bits) {
+    ipv6_prefix = bits > 128 ? 128 : bits;
+}
+
+unsigned int get_ipv6_prefix(void) {
+    return ipv6_prefix;
+}
+
+void set_tunnel_depth(unsigned int levels) {
+    tunnel_depth = levels > TUNNEL_DEPTH_MAX ? TUNNEL_DEPTH_MAX : levels;
+}
+
+unsigned int get_tunnel_depth(void) {
+    return tunnel_depth;
+}
+
+/**
+ * @brief Indica se o estágio de admissão está ligado (--promote-threshold > 1).
+ */
+static int admission_enabled(void) {
+    return promote_threshold > 1;
+}
+
+/**
+ * @brief Indica se o detector de SYN flood (tabela de handshakes) está ligado.
+ */
+static int handshakes_enabled(void) {
+    return (enabled_detectors & DETECT_SYN_FLOOD) != 0;
+}
+
+/**
+ * @brief Maior capacidade cujo pool + índices (ocupação <= 50%) + roda cabe no orçamento.
+ * * O índice tem tamanho potência de dois; a capacidade é metade dele, então a
+ * tabela nunca cresce depois de criada e o consumo de memória fica constante.
+ * Com o IPv6 ligado, o índice de prefixos é dimensionado para o pool inteiro,
+ * já que qualquer mistura de origens IPv4 e IPv6 precisa caber.
+ * O sketch de admissão e a tabela de handshakes, quando ligados, saem do mesmo orçamento.
+ */
+static int capacity_for_budget(size_t budget) {
+    size_t slots = 16;
+    size_t slot_bytes = sizeof(IpSlot) + (ipv6_prefix > 0 ? sizeof(Ip6Slot) : 0);
+
+    if (admission_enabled() && budget > 2 * count_min_bytes()) budget -= count_min_bytes();
+    if (handshakes_enabled() && budget > 2 * handshake_bytes()) budget -= handshake_bytes();
+    while ((slots * 2) * slot_bytes + slots * (sizeof(Suspect) + sizeof(WheelLink)) <= budget) slots *= 2;
+    return (int)(slots / 2);
+}
+
+static int decode_ethernet(const u_char *packet, int caplen, int length, DecodedPacket *out);
+
+/**
+ * @brief Aloca um shard de estado zerado para um worker de captura ou de batch.
+ * * @param mode SHARD_LIVE (capacidade fixa, expiração, publicação) ou SHARD_FORENSIC.
+ * @param memory_budget Bytes reservados ao rastreador ao vivo (ignorado no modo forense).
+ */
+IdsShard *create_ids_shard(ShardMode mode, size_t memory_budget) {
+    IdsShard *shard = calloc(1, sizeof(IdsShard));
+    shard->mode = mode;
+    shard->decode = decode_ethernet;
+    shard->kernel = header_kernel_detect();
+    shard->capacity = mode == SHARD_LIVE ? capacity_for_budget(memory_budget) : MAX_SUSPECTS;
+    shard->suspects = calloc((size_t)shard->capacity, sizeof(Suspect));
+    ip_table_init(&shard->index, (uint32_t)shard->capacity);
+    if (ipv6_prefix > 0) ip6_table_init(&shard->index6, (uint32_t)shard->capacity);
+    if (mode == SHARD_LIVE) timing_wheel_init(&shard->expiry, shard->capacity);
+    if (mode == SHARD_LIVE && admission_enabled()) count_min_init(&shard->admission, ADMISSION_WINDOW);
+    if (mode == SHARD_LIVE && handshakes_enabled()) handshake_init(&shard->handshakes);
+    if (mode == SHARD_LIVE && topk_size > 0) {
+        for (int m = 0; m < TOP_METRICS; m++) {
+            space_saving_init(&shard->top[m], (int)topk_size * TOPK_COUNTERS_PER_ENTRY);
+        }
+    }
+    // A tabela de fluxos recebe a mesma fração do seu orçamento que o shard recebeu do rastreador
+    if (mode == SHARD_LIVE && flow_budget > 0) {
+        size_t share = tracker_budget > 0 ? (size_t)((double)flow_budget * memory_budget / tracker_budget) : flow_budget;
+        flow_table_init(&shard->flows, share, flow_idle_ns, flow_active_ns, publish_flows);
+    }
+    return shard;
+}
+
+/**
+ * @brief Libera os conjuntos do ACK scan de uma origem (modo forense).
+ */
+static void free_ack_ports(Suspect *suspect) {
+    if (suspect->ack_ports == NULL) return;
+
+    port_set_free(&suspect->ack_ports->lone);
+    port_set_free(&suspect->ack_ports->other);
+    free(suspect->ack_ports);
+    suspect->ack_ports = NULL;
+}
+
+void destroy_ids_shard(IdsShard *shard) {
+    for (int i = 0; i < shard->suspect_count; i++) {
+        port_set_free(&shard->suspects[i].ports);
+        port_set_free(&shard->suspects[i].udp_ports);
+        hll_free(&shard->suspects[i].hosts);
+        free_ack_ports(&shard->suspects[i]);
+    }
+    free(shard->suspects);
+    free(shard->audit_pairs);
+    ip_table_free(&shard->index);
+    ip6_table_free(&shard->index6);
+    if (shard->mode == SHARD_LIVE) timing_wheel_free(&shard->expiry);
+    count_min_free(&shard->admission);
+    handshake_free(&shard->handshakes);
+    for (int m = 0; m < TOP_METRICS; m++) {
+        if (shard->top[m].heap != NULL) space_saving_free(&shard->top[m]);
+    }
+    if (shard->flows.flows != NULL) flow_table_free(&shard->flows);
+    free(shard);
+}
+
+/**
+ * @brief Insere a entrada 'index' do pool no índice da sua família (IPv4 ou prefixo IPv6).
+ */
+static void index_suspect(IdsShard *shard, int index) {
+    const Suspect *suspect = &shard->suspects[index];
+
+    if (suspect->ipv6) {
+        ip6_table_insert(&shard->index6, suspect->ip6, index);
+    } else {
+        ip_table_insert(&shard->index, suspect->ip, index);
+    }
+}
+
+/**
+ * @brief Remove a entrada do índice e do pool, movendo a última entrada para o buraco.
+ */
+static void remove_suspect(IdsShard *shard, int index) {
+    int last = --shard->suspect_count;
+
+    shard->generation++;
+    shard->set_bytes -= port_set_heap_bytes(&shard->suspects[index].ports)
+                      + port_set_heap_bytes(&shard->suspects[index].udp_ports)
+                      + hll_heap_bytes(&shard->suspects[index].hosts);
+    port_set_free(&shard->suspects[index].ports);
+    port_set_free(&shard->suspects[index].udp_ports);
+    hll_free(&shard->suspects[index].hosts);
+    free_ack_ports(&shard->suspects[index]);
+    if (shard->suspects[index].ipv6) {
+        ip6_table_remove(&shard->index6, shard->suspects[index].ip6);
+    } else {
+        ip_table_remove(&shard->index, shard->suspects[index].ip);
+    }
+    if (shard->mode == SHARD_LIVE) timing_wheel_cancel(&shard->expiry, index);
+
+    if (index != last) {
+        shard->suspects[index] = shard->suspects[last];
+        if (shard->suspects[index].ipv6) {
+            ip6_table_update(&shard->index6, shard->suspects[index].ip6, index);
+        } else {
+            ip_table_update(&shard->index, shard->suspects[index].ip, index);
+        }
+        if (shard->mode == SHARD_LIVE) timing_wheel_move(&shard->expiry, last, index);
+    }
+}
+
+/**
+ * @brief Reconstrói o índice depois de o pool ser reordenado (mesclagem/relatório).
+ */
+static void reindex_suspects(IdsShard *shard) {
+    ip_table_clear(&shard->index);
+    if (shard->index6.slots != NULL) ip6_table_clear(&shard->index6);
+    for (int i = 0; i < shard->suspect_count; i++) {
+        index_suspect(shard, i);
+    }
+}
+
+/**
+ * @brief Esquece os IPs inativos cujo prazo chegou, sem varrer a tabela.
+ * * Cada entrada ao vivo tem um prazo na roda de temporização. Como last_seen
+ * muda a cada pacote, o prazo não é reagendado no caminho quente: quando ele
+ * vence, a entrada é reavaliada e, se ainda estiver ativa, volta para a roda
+ * com o novo prazo (last_seen + INACTIVE_TIMEOUT). No máximo EXPIRE_BUDGET
+ * entradas são tratadas por pacote; o restante fica para os próximos.
+ */
+static void expire_suspects(IdsShard *shard, uint64_t now) {
+    for (int budget = EXPIRE_BUDGET; budget > 0; budget--) {
+        int32_t index = timing_wheel_expire(&shard->expiry, now);
+        if (index == WHEEL_NONE) return;
+
+        uint64_t deadline = shard->suspects[index].last_seen + INACTIVE_TIMEOUT;
+        if (wheel_tick(deadline) > wheel_tick(now)) {
+            timing_wheel_schedule(&shard->expiry, index, deadline);
+        } else {
+            remove_suspect(shard, index);
+            shard->expirations++;
+        }
+    }
+}
+
+/**
+ * @brief Publica o resumo top-K quando o intervalo corrente termina e inicia o próximo.
+ * * Os intervalos são alinhados aos múltiplos de topk_interval_ns no tempo dos
+ * pacotes, de modo que workers e replays produzem resumos comparáveis.
+ */
+static void flush_top_talkers(IdsShard *shard, uint64_t now) {
+    if (topk_size == 0 || now < shard->top_deadline) return;
+
+    if (shard->top_deadline != 0) {
+        SpaceSavingEntry *entries = malloc(topk_size * sizeof(SpaceSavingEntry));
+        TopTalker *talkers = malloc(TOP_METRICS * topk_size * sizeof(TopTalker));
+        TopTalkerList lists[TOP_METRICS];
+
+        for (int m = 0; m < TOP_METRICS; m++) {
+            int count = space_saving_top(&shard->top[m], entries, (int)topk_size);
+
+            for (int i = 0; i < count; i++) {
+                talkers[m * topk_size + i] = (TopTalker){ entries[i].key, entries[i].count, entries[i].error };
+            }
+            lists[m] = (TopTalkerList){ top_metric_names[m], &talkers[m * topk_size], count };
+            space_saving_clear(&shard->top[m]);
+        }
+
+        publish_top_talkers(shard->top_deadline, (unsigned int)(topk_interval_ns / NSEC_PER_SEC), lists, TOP_METRICS);
+        free(entries);
+        free(talkers);
+    }
+
+    shard->top_deadline = (now / topk_interval_ns + 1) * topk_interval_ns;
+}
+
+/**
+ * @brief Avança o relógio do shard ao vivo até o instante do pacote (expiração, fluxos e resumos).
+ */
+static void advance_live_clock(IdsShard *shard, uint64_t now) {
+    expire_suspects(shard, now);
+    if (shard->flows.flows != NULL) flow_table_expire(&shard->flows, now);
+    flush_top_talkers(shard, now);
+}
+
+/**
+ * @brief Publica o resumo top-K parcial do intervalo em andamento e os fluxos abertos (fim da captura).
+ */
+void flush_ids_shard(IdsShard *shard) {
+    if (shard->mode == SHARD_LIVE && shard->top_deadline != 0) flush_top_talkers(shard, shard->top_deadline);
+    if (shard->flows.flows != NULL) flow_table_drain(&shard->flows);
+}
+
+/**
+ * @brief Localiza o IP na tabela de suspeitos (O(1) esperado via índice hash).
+ * @return Índice da entrada (estável até a próxima limpeza), ou -1 se ausente.
+ */
+static int find_suspect(IdsShard *shard, uint32_t ip) {
+    return ip_table_find(&shard->index, ip);
+}
+
+/**
+ * @brief Como find_suspect(), para um prefixo IPv6 já mascarado.
+ */
+static int find_suspect6(IdsShard *shard, Ip6Key prefix) {
+    return ip6_table_find(&shard->index6, prefix);
+}
+
+/**
+ * @brief Converte uma janela deslizante de largura 'width' em taxas por segundo no instante now.
+ */
+static void window_rates(const RateWindow *window, uint64_t width, uint64_t now, uint64_t *pps, uint64_t *bps) {
+    uint64_t packets, bytes;
+
+    rate_window_count(window, now, width, &packets, &bytes);
+    *pps = (uint64_t)((unsigned __int128)packets * NSEC_PER_SEC / width);
+    *bps = (uint64_t)((unsigned __int128)bytes * NSEC_PER_SEC / width);
+}
+
+/**
+ * @brief Portas UDP distintas que disparam o UDP scan para esta origem.
+ * * Port-unreachables devolvidos à origem provam que ela sondou portas fechadas,
+ * então a sondagem confirmada alerta com metade da amplitude.
+ */
+static unsigned int udp_scan_limit(const Suspect *suspect) {
+    return suspect->unreachable >= udp_unreach_confirm ? (udp_scan_threshold + 1) / 2 : udp_scan_threshold;
+}
+
+/**
+ * @brief Fração (0..SCORE_MAX) do limiar atingida por value.
+ */
+static int threshold_score(uint64_t value, unsigned int threshold) {
+    return (int)((value < threshold ? value : threshold) * SCORE_MAX / threshold);
+}
+
+/**
+ * @brief Como threshold_score(), para amplitudes: todo cliente TCP toca ao menos
+ * uma porta e um destino, então só o que passa do primeiro aproxima do alerta.
+ */
+static int breadth_score(uint32_t breadth, unsigned int threshold) {
+    if (breadth <= 1) return 0;
+    return threshold > 1 ? threshold_score(breadth - 1, threshold - 1) : SCORE_MAX;
+}
+
+/**
+ * @brief Maior contagem entre as classes de flags que nunca aparecem em tráfego legítimo.
+ */
+static uint32_t anomalous_segments(const Suspect *suspect) {
+    uint32_t most = 0;
+
+    for (int c = STEALTH_NULL; c <= STEALTH_SYN_FIN; c++) {
+        if (suspect->stealth[c] > most) most = suspect->stealth[c];
+    }
+    return most;
+}
+
+/**
+ * @brief Quão perto a origem está de disparar algum detector (0 = benigna, SCORE_MAX = alerta).
+ * * A taxa ICMP é avaliada no instante do último pacote da origem; a ociosidade
+ * desde então fica a cargo dos créditos do CLOCK.
+ */
+static int suspect_score(const Suspect *suspect) {
+    uint64_t pps, bps, udp_pps, udp_bps;
+    window_rates(&suspect->icmp, icmp_window_ns, suspect->last_seen, &pps, &bps);
+    window_rates(&suspect->udp, UDP_WINDOW, suspect->last_seen, &udp_pps, &udp_bps);
+
+    uint32_t ports = port_set_count(&suspect->ports);
+    int ports_score = breadth_score(ports, scan_threshold);
+    int pps_score = threshold_score(pps, icmp_pps_threshold);
+    int bps_score = threshold_score(bps, icmp_bps_threshold);
+    int icmp_score = pps_score > bps_score ? pps_score : bps_score;
+    int hosts_score = breadth_score(hll_count(&suspect->hosts), sweep_threshold);
+    int stealth_score = threshold_score(anomalous_segments(suspect), stealth_threshold);
+    int udp_ports_score = breadth_score(port_set_count(&suspect->udp_ports), udp_scan_limit(suspect));
+    int udp_pps_score = threshold_score(udp_pps, udp_pps_threshold);
+    int udp_bps_score = threshold_score(udp_bps, udp_bps_threshold);
+    int score = ports_score > icmp_score ? ports_score : icmp_score;
+
+    if (stealth_score > score) score = stealth_score;
+    if (udp_ports_score > score) score = udp_ports_score;
+    if (udp_pps_score > score) score = udp_pps_score;
+    if (udp_bps_score > score) score = udp_bps_score;
+    return hosts_score > score ? hosts_score : score;
+}
+
+/**
+ * @brief Libera uma entrada do pool ao vivo cheio (CLOCK com créditos).
+ * * O ponteiro do relógio examina até EVICT_SCAN entradas, retirando um crédito
+ * de cada uma, e despeja a de menor (score, créditos). Origens benignas e sem
+ * hits recentes saem primeiro; um atacante ativo acumula score e créditos e
+ * sobrevive a um flood de origens falsificadas, que nunca passam de score 0.
+ * O custo é limitado por EVICT_SCAN, independentemente do tamanho da tabela.
+ */
+static void evict_suspect(IdsShard *shard) {
+    int victim = -1, victim_rank = 0, victim_score = 0;
+
+    for (int k = 0; k < EVICT_SCAN && k < shard->suspect_count; k++) {
+        if (shard->clock_hand >= shard->suspect_count) shard->clock_hand = 0;
+
+        int i = shard->clock_hand++;
+        Suspect *candidate = &shard->suspects[i];
+        int score = suspect_score(candidate);
+        int rank = score * (CREDIT_MAX + 1) + candidate->credit;
+
+        if (victim < 0 || rank < victim_rank) {
+            victim = i;
+            victim_rank = rank;
+            victim_score = score;
+        }
+        if (candidate->credit > 0) candidate->credit--;
+
+        // Entrada ociosa e benigna: não há candidato melhor
+        if (rank == 0) break;
+    }
+
+    shard->evictions++;
+    if (victim_rank > 0) shard->evictions_pressure++;
+    if (victim_score >= SCORE_MAX / 2) shard->evictions_suspects++;
+    remove_suspect(shard, victim);
+}
+
+/**
+ * @brief Inicia o rastreamento de um novo IP de origem.
+ * * No modo ao vivo a tabela tem capacidade fixa e uma entrada é despejada para
+ * abrir espaço; no modo forense ela dobra de tamanho.
+ * @param prefix Prefixo de uma origem IPv6 (ip é então o seu hash), ou NULL para IPv4.
+ * @return Entrada criada.
+ */
+static Suspect *track_suspect(IdsShard *shard, uint32_t ip, const Ip6Key *prefix, uint64_t now) {
+    if (shard->suspect_count == shard->capacity) {
+        if (shard->mode == SHARD_LIVE) {
+            evict_suspect(shard);
+        } else {
+            shard->capacity *= 2;
+            shard->suspects = realloc(shard->suspects, (size_t)shard->capacity * sizeof(Suspect));
+        }
+    }
+
+    Suspect *suspect = &shard->suspects[shard->suspect_count++];
+    memset(suspect, 0, sizeof(*suspect));
+    suspect->ip = ip;
+    if (prefix != NULL) {
+        suspect->ip6 = *prefix;
+        suspect->ipv6 = 1;
+    }
+    suspect->last_seen = now;
+    suspect->credit = 1;
+    index_suspect(shard, shard->suspect_count - 1);
+    if (shard->mode == SHARD_LIVE) timing_wheel_schedule(&shard->expiry, shard->suspect_count - 1, now + INACTIVE_TIMEOUT);
+    return suspect;
+}
+
+/**
+ * @brief Registra uma porta de destino no conjunto do suspeito (sem duplicatas).
+ * * A contagem não satura: o limiar pode ser elevado e a amplitude total reportada.
+ * @return 1 se a porta é nova para a origem.
+ */
+static int record_port(IdsShard *shard, PortSet *ports, uint16_t port) {
+    size_t before = port_set_heap_bytes(ports);
+
+    if (!port_set_add(ports, port)) return 0;
+
+    shard->set_bytes += port_set_heap_bytes(ports) - before;
+    return 1;
+}
+
+/**
+ * @brief Classifica a porta de destino de um segmento TCP para o ACK scan forense.
+ * @param lone_ack 1 se o segmento é um ACK isolado.
+ */
+static void record_ack_port(IdsShard *shard, Suspect *suspect, uint16_t port, int lone_ack) {
+    if (suspect->ack_ports == NULL) {
+        suspect->ack_ports = calloc(1, sizeof(AckPorts));
+        shard->set_bytes += sizeof(AckPorts);
+    }
+    record_port(shard, lone_ack ? &suspect->ack_ports->lone : &suspect->ack_ports->other, port);
+}
+
+/**
+ * @brief Portas que só receberam ACKs isolados (veredito do ACK scan no modo forense).
+ */
+static uint32_t ack_scan_ports(const Suspect *suspect) {
+    if (suspect->ack_ports == NULL) return 0;
+    return port_set_difference_count(&suspect->ack_ports->lone, &suspect->ack_ports->other);
+}
+
+/**
+ * @brief Registra o destino no sketch de hosts distintos do suspeito.
+ * * No modo forense com --sketch-audit o par exato também é guardado, para
+ * comparar a estimativa com a contagem real no relatório final (somente IPv4).
+ * @return Estimativa atual de destinos distintos.
+ */
+static uint32_t record_host(IdsShard *shard, Suspect *suspect, uint32_t dst_ip) {
+    size_t before = hll_heap_bytes(&suspect->hosts);
+
+    if (hll_add(&suspect->hosts, hll_hash(dst_ip))) {
+        shard->set_bytes += hll_heap_bytes(&suspect->hosts) - before;
+    }
+
+    if (sketch_audit && shard->mode == SHARD_FORENSIC && !suspect->ipv6) {
+        if (shard->audit_count == shard->audit_capacity) {
+            shard->audit_capacity = shard->audit_capacity ? shard->audit_capacity * 2 : 1024;
+            shard->audit_pairs = realloc(shard->audit_pairs, shard->audit_capacity * sizeof(uint64_t));
+        }
+        shard->audit_pairs[shard->audit_count++] = (uint64_t)ntohl(suspect->ip) << 32 | ntohl(dst_ip);
+    }
+
+    return hll_count(&suspect->hosts);
+}
+
+static int decode_tunnel(const u_char *packet, int offset, int end, uint8_t proto, DecodedPacket *out);
+
+/**
+ * @brief Filtro barato, testado em linha antes de decode_tunnel: só GRE e UDP para a porta do VXLAN.
+ */
+static inline int tunnel_candidate(uint8_t proto, const DecodedPacket *out) {
+    return tunnel_depth > 0 && (proto == IPPROTO_GRE || (proto == IPPROTO_UDP && out->dst_port == VXLAN_PORT));
+}
+
+/* ========================================================================= *
+ * DECODIFICAÇÃO DE REDE E TRANSPORTE                                        *
+ * ========================================================================= *
+ * Cada decodificador recebe o buffer de captura, o offset da sua camada e  *
+ * o limite de leitura (end): nenhum byte em [end, caplen) é lido, e o      *
+ * limite só diminui (comprimento total do IP). Os campos são lidos byte a  *
+ * byte, sem casts para as structs de netinet, então um cabeçalho em offset *
+ * ímpar (Ethernet + VLAN, túneis) não gera acessos desalinhados.           */
+
+static inline uint16_t load16(const u_char *p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+/**
+ * @brief Lê um endereço IPv4 sem exigir alinhamento, mantendo a ordem de rede (como s_addr).
+ */
+static inline uint32_t load_addr(const u_char *p) {
+    uint32_t addr;
+    memcpy(&addr, p, sizeof(addr));
+    return addr;
+}
+
+/**
+ * @brief Decodifica as portas e as flags TCP/UDP, comum às duas famílias.
+ * * @param offset Início do cabeçalho de transporte; end = limite de leitura do datagrama.
+ * @return 0 se um segmento TCP foi truncado antes das flags (descartado).
+ */
+static int decode_transport(const u_char *packet, int offset, int end, uint8_t proto, DecodedPacket *out) {
+    const u_char *l4 = packet + offset;
+    int available = end - offset;
+
+    out->l4_offset = (uint16_t)offset;
+    out->l4_length = (uint16_t)available;
+
+    if (proto == IPPROTO_TCP) {
+        // Garante que as portas e as flags (byte 13) foram capturadas antes de lê-las
+        if (available < TCP_FLAGS_END) return 0;
+        out->src_port = load16(l4);
+        out->dst_port = load16(l4 + 2);
+        out->tcp_flags = l4[13];
+    } else if (proto == IPPROTO_UDP && available >= UDP_PORTS_END) {
+        // Portas UDP só identificam o fluxo; um datagrama truncado ainda conta com portas 0
+        out->src_port = load16(l4);
+        out->dst_port = load16(l4 + 2);
+    }
+    return 1;
+}
+
+/**
+ * @brief Decodifica um datagrama IPv4 (a partir do cabeçalho IP).
+ * * O ip_hl precisa caber no que foi capturado, e o comprimento total limita
+ * a leitura: o padding de um quadro Ethernet curto não é lido como transporte.
+ * Comprimento 0 (capturas de saída com TSO) mantém o limite do caplen.
+ */
+static int decode_ipv4(const u_char *packet, int offset, int end, DecodedPacket *out) {
+    const u_char *l3 = packet + offset;
+
+    // Datagramas truncados abaixo de um cabeçalho IPv4 mínimo não podem ser decodificados
+    if (end - offset < IPV4_HEADER_LEN || l3[0] >> 4 != 4) return 0;
+
+    int header_len = (l3[0] & 0x0f) << 2;
+    int total_len = load16(l3 + 2);
+    if (header_len < IPV4_HEADER_LEN || end - offset < header_len) return 0;
+    if (total_len != 0) {
+        if (total_len < header_len) return 0;
+        if (end > offset + total_len) end = offset + total_len;
+    }
+
+    // Fragmentos não iniciais não trazem cabeçalho de transporte
+    if (load16(l3 + 6) & IP_OFFMASK) return 0;
+
+    uint8_t proto = l3[9];
+    out->l3_offset = (uint16_t)offset;
+    out->src_ip = load_addr(l3 + 12);
+    out->dst_ip = load_addr(l3 + 16);
+
+    // O offset do transporte é dinâmico (ip_hl indica palavras de 32 bits)
+    int l4 = offset + header_len;
+    if (!decode_transport(packet, l4, end, proto, out)) return 0;
+
+    // GRE e VXLAN são removidos aqui: o pacote interno substitui o externo
+    if (tunnel_candidate(proto, out)) {
+        int inner = decode_tunnel(packet, l4, end, proto, out);
+        if (inner != DECAP_NONE) return inner;
+    }
+
+    if (proto == IPPROTO_ICMP && end - l4 >= ICMP_QUOTE_END) {
+        // Erros ICMP citam o cabeçalho IP do datagrama que os provocou
+        const u_char *icmp = packet + l4;
+        const u_char *quoted = icmp + ICMP_MIN_HEADER;
+        out->unreachable = icmp[0] == ICMP_UNREACH && icmp[1] == ICMP_UNREACH_PORT
+                        && quoted[9] == IPPROTO_UDP && load_addr(quoted + 12) == out->dst_ip;
+    }
+
+    out->proto = proto;
+    return 1;
+}
+
+/**
+ * @brief Decodifica um datagrama IPv6, percorrendo a cadeia de cabeçalhos de extensão.
+ * * O laço é limitado a IPV6_MAX_EXTENSIONS cabeçalhos e cada um é validado
+ * contra o limite de leitura antes do seu tamanho ser lido; a carga declarada
+ * (0 = jumbograma) limita a leitura como o comprimento total no IPv4. O ICMPv6
+ * é entregue aos detectores como IPPROTO_ICMP; mensagens de controle do enlace
+ * (NDP, MLD, anúncios de roteador) são descartadas, pois toda máquina IPv6 as
+ * envia a muitos destinos e elas inflariam o host sweep e o ICMP flood.
+ */
+static int decode_ipv6(const u_char *packet, int offset, int end, DecodedPacket *out) {
+    const u_char *l3 = packet + offset;
+
+    if (end - offset < IPV6_HEADER_LEN || l3[0] >> 4 != 6) return 0;
+
+    int payload_len = load16(l3 + 4);
+    if (payload_len != 0 && end > offset + IPV6_HEADER_LEN + payload_len) end = offset + IPV6_HEADER_LEN + payload_len;
+
+    uint8_t next = l3[6];
+    int l4 = offset + IPV6_HEADER_LEN;
+
+    for (int extensions = 0; ; extensions++) {
+        if (next != IPPROTO_HOPOPTS && next != IPPROTO_ROUTING && next != IPPROTO_DSTOPTS &&
+            next != IPPROTO_FRAGMENT && next != IPPROTO_AH) {
+            break;
+        }
+        if (extensions == IPV6_MAX_EXTENSIONS || end - l4 < 8) return 0;
+
+        if (next == IPPROTO_FRAGMENT) {
+            if (load16(packet + l4 + 2) & IPV6_FRAGMENT_OFFSET) return 0;
+            next = packet[l4];
+            l4 += IPV6_FRAGMENT_LEN;
+        } else {
+            // AH mede o tamanho em palavras de 32 bits; os demais, em blocos de 8 bytes além do primeiro
+            int length = next == IPPROTO_AH ? (packet[l4 + 1] + 2) * 4 : (packet[l4 + 1] + 1) * 8;
+            next = packet[l4];
+            l4 += length;
+        }
+    }
+    // O último cabeçalho de extensão não pode terminar além do que foi capturado
+    if (l4 > end) return 0;
+
+    out->ipv6 = 1;
+    out->l3_offset = (uint16_t)offset;
+    out->src6 = ip6_key(l3 + 8);
+    out->dst6 = ip6_key(l3 + 24);
+    out->src_ip = ip6_table_hash(out->src6);
+    out->dst_ip = ip6_table_hash(out->dst6);
+
+    if (!decode_transport(packet, l4, end, next, out)) return 0;
+
+    if (tunnel_candidate(next, out)) {
+        int inner = decode_tunnel(packet, l4, end, next, out);
+        if (inner != DECAP_NONE) return inner;
+    }
+
+    if (next == IPPROTO_ICMPV6) {
+        const u_char *icmp = packet + l4;
+        int remaining = end - l4;
+
+        // O tipo é o primeiro byte: erros (1-4) e echo (128/129) seguem, o resto é controle do enlace
+        if (remaining < 1 || icmp[0] > ICMP6_ECHO_REPLY) return 0;
+
+        // Como no IPv4, o erro cita o cabeçalho do datagrama que o provocou
+        if (remaining >= ICMP6_QUOTE_END) {
+            const u_char *quoted = icmp + ICMP_MIN_HEADER;
+            out->unreachable = icmp[0] == ICMP6_DST_UNREACH && icmp[1] == ICMP6_DST_UNREACH_NOPORT
+                            && quoted[6] == IPPROTO_UDP && ip6_key_equal(ip6_key(quoted + 8), out->dst6);
+        }
+        next = IPPROTO_ICMP;
+    }
+
+    out->proto = next;
+    return 1;
+}
+
+/* ========================================================================= *
+ * DECODIFICADORES DE ENLACE                                                 *
+ * ========================================================================= *
+ * O tipo de enlace (pcap_datalink) é resolvido uma única vez, na abertura   *
+ * da captura: cada shard guarda o decodificador especializado e o caminho   *
+ * quente não testa o tipo de enlace a cada pacote. Todo offset é validado   *
+ * contra o caplen antes da leitura.                                         */
+
+/**
+ * @brief Zera os campos de rede e transporte antes de decodificar um quadro; proto 0 = descartado.
+ */
+static inline void reset_layers(DecodedPacket *out) {
+    out->proto = 0;
+    out->src_port = 0;
+    out->dst_port = 0;
+    out->tcp_flags = 0;
+    out->unreachable = 0;
+    out->ipv6 = 0;
+    out->l3_offset = 0;
+    out->l4_offset = 0;
+    out->l4_length = 0;
+}
+
+/**
+ * @brief Prepara o descritor para um quadro recém-capturado.
+ * * Os offsets do descritor têm 16 bits: só os cabeçalhos são lidos, então um
+ * quadro maior (GRO, jumbo sem snaplen) é decodificado só até DECODE_MAX_OFFSET.
+ * @return Limite de leitura do quadro.
+ */
+static inline int reset_decoded(int caplen, int length, DecodedPacket *out) {
+    // Um literal composto zera a linha inteira com poucas escritas largas, sem RMW nos campos de bits
+    *out = (DecodedPacket){ .length = length, .tunnel = TUNNEL_NONE };
+    return caplen < DECODE_MAX_OFFSET ? caplen : DECODE_MAX_OFFSET;
+}
+
+/**
+ * @brief Seleciona o decodificador de rede pelo EtherType; o resto é descartado.
+ */
+static inline int decode_network(const u_char *packet, int offset, int end, uint16_t ethertype, DecodedPacket *out) {
+    if (ethertype == ETHERTYPE_IP) return decode_ipv4(packet, offset, end, out);
+    if (ethertype == ETHERTYPE_IPV6 && ipv6_prefix > 0) return decode_ipv6(packet, offset, end, out);
+    return 0;
+}
+
+/**
+ * @brief Salta até VLAN_MAX_TAGS tags 802.1Q/802.1ad empilhadas e decodifica a camada de rede.
+ * * @param offset Primeiro byte depois do cabeçalho de enlace.
+ * @param ethertype Protocolo informado pelo cabeçalho de enlace.
+ */
+static inline int decode_tagged(const u_char *packet, int offset, int end, uint16_t ethertype, DecodedPacket *out) {
+    for (int tags = 0; ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_8021AD || ethertype == ETHERTYPE_QINQ_LEGACY; tags++) {
+        if (tags == VLAN_MAX_TAGS || end - offset < VLAN_TAG_LEN) return 0;
+        ethertype = load16(packet + offset + 2);
+        offset += VLAN_TAG_LEN;
+    }
+    return decode_network(packet, offset, end, ethertype, out);
+}
+
+/**
+ * @brief Decodifica um quadro Ethernet (da captura ou encapsulado num túnel).
+ */
+static inline int decode_frame(const u_char *packet, int offset, int end, DecodedPacket *out) {
+    if (end - offset < ETH_HEADER_LEN) return 0;
+    return decode_tagged(packet, offset + ETH_HEADER_LEN, end, load16(packet + offset + 12), out);
+}
+
+/**
+ * @brief Traduz a família de endereço do loopback BSD para o EtherType equivalente.
+ * * O AF_INET6 varia entre sistemas (Linux 10, OpenBSD/NetBSD 24, FreeBSD 28,
+ * macOS 30), e a captura pode ter sido gravada em qualquer um deles.
+ */
+static inline uint16_t loopback_ethertype(uint8_t family) {
+    if (family == 2) return ETHERTYPE_IP;
+    if (family == 10 || family == 24 || family == 28 || family == 30) return ETHERTYPE_IPV6;
+    return 0;
+}
+
+/**
+ * @brief DLT_EN10MB: Ethernet II, com ou sem tags VLAN.
+ * @return 1 se o pacote é relevante para os detectores; 0 caso contrário.
+ */
+static int decode_ethernet(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    return decode_frame(packet, 0, end, out);
+}
+
+/**
+ * @brief DLT_LINUX_SLL: captura na interface "any" (cooked v1).
+ */
+static int decode_sll(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    if (end < SLL_HEADER_LEN) return 0;
+    return decode_tagged(packet, SLL_HEADER_LEN, end, load16(packet + 14), out);
+}
+
+/**
+ * @brief DLT_LINUX_SLL2: cooked v2, com o protocolo no início do cabeçalho.
+ */
+static int decode_sll2(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    if (end < SLL2_HEADER_LEN) return 0;
+    return decode_tagged(packet, SLL2_HEADER_LEN, end, load16(packet), out);
+}
+
+/**
+ * @brief DLT_RAW: IP sem cabeçalho de enlace (tun, WireGuard); a versão vem do primeiro nibble.
+ */
+static int decode_raw(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    if (end < 1) return 0;
+
+    unsigned int version = packet[0] >> 4;
+    return decode_network(packet, 0, end, version == 4 ? ETHERTYPE_IP : version == 6 ? ETHERTYPE_IPV6 : 0, out);
+}
+
+/**
+ * @brief DLT_IPV4: IPv4 sem cabeçalho de enlace.
+ */
+static int decode_raw_ipv4(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    return decode_ipv4(packet, 0, end, out);
+}
+
+/**
+ * @brief DLT_IPV6: IPv6 sem cabeçalho de enlace.
+ */
+static int decode_raw_ipv6(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    return decode_network(packet, 0, end, ETHERTYPE_IPV6, out);
+}
+
+/**
+ * @brief DLT_NULL: loopback BSD com a família em 32 bits na ordem do host que gravou.
+ * * Como toda família cabe num byte, o byte não nulo das pontas resolve a ordem.
+ */
+static int decode_null(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    if (end < NULL_HEADER_LEN) return 0;
+
+    uint8_t family = packet[0] ? packet[0] : packet[3];
+    return decode_network(packet, NULL_HEADER_LEN, end, loopback_ethertype(family), out);
+}
+
+/**
+ * @brief DLT_LOOP: loopback do OpenBSD, com a família na ordem de rede.
+ */
+static int decode_loop(const u_char *packet, int caplen, int length, DecodedPacket *out) {
+    int end = reset_decoded(caplen, length, out);
+    if (end < NULL_HEADER_LEN) return 0;
+    return decode_network(packet, NULL_HEADER_LEN, end, loopback_ethertype(packet[3]), out);
+}
+
+/**
+ * @brief Decodificador especializado de um tipo de enlace da libpcap.
+ * @return NULL se o tipo de enlace não é suportado.
+ */
+static LinkDecoder link_decoder(int datalink) {
+    switch (datalink) {
+        case DLT_EN10MB:     return decode_ethernet;
+        case DLT_LINUX_SLL:  return decode_sll;
+#ifdef DLT_LINUX_SLL2
+        case DLT_LINUX_SLL2: return decode_sll2;
+#endif
+        case DLT_RAW:        return decode_raw;
+#ifdef DLT_IPV4
+        case DLT_IPV4:       return decode_raw_ipv4;
+        case DLT_IPV6:       return decode_raw_ipv6;
+#endif
+        case DLT_NULL:       return decode_null;
+        case DLT_LOOP:       return decode_loop;
+        default:             return NULL;
+    }
+}
+
+/**
+ * @brief Seleciona o decodificador do shard a partir do pcap_datalink() da captura.
+ * * Chamado uma vez na abertura da captura (ou de cada arquivo, no modo batch).
+ * @return 0 em caso de sucesso; -1 se o tipo de enlace não é suportado.
+ */
+int set_shard_datalink(IdsShard *shard, int datalink) {
+    LinkDecoder decode = link_decoder(datalink);
+    if (decode == NULL) return -1;
+
+    shard->decode = decode;
+    shard->kernel = decode == decode_ethernet ? header_kernel_detect() : HEADER_KERNEL_NONE;
+    return 0;
+}
+
+/**
+ * @brief Seleciona o decodificador do shard padrão (captura e replay single-thread).
+ */
+int set_datalink(int datalink) {
+    return set_shard_datalink(get_default_shard(), datalink);
+}
+
+/**
+ * @brief Decodifica um trecho do lote: o kernel resolve o perfil comum, o decodificador de enlace o resto.
+ * * O kernel recebe até HEADER_KERNEL_MAX pacotes por chamada; só os bits
+ * zerados da máscara devolvida passam pelo decodificador, um a um. Um trecho
+ * cheio sem nenhum pacote no perfil (SPAN com VLAN, espelhamento em túnel,
+ * IPv6) desliga o kernel pelos KERNEL_BACKOFF trechos seguintes, para que
+ * esse tráfego não pague as cargas vetoriais à toa.
+ * @param backoff Trechos restantes sem kernel (estado do chamador).
+ */
+static void decode_batch(LinkDecoder decode, HeaderKernel kernel, unsigned int *backoff,
+                         const PacketRef *pkts, size_t count, DecodedPacket *out) {
+    uint16_t tunnel_port = tunnel_depth > 0 ? VXLAN_PORT : 0;
+
+    for (size_t first = 0; first < count; first += HEADER_KERNEL_MAX) {
+        size_t n = count - first < HEADER_KERNEL_MAX ? count - first : HEADER_KERNEL_MAX;
+        uint32_t all = n == 32 ? UINT32_MAX : (1u << n) - 1;
+        uint32_t fast = 0;
+
+        if (*backoff > 0) {
+            (*backoff)--;
+        } else if (kernel != HEADER_KERNEL_NONE) {
+            fast = header_kernel_extract(kernel, &pkts[first], n, tunnel_port, &out[first]);
+            if (fast == 0 && n == HEADER_KERNEL_MAX) *backoff = KERNEL_BACKOFF;
+        }
+
+        for (uint32_t missed = ~fast & all; missed != 0; missed &= missed - 1) {
+            size_t i = first + (size_t)__builtin_ctz(missed);
+            decode(pkts[i].data, (int)pkts[i].caplen, (int)pkts[i].len, &out[i]);
+        }
+    }
+}
+
+/**
+ * @brief Compara dois descritores campo a campo (a conferência do kernel no benchmark).
+ */
+static int same_descriptor(const DecodedPacket *a, const DecodedPacket *b) {
+    return ip6_key_equal(a->src6, b->src6) && ip6_key_equal(a->dst6, b->dst6)
+        && a->src_ip == b->src_ip && a->dst_ip == b->dst_ip && a->tunnel_id == b->tunnel_id && a->length == b->length
+        && a->src_port == b->src_port && a->dst_port == b->dst_port && a->frame_offset == b->frame_offset
+        && a->l3_offset == b->l3_offset && a->l4_offset == b->l4_offset && a->l4_length == b->l4_length
+        && a->proto == b->proto && a->tcp_flags == b->tcp_flags && a->unreachable == b->unreachable
+        && a->ipv6 == b->ipv6 && a->tunnel == b->tunnel && a->tunnel_depth == b->tunnel_depth;
+}
+
+/**
+ * @brief Mede o throughput da fase de decodificação do lote para um tipo de enlace.
+ * * Decodifica os pacotes 'rounds' vezes, em lotes de ANALYZE_BATCH_MAX e sem
+ * consultar o rastreador, para isolar o custo da decodificação. Com kernel =
+ * HEADER_KERNEL_NONE mede só o decodificador de enlace; com outro nível, o
+ * kernel de cabeçalhos seguido do decodificador para os pacotes fora do
+ * perfil. Antes da medição, todo descritor do kernel é conferido contra o do
+ * decodificador. Os pacotes devem estar em memória.
+ * @param kernel HeaderKernel; ignorado (NONE) fora do DLT_EN10MB.
+ * @return 0 em caso de sucesso; -1 se o tipo de enlace não é suportado.
+ */
+int benchmark_decoder(int datalink, int kernel, const PacketRef *pkts, size_t count, unsigned int rounds,
+                      DecodeBenchmark *result) {
+    LinkDecoder decode = link_decoder(datalink);
+    DecodedPacket decoded[ANALYZE_BATCH_MAX];
+    DecodedPacket reference;
+    volatile unsigned long long sink = 0;
+    unsigned long long relevant = 0;
+    unsigned int backoff = 0;
+
+    if (decode == NULL) return -1;
+    if (decode != decode_ethernet) kernel = HEADER_KERNEL_NONE;
+    *result = (DecodeBenchmark){ 0 };
+
+    for (size_t first = 0; first < count; first += HEADER_KERNEL_MAX) {
+        size_t n = count - first < HEADER_KERNEL_MAX ? count - first : HEADER_KERNEL_MAX;
+        uint32_t fast = header_kernel_extract((HeaderKernel)kernel, &pkts[first], n, tunnel_depth > 0 ? VXLAN_PORT : 0, decoded);
+
+        for (size_t i = 0; i < n; i++) {
+            if (!(fast >> i & 1)) continue;
+            decode(pkts[first + i].data, (int)pkts[first + i].caplen, (int)pkts[first + i].len, &reference);
+            result->fast++;
+            if (!same_descriptor(&decoded[i], &reference)) result->mismatches++;
+        }
+    }
+    if (count == 0 || rounds == 0) return 0;
+
+    uint64_t start = monotonic_ns();
+    for (unsigned int r = 0; r < rounds; r++) {
+        for (size_t base = 0; base < count; base += ANALYZE_BATCH_MAX) {
+            size_t n = count - base < ANALYZE_BATCH_MAX ? count - base : ANALYZE_BATCH_MAX;
+            decode_batch(decode, (HeaderKernel)kernel, &backoff, &pkts[base], n, decoded);
+            for (size_t i = 0; i < n; i++) relevant += decoded[i].src_ip ^ decoded[i].dst_port;
+        }
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+
+    // O acumulador volátil impede que o compilador elimine as chamadas
+    sink = relevant;
+    (void)sink;
+    result->ns_per_packet = (double)elapsed / ((double)count * rounds);
+    return 0;
+}
+
+/* ========================================================================= *
+ * DECAPSULAÇÃO DE TÚNEIS (GRE, VXLAN, ERSPAN)                               *
+ * ========================================================================= *
+ * Sessões de espelhamento em nuvem entregam o tráfego dentro de VXLAN ou   *
+ * ERSPAN/GRE; analisado como está, todo alerta apontaria para os endpoints *
+ * do túnel. O decodificador remove até --tunnel-depth camadas sem copiar   *
+ * nada: o pacote interno é decodificado a partir de um offset do próprio   *
+ * buffer de captura. Pacotes com mais camadas do que isso são descartados. */
+
+/**
+ * @brief Passa a descrever o quadro interno de um túnel.
+ * * Registra a camada mais externa (a sessão de espelhamento) e desconta do
+ * tamanho no fio os cabeçalhos que ficaram para trás.
+ * @param inner Offset do início do quadro interno; end = limite de leitura.
+ * @return 0 se a profundidade máxima já foi atingida (pacote descartado).
+ */
+static int enter_tunnel(DecodedPacket *out, TunnelType type, uint32_t id, int inner, int end) {
+    if (out->tunnel_depth >= tunnel_depth) return 0;
+
+    if (out->tunnel_depth++ == 0) {
+        out->tunnel = (uint8_t)type;
+        out->tunnel_id = id;
+    }
+    out->length -= inner - out->frame_offset;
+    if (out->length < end - inner) out->length = end - inner;
+    out->frame_offset = (uint16_t)inner;
+    reset_layers(out);
+    return 1;
+}
 
 /**
- * @struct Suspect
- * @brief Estrutura responsável por rastrear as métricas comportamentais de um IP de origem.
+ * @brief Remove um cabeçalho ERSPAN (GRE 0x88BE/0x22EB) e decodifica o quadro espelhado.
+ * * Tipo I não tem cabeçalho próprio (GRE sem sequência); os tipos II e III
+ * levam o ID de sessão de 10 bits nos bytes 2-3.
  */
-typedef struct {
-    uint32_t ip;                        // Endereço IP de origem (formato de rede)
-    uint16_t ports[SCAN_THRESHOLD];     // Histórico de portas de destino acessadas unicamente
-    int port_count;                     // Contador de portas distintas acessadas
-    int icmp_count;                     // Contador de requisições ICMP (pings)
-    time_t last_seen;                   // Timestamp do último pacote recebido deste IP
-} Suspect;
+static int decode_erspan(const u_char *packet, int offset, int end, uint16_t protocol, int sequenced, DecodedPacket *out) {
+    const u_char *erspan = packet + offset;
+    int available = end - offset;
+    int header = 0;
+    uint32_t session = 0;
+
+    if (protocol == ETHERTYPE_ERSPAN3) {
+        if (available < ERSPAN3_HEADER_LEN || erspan[0] >> 4 != 2) return 0;
+        header = ERSPAN3_HEADER_LEN + ((erspan[11] & 0x01) ? ERSPAN3_PLATFORM_LEN : 0);
+    } else if (sequenced) {
+        if (available < ERSPAN2_HEADER_LEN || erspan[0] >> 4 != 1) return 0;
+        header = ERSPAN2_HEADER_LEN;
+    }
+    if (header > 0) session = (uint32_t)(erspan[2] & 0x03) << 8 | erspan[3];
+    if (available < header) return 0;
 
-// Estado global do IDS
-Suspect suspects[MAX_SUSPECTS];
-int suspect_count = 0;
-time_t last_cleanup = 0;
+    if (!enter_tunnel(out, TUNNEL_ERSPAN, session, offset + header, end)) return 0;
+    return decode_frame(packet, offset + header, end, out);
+}
 
 /**
- * @brief Remove IPs inativos da memória para evitar esgotamento do vetor de suspeitos.
- * * Executa periodicamente com base na constante CLEANUP_INTERVAL. Caso um IP
- * não envie pacotes durante o INACTIVE_TIMEOUT, ele é descartado do rastreamento.
+ * @brief Remove um cabeçalho GRE (RFC 2784/2890) e decodifica a carga.
+ * * A carga pode ser um datagrama IP, um quadro Ethernet (NVGRE, gretap) ou
+ * ERSPAN. GRE versão 1 (PPTP), roteamento e outras cargas seguem como GRE.
+ * @return 1/0 como os demais decodificadores; DECAP_NONE se a carga não é suportada.
  */
-void cleanup_suspects() {
-    time_t now = time(NULL);
+static int decode_gre(const u_char *packet, int offset, int end, DecodedPacket *out) {
+    const u_char *gre = packet + offset;
+    int available = end - offset;
 
-    // Garante que a limpeza não consuma CPU excessivamente rodando a cada pacote
-    if (difftime(now, last_cleanup) < CLEANUP_INTERVAL) return;
+    if (available < GRE_HEADER_LEN) return 0;
 
-    int active = 0;
-    for (int i = 0; i < suspect_count; i++) {
-        // Mantém apenas os suspeitos que tiveram atividade recente
-        if (difftime(now, suspects[i].last_seen) < INACTIVE_TIMEOUT) {
-            suspects[active++] = suspects[i];
-        }
+    uint8_t flags = gre[0];
+    uint16_t protocol = load16(gre + 2);
+    if ((gre[1] & GRE_VERSION_MASK) != 0 || (flags & GRE_FLAG_ROUTING)) return DECAP_NONE;
+
+    // Campos opcionais, nesta ordem: checksum + reservado, chave, sequência
+    int header = GRE_HEADER_LEN + ((flags & GRE_FLAG_CHECKSUM) ? 4 : 0);
+    uint32_t key = 0;
+    if (flags & GRE_FLAG_KEY) {
+        if (available < header + 4) return 0;
+        key = (uint32_t)load16(gre + header) << 16 | load16(gre + header + 2);
+        header += 4;
     }
+    if (flags & GRE_FLAG_SEQUENCE) header += 4;
+    if (available < header) return 0;
 
-    suspect_count = active;
-    last_cleanup = now;
+    int payload = offset + header;
 
-    printf("[IDS] Limpeza de rotina realizada. IPs rastreados ativos: %d\n", suspect_count);
+    switch (protocol) {
+        case ETHERTYPE_IP:
+        case ETHERTYPE_IPV6:
+            if (!enter_tunnel(out, TUNNEL_GRE, key, payload, end)) return 0;
+            return decode_network(packet, payload, end, protocol, out);
+        case ETHERTYPE_TEB:
+            if (!enter_tunnel(out, TUNNEL_GRE, key, payload, end)) return 0;
+            return decode_frame(packet, payload, end, out);
+        case ETHERTYPE_ERSPAN:
+        case ETHERTYPE_ERSPAN3:
+            return decode_erspan(packet, payload, end, protocol, flags & GRE_FLAG_SEQUENCE, out);
+        default:
+            return DECAP_NONE;
+    }
 }
 
 /**
- * @brief Analisa pacotes de rede interceptados em busca de anomalias e ataques.
- * * Inspeciona os cabeçalhos das camadas de Enlace (Ethernet), Rede (IP) e Transporte
- * para identificar assinaturas de comportamento malicioso (Ex: Port Scan, ICMP Flood).
- * * @param packet Buffer contendo os bytes brutos do pacote interceptado.
- * @param length Tamanho total do pacote capturado.
+ * @brief Remove um cabeçalho VXLAN (RFC 7348) e decodifica o quadro Ethernet interno.
+ * * @param offset Início do cabeçalho VXLAN (logo após o cabeçalho UDP).
+ */
+static int decode_vxlan(const u_char *packet, int offset, int end, DecodedPacket *out) {
+    const u_char *vxlan = packet + offset;
+
+    if (end - offset < VXLAN_HEADER_LEN) return 0;
+    if (!(vxlan[0] & VXLAN_FLAG_VNI)) return DECAP_NONE;
+
+    uint32_t vni = (uint32_t)vxlan[4] << 16 | (uint32_t)vxlan[5] << 8 | vxlan[6];
+    if (!enter_tunnel(out, TUNNEL_VXLAN, vni, offset + VXLAN_HEADER_LEN, end)) return 0;
+    return decode_frame(packet, offset + VXLAN_HEADER_LEN, end, out);
+}
+
+/**
+ * @brief Decapsula o transporte de um datagrama IP quando ele é um túnel suportado.
+ * * Chamado pelos decodificadores IPv4/IPv6 depois das portas: o GRE pelo
+ * protocolo IP, o VXLAN pela porta UDP de destino.
+ * @param offset Início do cabeçalho de transporte do datagrama externo.
+ * @return Resultado da decodificação do pacote interno; DECAP_NONE se não há túnel.
+ */
+static int decode_tunnel(const u_char *packet, int offset, int end, uint8_t proto, DecodedPacket *out) {
+    if (tunnel_depth == 0) return DECAP_NONE;
+    if (proto == IPPROTO_GRE) return decode_gre(packet, offset, end, out);
+    if (proto == IPPROTO_UDP && out->dst_port == VXLAN_PORT && end - offset >= UDP_HEADER_LEN) {
+        return decode_vxlan(packet, offset + UDP_HEADER_LEN, end, out);
+    }
+    return DECAP_NONE;
+}
+
+/**
+ * @brief Prefixo IPv6 (--ipv6-prefix) que identifica a origem do pacote no rastreador.
+ */
+static Ip6Key source_prefix(const DecodedPacket *pkt) {
+    return ip6_key_mask(pkt->src6, ipv6_prefix);
+}
+
+/**
+ * @brief Localiza a origem do pacote no índice da sua família.
+ */
+static int find_source(IdsShard *shard, const DecodedPacket *pkt) {
+    return pkt->ipv6 ? find_suspect6(shard, source_prefix(pkt)) : find_suspect(shard, pkt->src_ip);
+}
+
+/**
+ * @brief Identificador de 32 bits da origem: o IPv4, ou o hash do prefixo IPv6.
+ */
+static uint32_t source_id(const DecodedPacket *pkt) {
+    return pkt->ipv6 ? ip6_table_hash(source_prefix(pkt)) : pkt->src_ip;
+}
+
+/**
+ * @brief Escreve em texto a origem (ou o destino) do pacote; buffer com INET6_ADDRSTRLEN bytes.
+ */
+static const char *packet_address(const DecodedPacket *pkt, int destination, char *buffer) {
+    if (pkt->ipv6) {
+        uint8_t bytes[16];
+        ip6_key_bytes(destination ? pkt->dst6 : pkt->src6, bytes);
+        return inet_ntop(AF_INET6, bytes, buffer, INET6_ADDRSTRLEN);
+    }
+    return inet_ntop(AF_INET, destination ? &pkt->dst_ip : &pkt->src_ip, buffer, INET6_ADDRSTRLEN);
+}
+
+/**
+ * @brief Monta um evento IPv4; complete_event() acrescenta os endereços de um pacote IPv6.
+ */
+static IdsEvent ids_event(uint32_t src_ip, uint32_t dst_ip, uint16_t port, const char *proto, int bytes,
+                          ScanType scan_type, uint32_t scan_ports, uint32_t scan_hosts) {
+    return (IdsEvent){ .src_ip = src_ip, .dst_ip = dst_ip, .port = port, .proto = proto, .bytes = bytes,
+                       .scan_type = scan_type, .scan_ports = scan_ports, .scan_hosts = scan_hosts };
+}
+
+/**
+ * @brief Estágio de heavy hitters: decide se uma origem sem estado exato deve ser rastreada.
+ * * Todo pacote de origem não rastreada conta no Count-Min Sketch pela chave
+ * (origem, protocolo). Enquanto o pool tem folga a origem é admitida de
+ * imediato; acima de 1/ADMISSION_OCCUPANCY da capacidade, só quando a
+ * estimativa passa de promote_threshold acima do ruído de colisão do sketch.
+ * Num flood de origens aleatórias cada origem falsificada fica no sketch e o
+ * pool não é revirado, enquanto quem insiste (scanner, flooder) é promovido.
+ * @return 1 se a origem deve ser rastreada; 0 se fica retida no sketch.
+ */
+static int admit_source(IdsShard *shard, const DecodedPacket *pkt, uint64_t now) {
+    if (shard->mode != SHARD_LIVE || !admission_enabled()) return 1;
+
+    uint32_t key = ip_table_hash(source_id(pkt) ^ ((uint32_t)pkt->proto * 0x9e3779b1u));
+    uint32_t estimate = count_min_add(&shard->admission, key, now);
+
+    if (shard->suspect_count * ADMISSION_OCCUPANCY < shard->capacity ||
+        estimate >= promote_threshold + count_min_noise(&shard->admission)) {
+        shard->admission_promoted++;
+        return 1;
+    }
+
+    shard->admission_held++;
+    return 0;
+}
+
+/**
+ * @brief Acompanha o handshake TCP por destino e avalia o SYN flood contra o serviço.
+ * * O SYN do cliente abre uma entrada pendente e conta no serviço (destino,
+ * porta); o SYN-ACK do servidor conta no mesmo serviço; o ACK ou RST do
+ * cliente a tempo fecha a entrada como handshake completo. Os meio-abertos
+ * por segundo são os SYNs novos menos os handshakes completos na janela.
+ * Roda antes do estágio de admissão, já que num flood distribuído cada
+ * origem falsificada envia poucos pacotes. Custo constante por pacote.
+ * @return 1 se o SYN disparou o alerta (no máximo um por serviço por janela).
+ */
+static int track_handshake(IdsShard *shard, const DecodedPacket *pkt, uint64_t now) {
+    HandshakeTable *table = &shard->handshakes;
+    HandshakeService *service;
+    uint32_t rates[HS_COUNTERS];
+
+    switch (pkt->tcp_flags & (TH_SYN | TH_ACK | TH_RST)) {
+    case TH_SYN:
+        // Retransmissões do mesmo SYN não contam de novo
+        if (!handshake_open(table, pkt->src_ip, pkt->src_port, pkt->dst_ip, pkt->dst_port, now)) return 0;
+        service = handshake_service(table, pkt->dst_ip, pkt->dst_port, 1);
+        handshake_count(service, HS_SYN, now);
+        break;
+    case TH_SYN | TH_ACK:
+        service = handshake_service(table, pkt->src_ip, pkt->src_port, 0);
+        if (service != NULL) handshake_count(service, HS_SYNACK, now);
+        return 0;
+    case TH_ACK:
+    case TH_RST:
+    case TH_RST | TH_ACK:
+        if (!handshake_close(table, pkt->src_ip, pkt->src_port, pkt->dst_ip, pkt->dst_port, now)) return 0;
+        service = handshake_service(table, pkt->dst_ip, pkt->dst_port, 0);
+        if (service != NULL) handshake_count(service, HS_DONE, now);
+        return 0;
+    default:
+        return 0;
+    }
+
+    handshake_rates(service, now, rates);
+    uint32_t half_open = rates[HS_SYN] > rates[HS_DONE] ? rates[HS_SYN] - rates[HS_DONE] : 0;
+    int unanswered = rates[HS_SYN] >= synflood_rate && rates[HS_SYN] > (uint64_t)rates[HS_SYNACK] * synflood_ratio;
+    uint64_t window = now / HANDSHAKE_WINDOW_NS + 1;
+
+    if ((half_open < synflood_rate && !unanswered) || service->alerted == window) return 0;
+
+    char dst_str[INET6_ADDRSTRLEN];
+    packet_address(pkt, 1, dst_str);
+    printf("[IDS] SYN FLOOD contra %s:%u (%u SYN/s, %u meio-abertos/s, %u SYN-ACK/s)!\n",
+           dst_str, pkt->dst_port, rates[HS_SYN], half_open, rates[HS_SYNACK]);
+    service->alerted = window;
+    return 1;
+}
+
+/**
+ * @brief Aplica um pacote decodificado ao estado do shard e monta o evento a publicar.
+ * * @param index Posição do suspeito obtida na fase de consulta, ou -1 se ausente.
+ * @param event Preenchido quando o pacote gera telemetria (event->proto != NULL).
  * @return Retorna 1 se um ataque foi detectado; 0 caso o tráfego seja benigno.
  */
-int analyze_packet(const u_char *packet, int length) {
-    // Executa a rotina de manutenção de memória antes da análise
-    cleanup_suspects();
+static int inspect_packet(IdsShard *shard, const DecodedPacket *pkt, int index, uint64_t now, IdsEvent *event) {
+    int live = shard->mode == SHARD_LIVE;
+
+    event->proto = NULL;
+
+    // Fluxos bidirecionais: todo pacote IPv4 conta, antes de qualquer decisão dos detectores
+    if (live && shard->flows.flows != NULL && !pkt->ipv6) {
+        flow_table_update(&shard->flows, pkt->src_ip, pkt->dst_ip, pkt->src_port, pkt->dst_port,
+                          pkt->proto, pkt->tcp_flags, pkt->length, now);
+    }
+
+    // Maiores emissores do intervalo: todo pacote IPv4 conta, rastreado ou não
+    if (live && topk_size > 0 && !pkt->ipv6) {
+        space_saving_add(&shard->top[TOP_PACKETS], pkt->src_ip, 1);
+        space_saving_add(&shard->top[TOP_BYTES], pkt->src_ip, (uint64_t)pkt->length);
+    }
+
+    // SYN flood: estado por destino, independente do rastreamento da origem
+    int syn_flood = live && pkt->proto == IPPROTO_TCP && handshakes_enabled() && track_handshake(shard, pkt, now);
+
+    // Port-unreachable de volta a uma origem rastreada confirma que ela sondou portas UDP
+    // fechadas; ao vivo a resposta nunca cria estado para o destino do ICMP. No modo
+    // forense a sondagem pode estar num arquivo processado por outro shard: a origem é
+    // criada aqui só com a contagem, e a mesclagem soma as respostas de todos os shards
+    if (pkt->unreachable && (enabled_detectors & DETECT_UDP_SCAN)) {
+        Ip6Key prober6 = ip6_key_mask(pkt->dst6, ipv6_prefix);
+        int prober = pkt->ipv6 ? find_suspect6(shard, prober6) : find_suspect(shard, pkt->dst_ip);
+        if (prober < 0 && !live) {
+            Suspect *pending = track_suspect(shard, pkt->ipv6 ? ip6_table_hash(prober6) : pkt->dst_ip,
+                                             pkt->ipv6 ? &prober6 : NULL, now);
+            pending->last_seen = 0;     // A resposta não é um pacote da origem
+            prober = shard->suspect_count - 1;
+        }
+        if (prober >= 0 && shard->suspects[prober].unreachable < UINT16_MAX) shard->suspects[prober].unreachable++;
+    }
+
+    // ---------------------------------------------------------
+    // RASTREAMENTO DE NOVOS DISPOSITIVOS
+    // ---------------------------------------------------------
+    // O primeiro contato admitido inicia o rastreamento (ao vivo, despejando outra
+    // origem se o orçamento estiver esgotado) e já é contabilizado pelos detectores:
+    // uma rajada contra uma entrada nova não perde o seu primeiro pacote.
+    Suspect *suspect = index >= 0 ? &shard->suspects[index] : NULL;
+    if (suspect == NULL) {
+        if (!admit_source(shard, pkt, now)) {
+            if (!syn_flood) return 0;
+            *event = ids_event(pkt->src_ip, pkt->dst_ip, pkt->dst_port, "TCP", pkt->length, SCAN_SYN_FLOOD, 0, 0);
+            return 1;
+        }
+        Ip6Key prefix = source_prefix(pkt);
+        suspect = track_suspect(shard, source_id(pkt), pkt->ipv6 ? &prefix : NULL, now);
+    } else if (suspect->credit < CREDIT_MAX) {
+        suspect->credit++;
+    }
 
-    // Salta os primeiros 14 bytes (Cabeçalho Ethernet) para acessar o Cabeçalho IP diretamente
-    struct ip *ip_header = (struct ip *)(packet + 14);
-    uint32_t src_ip = ip_header->ip_src.s_addr;
+    suspect->last_seen = now;
 
-    int is_scan = 0;
-    time_t now = time(NULL);
+    // ---------------------------------------------------------
+    // DESTINOS DISTINTOS (Detecção de Host Sweep)
+    // ---------------------------------------------------------
+    uint32_t hosts = 0;
+    int sweep = 0;
+    if ((pkt->proto == IPPROTO_TCP || pkt->proto == IPPROTO_ICMP) && (enabled_detectors & DETECT_HOST_SWEEP)) {
+        hosts = record_host(shard, suspect, pkt->dst_ip);
+        sweep = hosts >= sweep_threshold;
+    }
 
     // ---------------------------------------------------------
     // ANÁLISE DE TRÁFEGO ICMP (Detecção de Ping Flood)
     // ---------------------------------------------------------
-    if (ip_header->ip_p == IPPROTO_ICMP) {
-        for (int i = 0; i < suspect_count; i++) {
-            if (suspects[i].ip == src_ip) {
-                suspects[i].icmp_count++;
-                suspects[i].last_seen = now;
-
-                // Dispara o alerta caso a volumetria de ICMP ultrapasse o limite
-                if (suspects[i].icmp_count > ICMP_THRESHOLD) {
-                    printf("[IDS] ICMP FLOOD detectado da origem: %s!\n", inet_ntoa(ip_header->ip_src));
-                    publish_packet(inet_ntoa(ip_header->ip_src), 0, "ICMP", length, 1);
-                    return 1;
-                }
-                break;
+    if (pkt->proto == IPPROTO_ICMP && (enabled_detectors & DETECT_ICMP_FLOOD)) {
+        uint64_t pps, bps;
+
+        rate_window_add(&suspect->icmp, now, icmp_window_ns, (uint32_t)pkt->length);
+        window_rates(&suspect->icmp, icmp_window_ns, now, &pps, &bps);
+        if (pps > suspect->icmp_peak_pps) suspect->icmp_peak_pps = pps > UINT32_MAX ? UINT32_MAX : (uint32_t)pps;
+        if (bps > suspect->icmp_peak_bps) suspect->icmp_peak_bps = bps > UINT32_MAX ? UINT32_MAX : (uint32_t)bps;
+
+        // Dispara o alerta enquanto a taxa ICMP da janela ultrapassar algum dos limiares
+        if (pps > icmp_pps_threshold || bps > icmp_bps_threshold) {
+            if (live) {
+                char src_str[INET6_ADDRSTRLEN];
+                printf("[IDS] ICMP FLOOD detectado da origem: %s (%llu pacotes/s, %llu bytes/s)!\n",
+                       packet_address(pkt, 0, src_str), (unsigned long long)pps, (unsigned long long)bps);
+                *event = ids_event(pkt->src_ip, pkt->dst_ip, 0, "ICMP", pkt->length, SCAN_ICMP_FLOOD, 0, hosts);
             }
+            return 1;
         }
     }
 
     // ---------------------------------------------------------
-    // ANÁLISE DE TRÁFEGO TCP (Detecção de Port Scan)
+    // ANÁLISE DE TRÁFEGO UDP (Detecção de UDP Scan e UDP Flood)
     // ---------------------------------------------------------
-    if (ip_header->ip_p == IPPROTO_TCP) {
-        // Calcula o offset dinâmico do cabeçalho TCP (ip_hl indica palavras de 32 bits, multiplicamos por 4 via bitshift)
-        struct tcphdr *tcp_header = (struct tcphdr *)(packet + 14 + (ip_header->ip_hl << 2));
-        uint16_t dest_port = ntohs(tcp_header->th_dport);
-
-        for (int i = 0; i < suspect_count; i++) {
-            if (suspects[i].ip == src_ip) {
-                suspects[i].last_seen = now;
-
-                // Verifica se a porta de destino já foi registrada para este IP
-                int new_port = 1;
-                for (int j = 0; j < suspects[i].port_count; j++) {
-                    if (suspects[i].ports[j] == dest_port) {
-                        new_port = 0;
-                        break;
-                    }
-                }
+    if (pkt->proto == IPPROTO_UDP && (enabled_detectors & (DETECT_UDP_SCAN | DETECT_UDP_FLOOD))) {
+        ScanType type = SCAN_NONE;
+        uint32_t breadth = 0;
 
-                // Registra a nova porta caso o limite de rastreamento ainda não tenha sido atingido
-                if (new_port && suspects[i].port_count < SCAN_THRESHOLD) {
-                    suspects[i].ports[suspects[i].port_count++] = dest_port;
-                }
+        if (enabled_detectors & DETECT_UDP_FLOOD) {
+            uint64_t pps, bps;
 
-                // Sinaliza ataque se a contagem de portas únicas atingir o limiar
-                if (suspects[i].port_count >= SCAN_THRESHOLD) {
-                    is_scan = 1;
-                }
+            rate_window_add(&suspect->udp, now, UDP_WINDOW, (uint32_t)pkt->length);
+            window_rates(&suspect->udp, UDP_WINDOW, now, &pps, &bps);
+            if (pps > suspect->udp_peak_pps) suspect->udp_peak_pps = pps > UINT32_MAX ? UINT32_MAX : (uint32_t)pps;
+            if (bps > suspect->udp_peak_bps) suspect->udp_peak_bps = bps > UINT32_MAX ? UINT32_MAX : (uint32_t)bps;
 
-                // Publica a telemetria do pacote no broker de mensageria
-                publish_packet(inet_ntoa(ip_header->ip_src), dest_port, "TCP", length, is_scan);
-                return is_scan;
+            if (pps > udp_pps_threshold || bps > udp_bps_threshold) {
+                if (live) {
+                    char src_str[INET6_ADDRSTRLEN];
+                    printf("[IDS] UDP FLOOD detectado da origem: %s (%llu pacotes/s, %llu bytes/s)!\n",
+                           packet_address(pkt, 0, src_str), (unsigned long long)pps, (unsigned long long)bps);
+                }
+                type = SCAN_UDP_FLOOD;
             }
         }
+
+        // Sem handshake, a amplitude em portas UDP é o único sinal de sondagem. Respostas
+        // de um serviço (porta menor) para a porta efêmera do cliente não contam: um
+        // servidor DNS ou QUIC responde a milhares de portas sem sondar nenhuma
+        if (enabled_detectors & DETECT_UDP_SCAN) {
+            int reply = pkt->src_port < pkt->dst_port && pkt->dst_port >= UDP_EPHEMERAL_MIN;
+            if (!reply) record_port(shard, &suspect->udp_ports, pkt->dst_port);
+            breadth = port_set_count(&suspect->udp_ports);
+            if (type == SCAN_NONE && breadth >= udp_scan_limit(suspect)) type = SCAN_UDP;
+        }
+
+        if (live && type != SCAN_NONE) {
+            *event = ids_event(pkt->src_ip, pkt->dst_ip, pkt->dst_port, "UDP", pkt->length, type, breadth, 0);
+        }
+        return type != SCAN_NONE;
     }
 
     // ---------------------------------------------------------
-    // RASTREAMENTO DE NOVOS DISPOSITIVOS
+    // ANÁLISE DE TRÁFEGO TCP (Detecção de Port Scan e Stealth Scans)
     // ---------------------------------------------------------
-    // Caso seja o primeiro contato deste IP e haja espaço na memória, inicia o rastreamento
-    if (suspect_count < MAX_SUSPECTS) {
-        suspects[suspect_count].ip = src_ip;
-        suspects[suspect_count].last_seen = now;
-        suspect_count++;
+    if (pkt->proto == IPPROTO_TCP && (enabled_detectors & (DETECT_PORT_SCAN | DETECT_STEALTH | DETECT_SYN_FLOOD))) {
+        ScanType type = syn_flood ? SCAN_SYN_FLOOD : SCAN_NONE;
+        uint32_t breadth = 0;
+        int flag_class = STEALTH_NONE;
+
+        // NULL, FIN, Xmas e SYN/FIN não existem em conexões legítimas: poucos segmentos bastam
+        if (enabled_detectors & DETECT_STEALTH) {
+            flag_class = tcp_flag_class[pkt->tcp_flags];
+            if (flag_class != STEALTH_ACK) {
+                if (suspect->stealth[flag_class] < UINT16_MAX) suspect->stealth[flag_class]++;
+                if (type == SCAN_NONE && flag_class != STEALTH_NONE && suspect->stealth[flag_class] >= stealth_threshold) {
+                    type = stealth_scan_type[flag_class];
+                }
+            }
+        }
+
+        if (enabled_detectors & DETECT_PORT_SCAN) {
+            int fresh = record_port(shard, &suspect->ports, pkt->dst_port);
+            if (fresh && live && topk_size > 0 && !pkt->ipv6) space_saving_add(&shard->top[TOP_PORTS], pkt->src_ip, 1);
+
+            // Um ACK isolado só conta quando abre uma porta nova para a origem: numa
+            // conexão legítima o SYN ou o SYN/ACK sempre chega antes a essa porta. No
+            // modo forense a ordem entre shards se perde e valem os conjuntos de AckPorts
+            if (!live) {
+                if (enabled_detectors & DETECT_STEALTH) record_ack_port(shard, suspect, pkt->dst_port, flag_class == STEALTH_ACK);
+            } else if (fresh && flag_class == STEALTH_ACK && suspect->stealth[STEALTH_ACK] < UINT16_MAX) {
+                suspect->stealth[STEALTH_ACK]++;
+            }
+
+            // Sinaliza ataque se a contagem de portas únicas atingir o limiar; ACKs
+            // isolados em tantas portas caracterizam o mapeamento de firewall (ACK scan)
+            breadth = port_set_count(&suspect->ports);
+            if (type == SCAN_NONE && breadth >= scan_threshold) {
+                type = flag_class == STEALTH_ACK && suspect->stealth[STEALTH_ACK] >= scan_threshold ? SCAN_ACK : SCAN_PORT;
+            }
+        }
+
+        if (type == SCAN_NONE && sweep) type = SCAN_HOST_SWEEP;
+
+        // Telemetria do pacote para o broker de mensageria; com a tabela de fluxos
+        // ligada, o tráfego benigno segue só nos registros de fluxo
+        if (live && (type != SCAN_NONE || shard->flows.flows == NULL)) {
+            *event = ids_event(pkt->src_ip, pkt->dst_ip, pkt->dst_port, "TCP", pkt->length, type, breadth, hosts);
+        }
+        return type != SCAN_NONE;
+    }
+
+    // Varredura horizontal sem outro detector disparado (Ex: ping sweep)
+    if (sweep) {
+        if (live) {
+            const char *proto = pkt->proto == IPPROTO_TCP ? "TCP" : "ICMP";
+            *event = ids_event(pkt->src_ip, pkt->dst_ip, pkt->dst_port, proto, pkt->length, SCAN_HOST_SWEEP, 0, hosts);
+        }
+        return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Completa o evento com o túnel de origem e, num pacote IPv6, com os endereços de 128 bits.
+ * * Os detectores montam os eventos só com os campos IPv4; aqui entram o túnel
+ * decapsulado, os endereços completos e o protocolo "ICMPv6".
+ */
+static void complete_event(IdsEvent *event, const DecodedPacket *pkt) {
+    if (event->proto == NULL) return;
+
+    event->tunnel = pkt->tunnel;
+    event->tunnel_id = pkt->tunnel_id;
+    if (!pkt->ipv6) return;
+
+    event->ipv6 = 1;
+    ip6_key_bytes(pkt->src6, event->src6);
+    ip6_key_bytes(pkt->dst6, event->dst6);
+    if (pkt->proto == IPPROTO_ICMP) event->proto = "ICMPv6";
+}
+
+/**
+ * @brief Analisa pacotes de rede interceptados em busca de anomalias e ataques.
+ * * Inspeciona os cabeçalhos das camadas de Enlace (decodificador do shard), Rede (IP) e Transporte
+ * para identificar assinaturas de comportamento malicioso (Ex: Port Scan, ICMP Flood).
+ * * @param shard Fatia de estado do IDS pertencente ao worker chamador.
+ * @param packet Buffer contendo os bytes brutos do pacote interceptado.
+ * @param caplen Bytes efetivamente capturados (limite de leitura do buffer).
+ * @param length Tamanho original do pacote no fio (reportado na telemetria).
+ * @param ts_ns Timestamp de captura em ns (0 = indisponível, usa o relógio grosso).
+ * @return Retorna 1 se um ataque foi detectado; 0 caso o tráfego seja benigno.
+ */
+int analyze_packet_shard(IdsShard *shard, const u_char *packet, int caplen, int length, uint64_t ts_ns) {
+    DecodedPacket pkt;
+    IdsEvent event;
+    uint64_t now = ts_ns ? ts_ns : coarse_clock_ns();
+
+    // Avança a roda de expiração (e o intervalo do resumo top-K) até o instante do pacote
+    if (shard->mode == SHARD_LIVE) advance_live_clock(shard, now);
+
+    if (!shard->decode(packet, caplen, length, &pkt)) return 0;
+
+    int result = inspect_packet(shard, &pkt, find_source(shard, &pkt), now, &event);
+    complete_event(&event, &pkt);
+
+    // Publica a telemetria do pacote e os fluxos encerrados no broker de mensageria
+    if (event.proto != NULL) publish_events(&event, 1);
+    if (shard->flows.flows != NULL) flow_table_flush(&shard->flows);
+    return result;
+}
+
+/**
+ * @brief Analisa um vetor de pacotes em três fases para preservar a localidade de cache.
+ * * 1) decodifica os cabeçalhos de todo o lote para um vetor compacto;
+ * 2) localiza (com prefetch) as entradas de todos os IPs de origem;
+ * 3) aplica os pacotes em ordem e publica os eventos do lote de uma só vez.
+ * O resultado é idêntico ao de chamar analyze_packet_shard() pacote a pacote.
+ * Cada pacote usa o próprio ts_ns; o relógio grosso só é lido (uma vez por
+ * lote) quando o backend não informa o timestamp.
+ * * @param pkts Referências para os pacotes (o buffer deve permanecer válido até o retorno).
+ * @param count Quantidade de pacotes; lotes maiores que ANALYZE_BATCH_MAX são fatiados.
+ * @return Quantidade de pacotes que sinalizaram ataque.
+ */
+int analyze_batch_shard(IdsShard *shard, const PacketRef *pkts, size_t count) {
+    DecodedPacket decoded[ANALYZE_BATCH_MAX];
+    uint32_t hash[ANALYZE_BATCH_MAX];
+    Ip6Key prefix[ANALYZE_BATCH_MAX];
+    int index[ANALYZE_BATCH_MAX];
+    IdsEvent events[ANALYZE_BATCH_MAX];
+    uint64_t fallback = 0;
+    int attacks = 0;
+
+    for (size_t base = 0; base < count; base += ANALYZE_BATCH_MAX) {
+        size_t n = count - base < ANALYZE_BATCH_MAX ? count - base : ANALYZE_BATCH_MAX;
+        size_t pending = 0;
+        unsigned int generation;
+
+        // Fase 1: decodificação de todos os cabeçalhos do lote (kernel vetorial + decodificador de enlace)
+        decode_batch(shard->decode, shard->kernel, &shard->kernel_backoff, &pkts[base], n, decoded);
+
+        // Fase 2: hash de todas as origens e prefetch dos slots do índice da família; em
+        // seguida a consulta, trazendo as entradas do pool para o cache antes da fase 3
+        for (size_t i = 0; i < n; i++) {
+            if (!decoded[i].proto) continue;
+            if (decoded[i].ipv6) {
+                prefix[i] = source_prefix(&decoded[i]);
+                hash[i] = ip6_table_hash(prefix[i]);
+                ip6_table_prefetch(&shard->index6, hash[i]);
+            } else {
+                hash[i] = ip_table_hash(decoded[i].src_ip);
+                ip_table_prefetch(&shard->index, hash[i]);
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (!decoded[i].proto) {
+                index[i] = -1;
+                continue;
+            }
+            index[i] = decoded[i].ipv6 ? ip6_table_find_hashed(&shard->index6, prefix[i], hash[i])
+                                       : ip_table_find_hashed(&shard->index, decoded[i].src_ip, hash[i]);
+            if (index[i] >= 0) __builtin_prefetch(&shard->suspects[index[i]], 1);
+        }
+        generation = shard->generation;
+
+        // Fase 3: aplicação em ordem. Um IP ausente na fase 2 pode ter sido inserido
+        // por um pacote anterior do mesmo lote, então é consultado de novo; o mesmo
+        // vale para todos os índices depois de qualquer remoção (expiração ou despejo),
+        // que move entradas dentro do pool.
+        for (size_t i = 0; i < n; i++) {
+            uint64_t now = pkts[base + i].ts_ns;
+            if (now == 0) now = fallback ? fallback : (fallback = coarse_clock_ns());
+
+            // A expiração segue o timestamp de cada pacote, como no caminho por pacote
+            if (shard->mode == SHARD_LIVE) advance_live_clock(shard, now);
+            if (!decoded[i].proto) continue;
+
+            int stale = index[i] < 0 || shard->generation != generation;
+            int slot = stale ? find_source(shard, &decoded[i]) : index[i];
+            attacks += inspect_packet(shard, &decoded[i], slot, now, &events[pending]);
+            complete_event(&events[pending], &decoded[i]);
+            if (events[pending].proto != NULL) pending++;
+        }
+
+        if (pending > 0) publish_events(events, pending);
+        if (shard->flows.flows != NULL) flow_table_flush(&shard->flows);
+    }
+
+    return attacks;
+}
+
+/**
+ * @brief Reinicia as janelas de taxa de todas as origens (início de um novo arquivo no modo batch).
+ * * Os picos de taxa continuam guardados. Como cada arquivo é medido de forma
+ * independente, o resultado não depende de qual thread processou qual arquivo
+ * (uma rajada dividida entre dois arquivos rotacionados é medida em cada metade).
+ */
+void restart_rate_windows(IdsShard *shard) {
+    for (int i = 0; i < shard->suspect_count; i++) {
+        memset(&shard->suspects[i].icmp, 0, sizeof(RateWindow));
+        memset(&shard->suspects[i].udp, 0, sizeof(RateWindow));
+    }
+}
+
+/**
+ * @brief Shard do modo single-thread, criado no primeiro uso com o orçamento inteiro.
+ */
+IdsShard *get_default_shard(void) {
+    if (default_shard == NULL) default_shard = create_ids_shard(SHARD_LIVE, tracker_budget);
+    return default_shard;
+}
+
+/**
+ * @brief Exporta a ocupação do rastreador e os contadores de despejo do shard.
+ */
+void get_tracker_stats(const IdsShard *shard, TrackerStats *stats) {
+    stats->tracked = (unsigned long long)shard->suspect_count;
+    stats->capacity = (unsigned long long)shard->capacity;
+    stats->memory_bytes = (unsigned long long)shard->capacity * sizeof(Suspect)
+                        + (unsigned long long)(shard->index.mask + 1) * sizeof(IpSlot)
+                        + (shard->index6.slots != NULL ? (unsigned long long)(shard->index6.mask + 1) * sizeof(Ip6Slot) : 0)
+                        + (shard->mode == SHARD_LIVE ? (unsigned long long)shard->capacity * sizeof(WheelLink) : 0)
+                        + (shard->admission.counters[0] != NULL ? count_min_bytes() : 0)
+                        + (shard->handshakes.pending != NULL ? handshake_bytes() : 0);
+    for (int m = 0; m < TOP_METRICS; m++) {
+        if (shard->top[m].heap == NULL) continue;
+        stats->memory_bytes += (unsigned long long)shard->top[m].capacity * sizeof(SpaceSavingEntry)
+                             + (unsigned long long)(shard->top[m].index.mask + 1) * sizeof(IpSlot);
+    }
+    stats->flows = 0;
+    stats->flows_exported = 0;
+    if (shard->flows.flows != NULL) {
+        stats->flows = (unsigned long long)shard->flows.count;
+        for (int r = 0; r < FLOW_END_COUNT; r++) stats->flows_exported += shard->flows.exported[r];
+    }
+    stats->evictions = shard->evictions;
+    stats->evictions_pressure = shard->evictions_pressure;
+    stats->evictions_suspects = shard->evictions_suspects;
+    stats->expirations = shard->expirations;
+    stats->admission_held = shard->admission_held;
+    stats->admission_promoted = shard->admission_promoted;
+    stats->set_bytes = shard->set_bytes;
+}
+
+/**
+ * @brief Imprime uma linha com a ocupação e os despejos do rastreador.
+ * * @param tag Prefixo da linha (Ex: "TRACKER", "TRACKER w2").
+ */
+void print_tracker_stats(const char *tag, const IdsShard *shard) {
+    TrackerStats stats;
+    get_tracker_stats(shard, &stats);
+
+    printf("[%s] %llu/%llu origens (%.1f MiB + %.1f MiB em conjuntos e sketches) | expiradas=%llu | despejos=%llu (sob pressão=%llu, suspeitos=%llu) | admissão: %llu promovidas, %llu pacotes retidos\n",
+           tag, stats.tracked, stats.capacity, (double)stats.memory_bytes / (1 << 20),
+           (double)stats.set_bytes / (1 << 20), stats.expirations,
+           stats.evictions, stats.evictions_pressure, stats.evictions_suspects,
+           stats.admission_promoted, stats.admission_held);
+
+    if (shard->flows.flows != NULL) {
+        const unsigned long long *exported = shard->flows.exported;
+        printf("[%s] fluxos: %llu/%d abertos (%.1f MiB) | exportados=%llu (inativos=%llu, ativos=%llu, fin=%llu, rst=%llu, despejados=%llu, fim=%llu)\n",
+               tag, stats.flows, shard->flows.capacity, (double)flow_table_bytes(&shard->flows) / (1 << 20), stats.flows_exported,
+               exported[FLOW_END_IDLE], exported[FLOW_END_ACTIVE], exported[FLOW_END_FIN],
+               exported[FLOW_END_RST], exported[FLOW_END_EVICTED], exported[FLOW_END_SHUTDOWN]);
+    }
+}
+
+/**
+ * @brief Ponto de entrada single-thread: analisa o pacote usando o shard padrão.
+ */
+int analyze_packet(const u_char *packet, int caplen, int length, uint64_t ts_ns) {
+    return analyze_packet_shard(get_default_shard(), packet, caplen, length, ts_ns);
+}
+
+/**
+ * @brief Ponto de entrada single-thread do modo em lote (shard padrão).
+ */
+int analyze_batch(const PacketRef *pkts, size_t count) {
+    return analyze_batch_shard(get_default_shard(), pkts, count);
+}
+
+/**
+ * @brief Menor snaplen que ainda entrega aos detectores ativos tudo o que eles leem.
+ * * Usado para validar o perfil "somente cabeçalhos": um snaplen menor que este
+ * valor faria os detectores descartarem pacotes truncados. O snaplen é fixado
+ * antes de o tipo de enlace ser conhecido, então vale o maior cabeçalho de
+ * enlace suportado (Linux cooked v2) mais as tags VLAN; cada nível de túnel
+ * acrescenta um cabeçalho IP externo e o maior encapsulamento (ERSPAN III).
+ */
+int required_snaplen(unsigned int detectors) {
+    // Com o IPv6 ligado, o maior cabeçalho de rede e a maior citação ICMP são os do IPv6
+    int ip_header = ipv6_prefix > 0 ? IPV6_HEADROOM : IP_MAX_HEADER;
+    int l3 = SLL2_HEADER_LEN + VLAN_HEADROOM + (int)tunnel_depth * (ip_header + TUNNEL_HEADROOM) + ip_header;
+    int quote_end = ipv6_prefix > 0 ? ICMP6_QUOTE_END : ICMP_QUOTE_END;
+    int needed = l3;
+
+    if ((detectors & (DETECT_PORT_SCAN | DETECT_STEALTH | DETECT_SYN_FLOOD)) && needed < l3 + TCP_MIN_HEADER) needed = l3 + TCP_MIN_HEADER;
+    if (flow_budget > 0 && needed < l3 + TCP_MIN_HEADER) needed = l3 + TCP_MIN_HEADER;
+    if ((detectors & DETECT_ICMP_FLOOD) && needed < l3 + ICMP_MIN_HEADER) needed = l3 + ICMP_MIN_HEADER;
+    if ((detectors & DETECT_UDP_SCAN) && needed < l3 + quote_end) needed = l3 + quote_end;
+    return needed;
+}
+
+/* ========================================================================= *
+ * MESCLAGEM DE ESTADO (MODO BATCH)                                          *
+ * ========================================================================= */
+
+/**
+ * @brief Ordem das origens: IPv4 em ordem crescente, depois os prefixos IPv6.
+ */
+static int compare_suspects(const void *a, const void *b) {
+    const Suspect *sa = a, *sb = b;
+
+    if (sa->ipv6 != sb->ipv6) return sa->ipv6 - sb->ipv6;
+    if (sa->ipv6) {
+        if (sa->ip6.hi != sb->ip6.hi) return sa->ip6.hi < sb->ip6.hi ? -1 : 1;
+        return (sa->ip6.lo > sb->ip6.lo) - (sa->ip6.lo < sb->ip6.lo);
+    }
+
+    uint32_t ia = ntohl(sa->ip);
+    uint32_t ib = ntohl(sb->ip);
+    return (ia > ib) - (ia < ib);
+}
+
+/**
+ * @brief Combina o estado de dois suspeitos com o mesmo IP.
+ * * Todas as operações são comutativas e associativas (união de portas, máximo
+ * por registrador do sketch, soma saturada das classes de flags e dos
+ * port-unreachables, máximo dos picos ICMP/UDP e de last_seen), então o
+ * resultado independe da ordem da mesclagem. A união de portas é exata e o
+ * sketch mesclado é idêntico ao de uma passada serial. Só se somam contagens
+ * de segmentos; o que depende de pertinência a um conjunto (o ACK scan) é
+ * mesclado por união e contado no relatório.
+ */
+static void merge_suspect(Suspect *dst, const Suspect *src) {
+    port_set_union(&dst->ports, &src->ports);
+    port_set_union(&dst->udp_ports, &src->udp_ports);
+    if (src->ack_ports != NULL) {
+        if (dst->ack_ports == NULL) dst->ack_ports = calloc(1, sizeof(AckPorts));
+        port_set_union(&dst->ack_ports->lone, &src->ack_ports->lone);
+        port_set_union(&dst->ack_ports->other, &src->ack_ports->other);
+    }
+    hll_merge(&dst->hosts, &src->hosts);
+    for (int c = 0; c < STEALTH_CLASSES; c++) {
+        uint32_t total = (uint32_t)dst->stealth[c] + src->stealth[c];
+        dst->stealth[c] = total > UINT16_MAX ? UINT16_MAX : (uint16_t)total;
+    }
+    if (src->icmp_peak_pps > dst->icmp_peak_pps) dst->icmp_peak_pps = src->icmp_peak_pps;
+    if (src->icmp_peak_bps > dst->icmp_peak_bps) dst->icmp_peak_bps = src->icmp_peak_bps;
+    if (src->udp_peak_pps > dst->udp_peak_pps) dst->udp_peak_pps = src->udp_peak_pps;
+    if (src->udp_peak_bps > dst->udp_peak_bps) dst->udp_peak_bps = src->udp_peak_bps;
+    uint32_t unreachable = (uint32_t)dst->unreachable + src->unreachable;
+    dst->unreachable = unreachable > UINT16_MAX ? UINT16_MAX : (uint16_t)unreachable;
+    if (src->last_seen > dst->last_seen) dst->last_seen = src->last_seen;
+}
+
+/**
+ * @brief Mescla o shard src dentro de dst; dst termina ordenado por IP.
+ * * Ordena ambos os lados e faz um merge linear, evitando a busca O(n) por IP.
+ * As entradas de src são transferidas para dst, e src termina vazio.
+ */
+void merge_ids_shard(IdsShard *dst, IdsShard *src) {
+    qsort(dst->suspects, (size_t)dst->suspect_count, sizeof(Suspect), compare_suspects);
+    qsort(src->suspects, (size_t)src->suspect_count, sizeof(Suspect), compare_suspects);
+    reindex_suspects(src);
+
+    int capacity = dst->suspect_count + src->suspect_count;
+    Suspect *merged = malloc((size_t)(capacity > 0 ? capacity : 1) * sizeof(Suspect));
+    int i = 0, j = 0, n = 0;
+
+    while (i < dst->suspect_count || j < src->suspect_count) {
+        int cmp = i == dst->suspect_count ? 1
+                : j == src->suspect_count ? -1
+                : compare_suspects(&dst->suspects[i], &src->suspects[j]);
+
+        if (cmp < 0) {
+            merged[n++] = dst->suspects[i++];
+        } else if (cmp > 0) {
+            merged[n++] = src->suspects[j++];
+        } else {
+            merged[n] = dst->suspects[i++];
+            merge_suspect(&merged[n++], &src->suspects[j]);
+            port_set_free(&src->suspects[j].ports);
+            port_set_free(&src->suspects[j].udp_ports);
+            free_ack_ports(&src->suspects[j]);
+            hll_free(&src->suspects[j++].hosts);
+        }
+    }
+
+    src->suspect_count = 0;
+    reindex_suspects(src);
+
+    // Pares exatos da auditoria do sketch apenas se acumulam
+    if (src->audit_count > 0) {
+        dst->audit_pairs = realloc(dst->audit_pairs, (dst->audit_count + src->audit_count) * sizeof(uint64_t));
+        memcpy(dst->audit_pairs + dst->audit_count, src->audit_pairs, src->audit_count * sizeof(uint64_t));
+        dst->audit_count += src->audit_count;
+        dst->audit_capacity = dst->audit_count;
+        src->audit_count = 0;
+    }
+
+    free(dst->suspects);
+    dst->suspects = merged;
+    dst->suspect_count = n;
+    dst->capacity = capacity > 0 ? capacity : 1;
+    reindex_suspects(dst);
+}
+
+static int compare_pairs(const void *a, const void *b) {
+    uint64_t pa = *(const uint64_t *)a, pb = *(const uint64_t *)b;
+    return (pa > pb) - (pa < pb);
+}
+
+/**
+ * @struct AuditError
+ * @brief Acumulador do erro relativo |estimado - exato| / exato de um grupo de origens.
+ */
+typedef struct {
+    unsigned long sources;
+    double sum;
+    double sum_sq;
+    double max;
+} AuditError;
+
+static void audit_add(AuditError *error, uint32_t exact, uint32_t estimate) {
+    double relative = fabs((double)estimate - (double)exact) / exact;
+
+    error->sources++;
+    error->sum += relative;
+    error->sum_sq += relative * relative;
+    if (relative > error->max) error->max = relative;
+}
+
+static void audit_print(const char *label, const AuditError *error) {
+    if (error->sources == 0) return;
+
+    printf("[HLL] %-22s %8lu origens | erro médio %5.2f%% | RMS %5.2f%% | máximo %6.2f%%\n",
+           label, error->sources, 100.0 * error->sum / error->sources,
+           100.0 * sqrt(error->sum_sq / error->sources), 100.0 * error->max);
+}
+
+/**
+ * @brief Compara o sketch de destinos de cada origem com a contagem exata (--sketch-audit).
+ * * Os pares (origem, destino) são ordenados e deduplicados; o erro é reportado
+ * para todas as origens e separadamente para as que passaram de HLL_REGISTERS
+ * destinos, onde a contagem linear dá lugar à estimativa harmônica e o erro
+ * esperado se aproxima de 1,04/sqrt(m).
+ */
+static void audit_host_sketches(IdsShard *shard) {
+    AuditError all = {0}, large = {0};
+
+    qsort(shard->audit_pairs, shard->audit_count, sizeof(uint64_t), compare_pairs);
+
+    for (size_t i = 0; i < shard->audit_count;) {
+        uint32_t src = (uint32_t)(shard->audit_pairs[i] >> 32);
+        uint32_t exact = 0;
+
+        for (uint64_t previous = ~0ull; i < shard->audit_count && (uint32_t)(shard->audit_pairs[i] >> 32) == src; i++) {
+            if (shard->audit_pairs[i] != previous) exact++;
+            previous = shard->audit_pairs[i];
+        }
+
+        int index = find_suspect(shard, htonl(src));
+        if (index < 0) continue;
+
+        uint32_t estimate = hll_count(&shard->suspects[index].hosts);
+        audit_add(&all, exact, estimate);
+        if (exact >= HLL_REGISTERS) audit_add(&large, exact, estimate);
+    }
+
+    printf("[HLL] Auditoria do sketch de destinos (p=%d, %d registradores, erro padrão teórico %.1f%%):\n",
+           HLL_PRECISION, HLL_REGISTERS, 104.0 / sqrt(HLL_REGISTERS));
+    audit_print("todas as origens:", &all);
+    audit_print(">= 256 destinos:", &large);
+}
+
+/**
+ * @brief Publica um alerta do relatório final; origens IPv6 saem com o prefixo agregado.
+ */
+static void publish_report_event(const Suspect *suspect, IdsEvent event) {
+    if (suspect->ipv6) {
+        event.ipv6 = 1;
+        ip6_key_bytes(suspect->ip6, event.src6);
+        if (strcmp(event.proto, "ICMP") == 0) event.proto = "ICMPv6";
+    }
+    publish_events(&event, 1);
+}
+
+/**
+ * @brief Emite os alertas finais de um shard mesclado, em ordem crescente de IP.
+ * * As origens IPv6 vêm depois das IPv4 e são impressas como prefixo (Ex: 2001:db8:1:2::/64).
+ * @return Quantidade de alertas emitidos.
+ */
+int report_ids_shard(IdsShard *shard) {
+    char src_str[INET6_ADDRSTRLEN + 4];
+    int alerts = 0;
+
+    qsort(shard->suspects, (size_t)shard->suspect_count, sizeof(Suspect), compare_suspects);
+    reindex_suspects(shard);
+
+    for (int i = 0; i < shard->suspect_count; i++) {
+        const Suspect *suspect = &shard->suspects[i];
+
+        if (suspect->ipv6) {
+            uint8_t bytes[16];
+            ip6_key_bytes(suspect->ip6, bytes);
+            inet_ntop(AF_INET6, bytes, src_str, INET6_ADDRSTRLEN);
+            if (ipv6_prefix < 128) snprintf(src_str + strlen(src_str), 5, "/%u", ipv6_prefix);
+        } else {
+            inet_ntop(AF_INET, &suspect->ip, src_str, sizeof(src_str));
+        }
+
+        uint32_t breadth = port_set_count(&suspect->ports);
+        if (breadth >= scan_threshold) {
+            printf("[IDS] PORT SCAN: %s (varreu %u portas distintas, último pacote em %ld)\n",
+                   src_str, breadth, (long)(suspect->last_seen / NSEC_PER_SEC));
+            publish_report_event(suspect, ids_event(suspect->ip, 0, 0, "TCP", 0, SCAN_PORT, breadth, 0));
+            alerts++;
+        }
+        for (int c = STEALTH_NULL; c < STEALTH_CLASSES; c++) {
+            unsigned int threshold = c == STEALTH_ACK ? scan_threshold : stealth_threshold;
+            uint32_t segments = c == STEALTH_ACK && shard->mode == SHARD_FORENSIC ? ack_scan_ports(suspect) : suspect->stealth[c];
+            if (segments < threshold || (c == STEALTH_ACK && breadth < scan_threshold)) continue;
+
+            printf("[IDS] %s: %s (%u segmentos, último pacote em %ld)\n",
+                   scan_type_label(stealth_scan_type[c]), src_str, segments,
+                   (long)(suspect->last_seen / NSEC_PER_SEC));
+            publish_report_event(suspect, ids_event(suspect->ip, 0, 0, "TCP", 0, stealth_scan_type[c], breadth, 0));
+            alerts++;
+        }
+        uint32_t hosts = hll_count(&suspect->hosts);
+        if (hosts >= sweep_threshold) {
+            printf("[IDS] HOST SWEEP: %s (~%u destinos distintos, último pacote em %ld)\n",
+                   src_str, hosts, (long)(suspect->last_seen / NSEC_PER_SEC));
+            publish_report_event(suspect, ids_event(suspect->ip, 0, 0, "TCP", 0, SCAN_HOST_SWEEP, 0, hosts));
+            alerts++;
+        }
+        if (suspect->icmp_peak_pps > icmp_pps_threshold || suspect->icmp_peak_bps > icmp_bps_threshold) {
+            printf("[IDS] ICMP FLOOD: %s (pico de %u pacotes/s e %u bytes/s, último pacote em %ld)\n",
+                   src_str, suspect->icmp_peak_pps, suspect->icmp_peak_bps, (long)(suspect->last_seen / NSEC_PER_SEC));
+            publish_report_event(suspect, ids_event(suspect->ip, 0, 0, "ICMP", 0, SCAN_ICMP_FLOOD, 0, 0));
+            alerts++;
+        }
+        uint32_t udp_breadth = port_set_count(&suspect->udp_ports);
+        if (udp_breadth >= udp_scan_limit(suspect)) {
+            printf("[IDS] UDP SCAN: %s (varreu %u portas UDP distintas, %u port-unreachable, último pacote em %ld)\n",
+                   src_str, udp_breadth, suspect->unreachable, (long)(suspect->last_seen / NSEC_PER_SEC));
+            publish_report_event(suspect, ids_event(suspect->ip, 0, 0, "UDP", 0, SCAN_UDP, udp_breadth, 0));
+            alerts++;
+        }
+        if (suspect->udp_peak_pps > udp_pps_threshold || suspect->udp_peak_bps > udp_bps_threshold) {
+            printf("[IDS] UDP FLOOD: %s (pico de %u pacotes/s e %u bytes/s, último pacote em %ld)\n",
+                   src_str, suspect->udp_peak_pps, suspect->udp_peak_bps, (long)(suspect->last_seen / NSEC_PER_SEC));
+            publish_report_event(suspect, ids_event(suspect->ip, 0, 0, "UDP", 0, SCAN_UDP_FLOOD, 0, 0));
+            alerts++;
+        }
+    }
+
+    if (sketch_audit && shard->mode == SHARD_FORENSIC) audit_host_sketches(shard);
+    return alerts;
+}
@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/count_min.h"
+
+/* ========================================================================= *
+ * COUNT-MIN SKETCH (ESTÁGIO DE HEAVY HITTERS)                               *
+ * ========================================================================= *
+ * Memória fixa para contar pacotes de um número ilimitado de chaves. Cada   *
+ * linha usa um hash multiplicativo independente; a estimativa é o menor     *
+ * contador entre as linhas, que só pode superestimar por colisões.          */
+
+// Multiplicadores ímpares (multiply-shift) de cada linha
+static const uint32_t row_seeds[CMS_DEPTH] = { 0x9e3779b1u, 0x85ebca77u, 0xc2b2ae3du, 0x27d4eb2fu };
+
+void count_min_init(CountMinSketch *sketch, uint64_t window_ns) {
+    for (int g = 0; g < 2; g++) {
+        sketch->counters[g] = calloc(CMS_DEPTH * CMS_WIDTH, sizeof(uint16_t));
+        sketch->total[g] = 0;
+    }
+    sketch->current = 0;
+    sketch->epoch = 0;
+    sketch->window_ns = window_ns;
+}
+
+void count_min_free(CountMinSketch *sketch) {
+    for (int g = 0; g < 2; g++) {
+        free(sketch->counters[g]);
+        sketch->counters[g] = NULL;
+    }
+}
+
+/**
+ * @brief Gira as gerações quando now entra numa janela posterior à corrente.
+ */
+static void rotate(CountMinSketch *sketch, uint64_t now) {
+    uint64_t epoch = now / sketch->window_ns;
+    if (epoch <= sketch->epoch) return;
+
+    // Janela adjacente: a corrente vira a anterior; um salto maior zera as duas
+    if (epoch == sketch->epoch + 1) {
+        sketch->current ^= 1;
+    } else {
+        memset(sketch->counters[sketch->current ^ 1], 0, CMS_DEPTH * CMS_WIDTH * sizeof(uint16_t));
+        sketch->total[sketch->current ^ 1] = 0;
+    }
+    memset(sketch->counters[sketch->current], 0, CMS_DEPTH * CMS_WIDTH * sizeof(uint16_t));
+    sketch->total[sketch->current] = 0;
+    sketch->epoch = epoch;
+}
+
+/**
+ * @brief Conta mais uma ocorrência de key e devolve a estimativa atualizada.
+ * * Usa atualização conservadora: só os contadores iguais ao mínimo sobem, o
+ * que reduz a superestimativa causada por colisões. Os índices das linhas são
+ * calculados num laço de tamanho fixo, sem dependências, que o compilador
+ * vetoriza (multiplicação de 32 bits e shift em todas as linhas de uma vez).
+ * @param key Chave já misturada (Ex: hash da origem combinado ao protocolo).
+ */
+uint32_t count_min_add(CountMinSketch *sketch, uint32_t key, uint64_t now) {
+    uint32_t column[CMS_DEPTH];
+    uint32_t minimum = UINT16_MAX, previous_minimum = UINT16_MAX;
+
+    rotate(sketch, now);
+    uint16_t *current = sketch->counters[sketch->current];
+    const uint16_t *previous = sketch->counters[sketch->current ^ 1];
+
+    for (int row = 0; row < CMS_DEPTH; row++) {
+        column[row] = (uint32_t)row * CMS_WIDTH + ((key * row_seeds[row]) >> (32 - CMS_WIDTH_BITS));
+    }
+
+    for (int row = 0; row < CMS_DEPTH; row++) {
+        if (current[column[row]] < minimum) minimum = current[column[row]];
+        if (previous[column[row]] < previous_minimum) previous_minimum = previous[column[row]];
+    }
+
+    if (sketch->total[sketch->current] < UINT32_MAX) sketch->total[sketch->current]++;
+    if (minimum < UINT16_MAX) {
+        for (int row = 0; row < CMS_DEPTH; row++) {
+            if (current[column[row]] == minimum) current[column[row]] = (uint16_t)(minimum + 1);
+        }
+        minimum++;
+    }
+
+    return minimum + previous_minimum;
+}
@@ -0,0 +1,321 @@
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "../../include/flow_table.h"
+
+/* ========================================================================= *
+ * TABELA DE FLUXOS BIDIRECIONAIS                                            *
+ * ========================================================================= *
+ * Um fluxo é a 5-tupla (ips, portas, protocolo) sem orientação: o hash é    *
+ * calculado sobre os extremos em ordem canônica, então pacote e resposta    *
+ * caem no mesmo slot. O registro guarda a orientação do primeiro pacote     *
+ * (sentido 0) e acumula pacotes, bytes e flags por sentido até ser          *
+ * exportado por inatividade, tempo ativo, FIN/RST ou falta de espaço.       */
+
+#define FLOW_LINGER_NS  (1ull * 1000000000ull)  // Espera após FIN/RST por retransmissões e ACKs finais
+#define FLOW_EXPIRE_MAX 16                      // Prazos processados por chamada (custo limitado por pacote)
+#define FLOW_CLOCK_SCAN 8                       // Fluxos examinados pelo relógio antes de escolher a vítima
+#define FLOW_MIN_SLOTS  64
+
+static uint64_t fmix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Hash simétrico da 5-tupla: (a, b) e (b, a) produzem o mesmo valor.
+ */
+static uint32_t flow_hash(uint32_t a_ip, uint16_t a_port, uint32_t b_ip, uint16_t b_port, uint8_t proto) {
+    uint64_t a = (uint64_t)a_ip << 16 | a_port;
+    uint64_t b = (uint64_t)b_ip << 16 | b_port;
+    uint64_t lo = a < b ? a : b, hi = a < b ? b : a;
+    uint64_t h = fmix64(lo ^ fmix64(hi ^ (uint64_t)proto << 56));
+
+    return (uint32_t)(h >> 32) ^ (uint32_t)h;
+}
+
+static uint32_t record_hash(const FlowRecord *flow) {
+    return flow_hash(flow->src_ip, flow->src_port, flow->dst_ip, flow->dst_port, flow->proto);
+}
+
+/**
+ * @brief Sentido do pacote em relação ao fluxo.
+ * @return 0 (iniciador -> respondedor), 1 (resposta) ou -1 se a 5-tupla é outra.
+ */
+static int flow_direction(const FlowRecord *flow, uint32_t src_ip, uint32_t dst_ip,
+                          uint16_t src_port, uint16_t dst_port, uint8_t proto) {
+    if (flow->proto != proto) return -1;
+    if (flow->src_ip == src_ip && flow->dst_ip == dst_ip && flow->src_port == src_port && flow->dst_port == dst_port) return 0;
+    if (flow->src_ip == dst_ip && flow->dst_ip == src_ip && flow->src_port == dst_port && flow->dst_port == src_port) return 1;
+    return -1;
+}
+
+/**
+ * @brief Reserva o pool e o índice dentro de 'budget' bytes.
+ * * O índice tem o dobro de slots da capacidade (ocupação máxima de 50%), então
+ * cada fluxo custa o registro, o encadeamento na roda e dois slots.
+ */
+void flow_table_init(FlowTable *table, size_t budget, uint64_t idle_ns, uint64_t active_ns, FlowExportFn export_fn) {
+    size_t per_flow = sizeof(FlowRecord) + sizeof(WheelLink) + 2 * sizeof(FlowSlot);
+    uint32_t slots = FLOW_MIN_SLOTS;
+
+    while ((size_t)slots * per_flow <= budget && slots < (1u << 30)) slots <<= 1;
+
+    table->capacity = (int)(slots / 2);
+    table->mask = slots - 1;
+    table->flows = malloc((size_t)table->capacity * sizeof(FlowRecord));
+    table->slots = malloc((size_t)slots * sizeof(FlowSlot));
+    for (uint32_t i = 0; i < slots; i++) {
+        table->slots[i].index = -1;
+    }
+    timing_wheel_init(&table->expiry, table->capacity);
+
+    table->count = 0;
+    table->clock_hand = 0;
+    table->idle_ns = idle_ns;
+    table->active_ns = active_ns;
+    table->export_fn = export_fn;
+    table->pending_count = 0;
+    memset(table->exported, 0, sizeof(table->exported));
+}
+
+void flow_table_free(FlowTable *table) {
+    free(table->flows);
+    free(table->slots);
+    timing_wheel_free(&table->expiry);
+    table->flows = NULL;
+    table->slots = NULL;
+}
+
+size_t flow_table_bytes(const FlowTable *table) {
+    return (size_t)table->capacity * (sizeof(FlowRecord) + sizeof(WheelLink))
+         + ((size_t)table->mask + 1) * sizeof(FlowSlot);
+}
+
+/**
+ * @brief Slot do índice que aponta para o fluxo 'index'.
+ */
+static uint32_t slot_of(const FlowTable *table, int32_t index) {
+    uint32_t pos = record_hash(&table->flows[index]) & table->mask;
+
+    while (table->slots[pos].index != index) pos = (pos + 1) & table->mask;
+    return pos;
+}
+
+/**
+ * @brief Remove o fluxo 'index' do índice e do pool.
+ * * O buraco no índice é fechado por deslocamento reverso (sem lápides) e o
+ * último fluxo do pool é movido para a posição liberada, mantendo-o denso.
+ */
+static void remove_flow(FlowTable *table, int32_t index) {
+    uint32_t hole = slot_of(table, index);
+
+    for (uint32_t i = (hole + 1) & table->mask; table->slots[i].index != -1; i = (i + 1) & table->mask) {
+        uint32_t home = table->slots[i].hash & table->mask;
+
+        if (((hole - home) & table->mask) < ((i - home) & table->mask)) {
+            table->slots[hole] = table->slots[i];
+            hole = i;
+        }
+    }
+    table->slots[hole].index = -1;
+
+    timing_wheel_cancel(&table->expiry, index);
+    int32_t last = --table->count;
+    if (index != last) {
+        table->slots[slot_of(table, last)].index = index;
+        table->flows[index] = table->flows[last];
+        timing_wheel_move(&table->expiry, last, index);
+    }
+}
+
+/**
+ * @brief Entrega os registros acumulados ao destino de exportação.
+ */
+void flow_table_flush(FlowTable *table) {
+    if (table->pending_count == 0) return;
+    if (table->export_fn) table->export_fn(table->pending, (size_t)table->pending_count);
+    table->pending_count = 0;
+}
+
+/**
+ * @brief Copia o fluxo para o lote de exportação e o retira da tabela.
+ */
+static void export_flow(FlowTable *table, int32_t index, FlowEndReason reason) {
+    if (table->pending_count == FLOW_EXPORT_BATCH) flow_table_flush(table);
+
+    FlowRecord *record = &table->pending[table->pending_count++];
+    *record = table->flows[index];
+    record->reason = (uint8_t)reason;
+    table->exported[reason]++;
+
+    remove_flow(table, index);
+}
+
+/**
+ * @brief Próximo prazo de um fluxo aberto: o que vencer antes entre inatividade e tempo ativo.
+ */
+static uint64_t flow_deadline(const FlowTable *table, const FlowRecord *flow) {
+    uint64_t idle = flow->last_ns + table->idle_ns;
+    uint64_t active = flow->first_ns + table->active_ns;
+    return idle < active ? idle : active;
+}
+
+static int flow_finished(const FlowRecord *flow) {
+    return flow->state == FLOW_STATE_CLOSED || flow->state == FLOW_STATE_RESET;
+}
+
+/**
+ * @brief Abre espaço com a tabela cheia.
+ * * O ponteiro do relógio percorre o pool; entre os FLOW_CLOCK_SCAN fluxos sob
+ * ele, sai o encerrado por FIN/RST ou, na falta, o de último pacote mais antigo.
+ */
+static void evict_flow(FlowTable *table) {
+    int32_t victim = -1;
+
+    for (int scanned = 0; scanned < FLOW_CLOCK_SCAN; scanned++) {
+        if (table->clock_hand >= table->count) table->clock_hand = 0;
+        int32_t candidate = table->clock_hand++;
+
+        if (flow_finished(&table->flows[candidate])) {
+            victim = candidate;
+            break;
+        }
+        if (victim < 0 || table->flows[candidate].last_ns < table->flows[victim].last_ns) victim = candidate;
+    }
+
+    export_flow(table, victim, flow_finished(&table->flows[victim])
+                ? (table->flows[victim].state == FLOW_STATE_RESET ? FLOW_END_RST : FLOW_END_FIN)
+                : FLOW_END_EVICTED);
+}
+
+/**
+ * @brief Avança o estado TCP com as flags de um segmento (já somadas a tcp_flags).
+ * * Fluxos vistos a partir do meio (sem SYN) entram direto em ESTABLISHED; o
+ * fechamento exige FIN nos dois sentidos.
+ */
+static void tcp_transition(FlowRecord *flow, uint8_t flags) {
+    if (flags & TH_RST) {
+        flow->state = FLOW_STATE_RESET;
+        return;
+    }
+    if (flow->state == FLOW_STATE_RESET) return;
+
+    if ((flags & (TH_SYN | TH_ACK)) == TH_SYN) {
+        if (flow->state == FLOW_STATE_NONE) flow->state = FLOW_STATE_SYN_SENT;
+    } else if (flags & TH_SYN) {
+        if (flow->state <= FLOW_STATE_SYN_SENT) flow->state = FLOW_STATE_SYN_RECEIVED;
+    } else if (flow->state == FLOW_STATE_NONE || flow->state == FLOW_STATE_SYN_RECEIVED) {
+        flow->state = FLOW_STATE_ESTABLISHED;
+    }
+
+    if (flags & TH_FIN) {
+        flow->state = (flow->tcp_flags[0] & flow->tcp_flags[1] & TH_FIN) ? FLOW_STATE_CLOSED : FLOW_STATE_CLOSING;
+    }
+}
+
+/**
+ * @brief Contabiliza um pacote no fluxo da sua 5-tupla, criando-o se necessário.
+ * @param src_port Porta de origem em ordem do host (0 para ICMP)
+ * @param length Tamanho do pacote no fio
+ */
+void flow_table_update(FlowTable *table, uint32_t src_ip, uint32_t dst_ip, uint16_t src_port, uint16_t dst_port,
+                       uint8_t proto, uint8_t tcp_flags, int length, uint64_t now) {
+    uint32_t hash = flow_hash(src_ip, src_port, dst_ip, dst_port, proto);
+    uint32_t pos = hash & table->mask;
+    int32_t index = -1;
+    int dir = 0;
+
+    for (; table->slots[pos].index != -1; pos = (pos + 1) & table->mask) {
+        if (table->slots[pos].hash != hash) continue;
+        dir = flow_direction(&table->flows[table->slots[pos].index], src_ip, dst_ip, src_port, dst_port, proto);
+        if (dir >= 0) {
+            index = table->slots[pos].index;
+            break;
+        }
+    }
+
+    if (index < 0) {
+        if (table->count == table->capacity) {
+            evict_flow(table);
+            // O despejo pode ter deslocado slots: procura de novo a posição livre
+            for (pos = hash & table->mask; table->slots[pos].index != -1; pos = (pos + 1) & table->mask);
+        }
+
+        dir = 0;
+        index = table->count++;
+        table->slots[pos] = (FlowSlot){ hash, index };
+
+        FlowRecord *flow = &table->flows[index];
+        memset(flow, 0, sizeof(FlowRecord));
+        flow->src_ip = src_ip;
+        flow->dst_ip = dst_ip;
+        flow->src_port = src_port;
+        flow->dst_port = dst_port;
+        flow->proto = proto;
+        flow->first_ns = now;
+        flow->last_ns = now;
+        timing_wheel_schedule(&table->expiry, index, flow_deadline(table, flow));
+    }
+
+    FlowRecord *flow = &table->flows[index];
+    int was_finished = flow_finished(flow);
+
+    if (flow->packets[dir] < UINT32_MAX) flow->packets[dir]++;
+    flow->bytes[dir] += (uint64_t)length;
+    if (now > flow->last_ns) flow->last_ns = now;
+
+    if (proto == IPPROTO_TCP) {
+        flow->tcp_flags[dir] |= tcp_flags;
+        tcp_transition(flow, tcp_flags);
+
+        // Encerrado agora: exporta após uma curta espera pelos últimos segmentos
+        if (!was_finished && flow_finished(flow)) {
+            timing_wheel_cancel(&table->expiry, index);
+            timing_wheel_schedule(&table->expiry, index, now + FLOW_LINGER_NS);
+        }
+    }
+}
+
+/**
+ * @brief Exporta os fluxos com prazo vencido até now.
+ * * Pacotes não reagendam o fluxo na roda: o prazo é reavaliado quando vence e,
+ * se o fluxo teve atividade depois disso, volta para a roda com o novo prazo.
+ * A comparação é feita em ticks da roda, como em expire_suspects(): um prazo
+ * que cai no tick corrente vence agora, pois reagendá-lo no mesmo tick o
+ * devolveria na chamada seguinte e prenderia os demais fluxos do slot.
+ */
+void flow_table_expire(FlowTable *table, uint64_t now) {
+    uint64_t tick = wheel_tick(now);
+
+    for (int processed = 0; processed < FLOW_EXPIRE_MAX; processed++) {
+        int32_t index = timing_wheel_expire(&table->expiry, now);
+        if (index == WHEEL_NONE) return;
+
+        FlowRecord *flow = &table->flows[index];
+        if (flow_finished(flow)) {
+            export_flow(table, index, flow->state == FLOW_STATE_RESET ? FLOW_END_RST : FLOW_END_FIN);
+        } else if (wheel_tick(flow->first_ns + table->active_ns) <= tick) {
+            export_flow(table, index, FLOW_END_ACTIVE);
+        } else if (wheel_tick(flow->last_ns + table->idle_ns) <= tick) {
+            export_flow(table, index, FLOW_END_IDLE);
+        } else {
+            timing_wheel_schedule(&table->expiry, index, flow_deadline(table, flow));
+        }
+    }
+}
+
+/**
+ * @brief Exporta todos os fluxos ainda abertos (fim da captura).
+ */
+void flow_table_drain(FlowTable *table) {
+    while (table->count > 0) {
+        export_flow(table, table->count - 1, FLOW_END_SHUTDOWN);
+    }
+    flow_table_flush(table);
+}
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/handshake.h"
+
+/* ========================================================================= *
+ * HANDSHAKES TCP POR DESTINO (SYN FLOOD)                                    *
+ * ========================================================================= *
+ * Um SYN abre uma entrada pendente; o ACK (ou RST) do mesmo cliente a fecha. *
+ * O que não fecha dentro de HANDSHAKE_TIMEOUT_NS fica meio-aberto. Todas as *
+ * tabelas têm tamanho fixo: sob um flood, os SYNs mais antigos são apenas   *
+ * sobrescritos, o que só pode aumentar a contagem de meio-abertos.          */
+
+#define PENDING_SETS  ((1u << HANDSHAKE_PENDING_BITS) / HANDSHAKE_WAYS)
+#define SERVICE_SETS  ((1u << HANDSHAKE_SERVICE_BITS) / HANDSHAKE_WAYS)
+#define STAMP_SHIFT   20                // Unidade de tempo das entradas pendentes (~1 ms)
+
+void handshake_init(HandshakeTable *table) {
+    table->pending = calloc((size_t)1 << HANDSHAKE_PENDING_BITS, sizeof(HandshakePending));
+    table->services = calloc((size_t)1 << HANDSHAKE_SERVICE_BITS, sizeof(HandshakeService));
+}
+
+void handshake_free(HandshakeTable *table) {
+    free(table->pending);
+    free(table->services);
+    table->pending = NULL;
+    table->services = NULL;
+}
+
+/**
+ * @brief Finalizador de 64 bits (MurmurHash3) da 4-tupla do handshake.
+ */
+static uint64_t tuple_hash(uint32_t client, uint16_t client_port, uint32_t server, uint16_t server_port) {
+    uint64_t h = ((uint64_t)client << 32 | server) ^ (((uint64_t)client_port << 16 | server_port) * 0x9e3779b97f4a7c15ull);
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Localiza o conjunto e a impressão digital (nunca 0) de uma 4-tupla.
+ */
+static HandshakePending *pending_set(HandshakeTable *table, uint32_t client, uint16_t client_port,
+                                     uint32_t server, uint16_t server_port, uint32_t *tag) {
+    uint64_t h = tuple_hash(client, client_port, server, server_port);
+
+    *tag = (uint32_t)h | 1;
+    return &table->pending[((h >> 32) % PENDING_SETS) * HANDSHAKE_WAYS];
+}
+
+static int pending_live(const HandshakePending *slot, uint32_t stamp) {
+    return slot->tag != 0 && stamp - slot->stamp <= (uint32_t)(HANDSHAKE_TIMEOUT_NS >> STAMP_SHIFT);
+}
+
+/**
+ * @brief Registra o SYN de um cliente para o serviço.
+ * * Ocupa uma via livre ou vencida do conjunto; se todas estiverem vivas,
+ * sobrescreve o SYN mais antigo.
+ * @return 1 se o SYN é novo; 0 se é a retransmissão de um SYN ainda pendente.
+ */
+int handshake_open(HandshakeTable *table, uint32_t client, uint16_t client_port,
+                   uint32_t server, uint16_t server_port, uint64_t now) {
+    uint32_t tag, stamp = (uint32_t)(now >> STAMP_SHIFT);
+    HandshakePending *set = pending_set(table, client, client_port, server, server_port, &tag);
+    int victim = 0;
+
+    for (int way = 0; way < HANDSHAKE_WAYS; way++) {
+        if (set[way].tag == tag && pending_live(&set[way], stamp)) return 0;
+    }
+
+    for (int way = 0; way < HANDSHAKE_WAYS; way++) {
+        if (!pending_live(&set[way], stamp)) {
+            victim = way;
+            break;
+        }
+        if (stamp - set[way].stamp > stamp - set[victim].stamp) victim = way;
+    }
+
+    set[victim].tag = tag;
+    set[victim].stamp = stamp;
+    return 1;
+}
+
+/**
+ * @brief Fecha o handshake pendente do cliente (ACK ou RST recebido a tempo).
+ * @return 1 se havia um SYN pendente dentro do prazo; 0 caso contrário.
+ */
+int handshake_close(HandshakeTable *table, uint32_t client, uint16_t client_port,
+                    uint32_t server, uint16_t server_port, uint64_t now) {
+    uint32_t tag, stamp = (uint32_t)(now >> STAMP_SHIFT);
+    HandshakePending *set = pending_set(table, client, client_port, server, server_port, &tag);
+
+    for (int way = 0; way < HANDSHAKE_WAYS; way++) {
+        if (set[way].tag != tag) continue;
+
+        int live = pending_live(&set[way], stamp);
+        set[way].tag = 0;
+        return live;
+    }
+    return 0;
+}
+
+/**
+ * @brief Gira os contadores do serviço até a janela de now.
+ */
+static void service_rotate(HandshakeService *service, uint64_t now) {
+    uint64_t epoch = now / HANDSHAKE_WINDOW_NS;
+    if (epoch <= service->epoch) return;
+
+    int adjacent = epoch == service->epoch + 1;
+    for (int c = 0; c < HS_COUNTERS; c++) {
+        service->counts[c][0] = adjacent ? service->counts[c][1] : 0;
+        service->counts[c][1] = 0;
+    }
+    service->epoch = epoch;
+}
+
+/**
+ * @brief Localiza o serviço (destino, porta) e, se create, o insere.
+ * * Com o conjunto cheio, o serviço com menos SYNs nas duas janelas dá lugar ao novo.
+ * @return Serviço encontrado/criado, ou NULL se ausente e !create.
+ */
+HandshakeService *handshake_service(HandshakeTable *table, uint32_t server, uint16_t port, int create) {
+    uint64_t key = (uint64_t)1 << 48 | (uint64_t)server << 16 | port;
+    uint64_t h = tuple_hash(server, port, 0, 0);
+    HandshakeService *set = &table->services[(h >> 32) % SERVICE_SETS * HANDSHAKE_WAYS];
+    int victim = 0;
+
+    for (int way = 0; way < HANDSHAKE_WAYS; way++) {
+        if (set[way].key == key) return &set[way];
+    }
+    if (!create) return NULL;
+
+    for (int way = 0; way < HANDSHAKE_WAYS; way++) {
+        if (set[way].key == 0) {
+            victim = way;
+            break;
+        }
+        uint64_t activity = (uint64_t)set[way].counts[HS_SYN][0] + set[way].counts[HS_SYN][1];
+        uint64_t least = (uint64_t)set[victim].counts[HS_SYN][0] + set[victim].counts[HS_SYN][1];
+        if (activity < least) victim = way;
+    }
+
+    memset(&set[victim], 0, sizeof(HandshakeService));
+    set[victim].key = key;
+    return &set[victim];
+}
+
+void handshake_count(HandshakeService *service, int counter, uint64_t now) {
+    service_rotate(service, now);
+    if (service->counts[counter][1] < UINT32_MAX) service->counts[counter][1]++;
+}
+
+/**
+ * @brief Estima SYNs, SYN-ACKs e handshakes completos no último segundo até now.
+ */
+void handshake_rates(const HandshakeService *service, uint64_t now, uint32_t rates[HS_COUNTERS]) {
+    uint64_t epoch = now / HANDSHAKE_WINDOW_NS;
+    uint64_t remaining = HANDSHAKE_WINDOW_NS - now % HANDSHAKE_WINDOW_NS;
+
+    for (int c = 0; c < HS_COUNTERS; c++) {
+        uint64_t current = 0, previous = 0;
+
+        // Timestamps fora de ordem contam como a janela corrente
+        if (epoch <= service->epoch) {
+            current = service->counts[c][1];
+            previous = service->counts[c][0];
+        } else if (epoch == service->epoch + 1) {
+            previous = service->counts[c][1];
+        }
+        rates[c] = (uint32_t)(current + previous * remaining / HANDSHAKE_WINDOW_NS);
+    }
+}
@@ -0,0 +1,287 @@
+#include <stddef.h>
+#include <string.h>
+#include <netinet/in.h>
+#include "../../include/header_kernel.h"
+#include "../../include/publisher.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEADER_KERNEL_X86 1
+#else
+#define HEADER_KERNEL_X86 0
+#endif
+
+/* ========================================================================= *
+ * KERNEL DE EXTRAÇÃO DE CABEÇALHOS (MODO BATCH)                             *
+ * ========================================================================= *
+ * Caminho rápido da fase 1 do lote para o perfil dominante num sensor       *
+ * Ethernet: IPv4 sem opções, sem VLAN e sem fragmentação, com TCP ou UDP.   *
+ * Cada pacote é validado com uma comparação vetorial sobre os bytes 12-27   *
+ * e os campos são movidos para o descritor com shuffles, sem desvios por   *
+ * campo. Pacotes fora do perfil (VLAN, IPv6, ICMP, túneis, opções IP,      *
+ * quadros curtos) ficam com o bit zerado no retorno e seguem pelo          *
+ * decodificador de enlace, que continua sendo a referência: o descritor    *
+ * produzido aqui é idêntico ao dele.                                        */
+
+#define FAST_L3 14             // IPv4 logo após o cabeçalho Ethernet
+#define FAST_L4 34             // Transporte logo após um cabeçalho IPv4 sem opções
+#define FAST_CAPLEN 48         // Até o byte de flags TCP: toda leitura do caminho rápido fica aquém disto
+#define FAST_TOTAL_MIN 34      // Comprimento total mínimo: IPv4 (20) + TCP até as flags (14)
+#define FAST_MAX_OFFSET UINT16_MAX      // Mesmo teto de leitura do decodificador (offsets de 16 bits)
+#define PREFETCH_AHEAD 4       // Pacotes de antecedência no prefetch dos cabeçalhos
+
+_Static_assert(offsetof(DecodedPacket, src_ip) == 32 && offsetof(DecodedPacket, src_port) == 48 &&
+               offsetof(DecodedPacket, l3_offset) == 54 && offsetof(DecodedPacket, l4_offset) == 56,
+               "o kernel escreve a segunda metade do descritor em blocos de 16 bytes");
+_Static_assert(TUNNEL_NONE == 0, "descritores do caminho rápido têm o campo do túnel zerado");
+
+/**
+ * @brief Conferências do perfil que dependem de campos de 16 bits.
+ * * Só é chamada com caplen >= FAST_CAPLEN, depois de validados EtherType,
+ * versão/IHL, fragmento e protocolo. Replica os limites do decodificador: o
+ * comprimento total limita a leitura, e o UDP para a porta do VXLAN fica para
+ * a decapsulação.
+ * @return Bytes de transporte dentro do datagrama (l4_length); -1 se o pacote segue pelo decodificador.
+ */
+static inline int fast_transport(const PacketRef *ref, uint16_t tunnel_port) {
+    const u_char *p = ref->data;
+    int total = p[16] << 8 | p[17];
+    if (total < FAST_TOTAL_MIN) return -1;
+    if (p[23] == IPPROTO_UDP && tunnel_port != 0 && (p[36] << 8 | p[37]) == tunnel_port) return -1;
+
+    int end = ref->caplen < FAST_MAX_OFFSET ? (int)ref->caplen : FAST_MAX_OFFSET;
+    if (end > FAST_L3 + total) end = FAST_L3 + total;
+    return end - FAST_L4;
+}
+
+/**
+ * @brief Campos do descritor que não vêm de um shuffle: tamanhos, protocolo e flags.
+ */
+static inline void fast_finish(const PacketRef *ref, int l4_length, DecodedPacket *pkt) {
+    const u_char *p = ref->data;
+    pkt->length = (int)ref->len;
+    pkt->l4_length = (uint16_t)l4_length;
+    pkt->proto = p[23];
+    pkt->tcp_flags = p[23] == IPPROTO_TCP ? p[47] : 0;
+}
+
+/**
+ * @brief Implementação escalar do mesmo perfil (CPUs sem SSE4.2, outras arquiteturas).
+ */
+static uint32_t kernel_scalar(const PacketRef *pkts, size_t count, uint16_t tunnel_port, DecodedPacket *out) {
+    uint32_t decoded = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const PacketRef *ref = &pkts[i];
+        const u_char *p = ref->data;
+
+        if (i + PREFETCH_AHEAD < count) __builtin_prefetch(pkts[i + PREFETCH_AHEAD].data);
+        if (ref->caplen < FAST_CAPLEN || p[12] != 0x08 || p[13] != 0x00 || p[14] != 0x45) continue;
+        if ((p[20] & 0x1f) != 0 || p[21] != 0 || (p[23] != IPPROTO_TCP && p[23] != IPPROTO_UDP)) continue;
+
+        int l4_length = fast_transport(ref, tunnel_port);
+        if (l4_length < 0) continue;
+
+        DecodedPacket *pkt = &out[i];
+        *pkt = (DecodedPacket){ .l3_offset = FAST_L3, .l4_offset = FAST_L4 };
+        memcpy(&pkt->src_ip, p + 26, sizeof(pkt->src_ip));
+        memcpy(&pkt->dst_ip, p + 30, sizeof(pkt->dst_ip));
+        pkt->src_port = (uint16_t)(p[34] << 8 | p[35]);
+        pkt->dst_port = (uint16_t)(p[36] << 8 | p[37]);
+        fast_finish(ref, l4_length, pkt);
+        decoded |= 1u << i;
+    }
+    return decoded;
+}
+
+#if HEADER_KERNEL_X86
+
+/*
+ * Registradores de um pacote (bytes do quadro):
+ *   head = 12..27: EtherType (0-1), versão/IHL (2), comprimento total (4-5),
+ *                  fragmento (8-9), protocolo (11), origem[0..1] (14-15)
+ *   tail = 28..43: origem[2..3] (0-1), destino (2-5), portas (6-9)
+ *   alignr(tail, head, 14) = 26..41: origem, destino, portas de origem e destino
+ */
+
+__attribute__((target("sse4.2")))
+static inline __m128i profile_care(void) {
+    return _mm_setr_epi8(-1, -1, -1, 0, 0, 0, 0, 0, 0x1f, -1, 0, 0, 0, 0, 0, 0);
+}
+
+__attribute__((target("sse4.2")))
+static inline __m128i profile_want(void) {
+    return _mm_setr_epi8(0x08, 0x00, 0x45, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+}
+
+// Origem e destino na ordem de rede; tunnel_id e length zerados (length é escrito à parte)
+__attribute__((target("sse4.2")))
+static inline __m128i shuffle_addresses(void) {
+    return _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+}
+
+// Portas trocadas para a ordem do host, seguidas dos offsets constantes do perfil
+__attribute__((target("sse4.2")))
+static inline __m128i shuffle_ports(void) {
+    return _mm_setr_epi8(9, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+}
+
+__attribute__((target("sse4.2")))
+static inline __m128i profile_offsets(void) {
+    return _mm_setr_epi16(0, 0, 0, FAST_L3, FAST_L4, 0, 0, 0);
+}
+
+/**
+ * @brief Valida e decodifica um pacote com registradores de 128 bits.
+ * @return 1 se o pacote está no perfil (descritor preenchido); 0 caso contrário.
+ */
+__attribute__((target("sse4.2")))
+static inline int fast_sse42(const PacketRef *ref, uint16_t tunnel_port, DecodedPacket *pkt) {
+    if (ref->caplen < FAST_CAPLEN) return 0;
+
+    const u_char *p = ref->data;
+    __m128i head = _mm_loadu_si128((const __m128i *)(p + 12));
+    __m128i tail = _mm_loadu_si128((const __m128i *)(p + 28));
+
+    int header = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(head, profile_care()), profile_want()));
+    int proto = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(head, _mm_set1_epi8(IPPROTO_TCP)),
+                                               _mm_cmpeq_epi8(head, _mm_set1_epi8(IPPROTO_UDP))));
+    if (header != 0xffff || !(proto & 1 << 11)) return 0;
+
+    int l4_length = fast_transport(ref, tunnel_port);
+    if (l4_length < 0) return 0;
+
+    __m128i fields = _mm_alignr_epi8(tail, head, 14);
+    __m128i *line = (__m128i *)pkt;
+    _mm_storeu_si128(line, _mm_setzero_si128());
+    _mm_storeu_si128(line + 1, _mm_setzero_si128());
+    _mm_storeu_si128(line + 2, _mm_shuffle_epi8(fields, shuffle_addresses()));
+    _mm_storeu_si128(line + 3, _mm_or_si128(_mm_shuffle_epi8(fields, shuffle_ports()), profile_offsets()));
+    fast_finish(ref, l4_length, pkt);
+    return 1;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t kernel_sse42(const PacketRef *pkts, size_t count, uint16_t tunnel_port, DecodedPacket *out) {
+    uint32_t decoded = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (i + PREFETCH_AHEAD < count) __builtin_prefetch(pkts[i + PREFETCH_AHEAD].data);
+        decoded |= (uint32_t)fast_sse42(&pkts[i], tunnel_port, &out[i]) << i;
+    }
+    return decoded;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load_pair(const u_char *first, const u_char *second) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)first)),
+                                   _mm_loadu_si128((const __m128i *)second), 1);
+}
+
+/**
+ * @brief Kernel AVX2: dois pacotes por registrador, um em cada pista de 128 bits.
+ * * A validação dos dois sai de uma só comparação (16 bits da máscara por
+ * pacote), e os shuffles e o alignr operam nas duas pistas de uma vez. Um
+ * quadro curto demais para as cargas de 16 bytes, ou a sobra ímpar do lote,
+ * passa pelo caminho de 128 bits.
+ */
+__attribute__((target("avx2")))
+static uint32_t kernel_avx2(const PacketRef *pkts, size_t count, uint16_t tunnel_port, DecodedPacket *out) {
+    const __m256i care = _mm256_broadcastsi128_si256(profile_care());
+    const __m256i want = _mm256_broadcastsi128_si256(profile_want());
+    const __m256i tcp = _mm256_set1_epi8(IPPROTO_TCP);
+    const __m256i udp = _mm256_set1_epi8(IPPROTO_UDP);
+    const __m256i addresses = _mm256_broadcastsi128_si256(shuffle_addresses());
+    const __m256i ports = _mm256_broadcastsi128_si256(shuffle_ports());
+    const __m256i offsets = _mm256_broadcastsi128_si256(profile_offsets());
+    uint32_t decoded = 0;
+    size_t i = 0;
+
+    for (; i + 1 < count; i += 2) {
+        const PacketRef *first = &pkts[i];
+        const PacketRef *second = &pkts[i + 1];
+
+        if (i + PREFETCH_AHEAD + 1 < count) {
+            __builtin_prefetch(pkts[i + PREFETCH_AHEAD].data);
+            __builtin_prefetch(pkts[i + PREFETCH_AHEAD + 1].data);
+        }
+        if (first->caplen < FAST_CAPLEN || second->caplen < FAST_CAPLEN) {
+            decoded |= (uint32_t)fast_sse42(first, tunnel_port, &out[i]) << i;
+            decoded |= (uint32_t)fast_sse42(second, tunnel_port, &out[i + 1]) << (i + 1);
+            continue;
+        }
+
+        __m256i head = load_pair(first->data + 12, second->data + 12);
+        __m256i tail = load_pair(first->data + 28, second->data + 28);
+        uint32_t header = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(head, care), want));
+        uint32_t proto = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(head, tcp),
+                                                                        _mm256_cmpeq_epi8(head, udp)));
+
+        int l4_first = (header & 0xffff) == 0xffff && (proto & 1u << 11) ? fast_transport(first, tunnel_port) : -1;
+        int l4_second = header >> 16 == 0xffff && (proto & 1u << 27) ? fast_transport(second, tunnel_port) : -1;
+        if (l4_first < 0 && l4_second < 0) continue;
+
+        __m256i fields = _mm256_alignr_epi8(tail, head, 14);
+        __m256i low = _mm256_shuffle_epi8(fields, addresses);
+        __m256i high = _mm256_or_si256(_mm256_shuffle_epi8(fields, ports), offsets);
+
+        // Cada descritor recebe a sua pista das duas metades: [endereços | portas e offsets]
+        if (l4_first >= 0) {
+            __m256i *line = (__m256i *)&out[i];
+            _mm256_storeu_si256(line, _mm256_setzero_si256());
+            _mm256_storeu_si256(line + 1, _mm256_permute2x128_si256(low, high, 0x20));
+            fast_finish(first, l4_first, &out[i]);
+            decoded |= 1u << i;
+        }
+        if (l4_second >= 0) {
+            __m256i *line = (__m256i *)&out[i + 1];
+            _mm256_storeu_si256(line, _mm256_setzero_si256());
+            _mm256_storeu_si256(line + 1, _mm256_permute2x128_si256(low, high, 0x31));
+            fast_finish(second, l4_second, &out[i + 1]);
+            decoded |= 1u << (i + 1);
+        }
+    }
+    if (i < count) decoded |= (uint32_t)fast_sse42(&pkts[i], tunnel_port, &out[i]) << i;
+    return decoded;
+}
+
+#endif
+
+/**
+ * @brief Melhor implementação suportada pela CPU (e pelo sistema, no caso do AVX2).
+ */
+HeaderKernel header_kernel_detect(void) {
+#if HEADER_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return HEADER_KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return HEADER_KERNEL_SSE42;
+#endif
+    return HEADER_KERNEL_SCALAR;
+}
+
+const char *header_kernel_name(HeaderKernel kernel) {
+    static const char *const names[HEADER_KERNEL_COUNT] = { "nenhum", "escalar", "SSE4.2", "AVX2" };
+    return kernel < HEADER_KERNEL_COUNT ? names[kernel] : "?";
+}
+
+/**
+ * @brief Decodifica de uma vez os pacotes do lote que estão no perfil do caminho rápido.
+ * * Só se aplica a capturas DLT_EN10MB. Um nível sem suporte nesta
+ * arquitetura cai na implementação escalar.
+ * @param count Pacotes do lote (no máximo HEADER_KERNEL_MAX).
+ * @param tunnel_port Porta UDP decapsulada pelo decodificador (VXLAN); 0 com a decapsulação desligada.
+ * @return Máscara dos pacotes decodificados (bit i = out[i] preenchido); os demais ficam para o decodificador de enlace.
+ */
+uint32_t header_kernel_extract(HeaderKernel kernel, const PacketRef *pkts, size_t count, uint16_t tunnel_port,
+                               DecodedPacket *out) {
+    if (count > HEADER_KERNEL_MAX) count = HEADER_KERNEL_MAX;
+
+    switch (kernel) {
+        case HEADER_KERNEL_NONE:  return 0;
+#if HEADER_KERNEL_X86
+        case HEADER_KERNEL_SSE42: return kernel_sse42(pkts, count, tunnel_port, out);
+        case HEADER_KERNEL_AVX2:  return kernel_avx2(pkts, count, tunnel_port, out);
+#endif
+        default:                  return kernel_scalar(pkts, count, tunnel_port, out);
+    }
+}
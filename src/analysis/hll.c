@@ -0,0 +1,210 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/hll.h"
+
+/* ========================================================================= *
+ * ESTIMADOR HYPERLOGLOG (ESPARSO -> DENSO)                                  *
+ * ========================================================================= *
+ * Conta elementos distintos com memória fixa: cada registrador guarda o     *
+ * maior rho (posição do primeiro bit 1) visto entre os hashes que caíram    *
+ * nele. Origens que tocam poucos destinos ficam no modo esparso, dentro da  *
+ * própria estrutura; só as varreduras pagam pelos 256 bytes do modo denso.  */
+
+// O merge denso (máximo por registrador) é despachado em tempo de execução;
+// o laço sobre bytes vira um VPMAXUB de 32 bytes por instrução com AVX2.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HLL_SIMD __attribute__((target_clones("avx2", "default")))
+#else
+#define HLL_SIMD
+#endif
+
+#define ENTRY(index, rho) ((uint16_t)((index) << 8 | (rho)))
+#define ENTRY_INDEX(entry) ((entry) >> 8)
+#define ENTRY_RHO(entry) ((uint8_t)((entry) & 0xff))
+
+static int is_dense(const HllSketch *sketch) {
+    return sketch->capacity == HLL_DENSE;
+}
+
+static uint16_t *sparse_items(HllSketch *sketch) {
+    return sketch->capacity == 0 ? sketch->small : sketch->sparse;
+}
+
+static const uint16_t *const_sparse_items(const HllSketch *sketch) {
+    return sketch->capacity == 0 ? sketch->small : sketch->sparse;
+}
+
+/**
+ * @brief Estimativa a partir da soma harmônica (2^-M) e da quantidade de registradores nulos.
+ * * Para cardinalidades pequenas (E <= 2,5m) usa a contagem linear, que é
+ * praticamente exata enquanto há registradores vazios. Com hashes de 64 bits
+ * a correção de faixa alta do artigo original não é necessária.
+ */
+static uint32_t estimate_from(double sum, int zeros) {
+    const double m = HLL_REGISTERS;
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * log(m / zeros);
+    return (uint32_t)(estimate + 0.5);
+}
+
+static uint32_t estimate_sketch(const HllSketch *sketch) {
+    double sum = 0.0;
+    int zeros = 0;
+
+    if (is_dense(sketch)) {
+        for (int i = 0; i < HLL_REGISTERS; i++) {
+            sum += ldexp(1.0, -sketch->dense[i]);
+            zeros += sketch->dense[i] == 0;
+        }
+    } else {
+        const uint16_t *items = const_sparse_items(sketch);
+        zeros = HLL_REGISTERS - sketch->count;
+        sum = zeros;
+        for (uint32_t i = 0; i < sketch->count; i++) {
+            sum += ldexp(1.0, -ENTRY_RHO(items[i]));
+        }
+    }
+    return estimate_from(sum, zeros);
+}
+
+/**
+ * @brief Posição do registrador na lista esparsa (ou onde ele deveria ser inserido).
+ */
+static uint32_t lower_bound(const uint16_t *items, uint32_t count, uint32_t index) {
+    uint32_t lo = 0, hi = count;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (ENTRY_INDEX(items[mid]) < index) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Converte a lista esparsa no vetor denso de registradores.
+ */
+static void promote_to_dense(HllSketch *sketch) {
+    uint8_t *dense = calloc(HLL_REGISTERS, sizeof(uint8_t));
+    const uint16_t *items = const_sparse_items(sketch);
+
+    for (uint32_t i = 0; i < sketch->count; i++) {
+        dense[ENTRY_INDEX(items[i])] = ENTRY_RHO(items[i]);
+    }
+
+    if (sketch->capacity != 0) free(sketch->sparse);
+    sketch->dense = dense;
+    sketch->capacity = HLL_DENSE;
+    sketch->count = 0;
+}
+
+/**
+ * @brief Garante espaço para mais um registrador no modo esparso.
+ * @return 0 se ainda há espaço na lista; 1 se o sketch virou denso.
+ */
+static int reserve_one(HllSketch *sketch) {
+    uint32_t capacity = sketch->capacity == 0 ? HLL_SPARSE_INLINE : sketch->capacity;
+    if (sketch->count < capacity) return 0;
+
+    if (capacity * 2 > HLL_SPARSE_MAX) {
+        promote_to_dense(sketch);
+        return 1;
+    }
+
+    uint16_t *sparse = malloc(capacity * 2 * sizeof(uint16_t));
+    memcpy(sparse, sparse_items(sketch), sketch->count * sizeof(uint16_t));
+    if (sketch->capacity != 0) free(sketch->sparse);
+    sketch->sparse = sparse;
+    sketch->capacity = (uint16_t)(capacity * 2);
+    return 0;
+}
+
+/**
+ * @brief Eleva o registrador 'index' para 'rho' se o valor atual for menor.
+ * @return 1 se o registrador mudou.
+ */
+static int raise_register(HllSketch *sketch, uint32_t index, uint8_t rho) {
+    if (!is_dense(sketch)) {
+        uint16_t *items = sparse_items(sketch);
+        uint32_t pos = lower_bound(items, sketch->count, index);
+
+        if (pos < sketch->count && ENTRY_INDEX(items[pos]) == index) {
+            if (ENTRY_RHO(items[pos]) >= rho) return 0;
+            items[pos] = ENTRY(index, rho);
+            return 1;
+        }
+
+        if (!reserve_one(sketch)) {
+            items = sparse_items(sketch);
+            memmove(&items[pos + 1], &items[pos], (sketch->count - pos) * sizeof(uint16_t));
+            items[pos] = ENTRY(index, rho);
+            sketch->count++;
+            return 1;
+        }
+    }
+
+    if (sketch->dense[index] >= rho) return 0;
+    sketch->dense[index] = rho;
+    return 1;
+}
+
+/**
+ * @brief Registra um elemento pelo seu hash de 64 bits (ver hll_hash()).
+ * @return 1 se a estimativa pode ter mudado (algum registrador subiu).
+ */
+int hll_add(HllSketch *sketch, uint64_t hash) {
+    uint32_t index = (uint32_t)(hash >> (64 - HLL_PRECISION));
+    uint64_t rest = hash << HLL_PRECISION;
+    uint8_t rho = rest ? (uint8_t)(__builtin_clzll(rest) + 1) : (uint8_t)(64 - HLL_PRECISION + 1);
+
+    if (!raise_register(sketch, index, rho)) return 0;
+
+    sketch->estimate = estimate_sketch(sketch);
+    return 1;
+}
+
+/**
+ * @brief dst = max(dst, src) registrador a registrador (vetorizável).
+ */
+static HLL_SIMD void dense_max(uint8_t *restrict dst, const uint8_t *restrict src) {
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        dst[i] = src[i] > dst[i] ? src[i] : dst[i];
+    }
+}
+
+/**
+ * @brief Acrescenta a dst todos os elementos vistos por src (mesclagem de shards).
+ * * O máximo por registrador é comutativo e associativo, então o resultado é
+ * o mesmo sketch que uma passada serial teria produzido.
+ */
+void hll_merge(HllSketch *dst, const HllSketch *src) {
+    if (!is_dense(src)) {
+        const uint16_t *items = const_sparse_items(src);
+        for (uint32_t i = 0; i < src->count; i++) {
+            raise_register(dst, ENTRY_INDEX(items[i]), ENTRY_RHO(items[i]));
+        }
+    } else {
+        if (!is_dense(dst)) promote_to_dense(dst);
+        dense_max(dst->dense, src->dense);
+    }
+
+    dst->estimate = estimate_sketch(dst);
+}
+
+/**
+ * @brief Libera o armazenamento no heap e volta o sketch ao estado vazio.
+ */
+void hll_free(HllSketch *sketch) {
+    if (sketch->capacity != 0) free(sketch->sparse);
+    memset(sketch, 0, sizeof(*sketch));
+}
+
+/**
+ * @brief Bytes alocados no heap pelo sketch (0 no modo inline).
+ */
+size_t hll_heap_bytes(const HllSketch *sketch) {
+    if (is_dense(sketch)) return HLL_REGISTERS;
+    return (size_t)sketch->capacity * sizeof(uint16_t);
+}
@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include "../../include/ip6_table.h"
+
+/* ========================================================================= *
+ * ÍNDICE HASH IPv6 (ENDEREÇAMENTO ABERTO)                                   *
+ * ========================================================================= *
+ * Mesma estrutura de ip_table.c com chaves de 128 bits. O hash guardado no  *
+ * slot filtra as comparações de chave e dispensa recalcular o hash durante  *
+ * o backward-shift da remoção.                                              */
+
+#define IP6_TABLE_MIN_CAPACITY 16
+
+static void alloc_slots(Ip6Table *table, uint32_t capacity) {
+    table->slots = malloc((size_t)capacity * sizeof(Ip6Slot));
+    for (uint32_t i = 0; i < capacity; i++) {
+        table->slots[i].value = IP_TABLE_EMPTY;
+    }
+    table->mask = capacity - 1;
+    table->count = 0;
+}
+
+/**
+ * @brief Inicializa a tabela com espaço para ao menos min_capacity entradas (ocupação <= 50%).
+ */
+void ip6_table_init(Ip6Table *table, uint32_t min_capacity) {
+    uint32_t capacity = IP6_TABLE_MIN_CAPACITY;
+    while (capacity < min_capacity * 2) capacity <<= 1;
+    alloc_slots(table, capacity);
+}
+
+void ip6_table_free(Ip6Table *table) {
+    free(table->slots);
+    table->slots = NULL;
+}
+
+void ip6_table_clear(Ip6Table *table) {
+    for (uint32_t i = 0; i <= table->mask; i++) {
+        table->slots[i].value = IP_TABLE_EMPTY;
+    }
+    table->count = 0;
+}
+
+/**
+ * @brief Busca a chave usando um hash já calculado (fase de consulta do lote).
+ * @return Valor associado, ou IP_TABLE_EMPTY se a chave não estiver na tabela.
+ */
+int32_t ip6_table_find_hashed(const Ip6Table *table, Ip6Key key, uint32_t hash) {
+    for (uint32_t i = hash & table->mask; ; i = (i + 1) & table->mask) {
+        const Ip6Slot *slot = &table->slots[i];
+        if (slot->value == IP_TABLE_EMPTY) return IP_TABLE_EMPTY;
+        if (slot->hash == hash && ip6_key_equal(slot->key, key)) return slot->value;
+    }
+}
+
+int32_t ip6_table_find(const Ip6Table *table, Ip6Key key) {
+    return ip6_table_find_hashed(table, key, ip6_table_hash(key));
+}
+
+static void grow(Ip6Table *table) {
+    Ip6Slot *old = table->slots;
+    uint32_t old_capacity = table->mask + 1;
+
+    alloc_slots(table, old_capacity * 2);
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old[i].value != IP_TABLE_EMPTY) ip6_table_insert(table, old[i].key, old[i].value);
+    }
+    free(old);
+}
+
+/**
+ * @brief Insere uma chave que ainda não está na tabela.
+ */
+void ip6_table_insert(Ip6Table *table, Ip6Key key, int32_t value) {
+    if ((table->count + 1) * 2 > table->mask + 1) grow(table);
+
+    uint32_t hash = ip6_table_hash(key);
+    uint32_t i = hash & table->mask;
+    while (table->slots[i].value != IP_TABLE_EMPTY) i = (i + 1) & table->mask;
+
+    table->slots[i] = (Ip6Slot){ key, value, hash };
+    table->count++;
+}
+
+/**
+ * @brief Troca o valor de uma chave existente (Ex: entrada movida dentro do pool).
+ */
+void ip6_table_update(Ip6Table *table, Ip6Key key, int32_t value) {
+    uint32_t hash = ip6_table_hash(key);
+
+    for (uint32_t i = hash & table->mask; ; i = (i + 1) & table->mask) {
+        Ip6Slot *slot = &table->slots[i];
+        if (slot->value == IP_TABLE_EMPTY) return;
+        if (slot->hash == hash && ip6_key_equal(slot->key, key)) {
+            slot->value = value;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Remove a chave com backward-shift deletion (ver ip_table_remove).
+ */
+void ip6_table_remove(Ip6Table *table, Ip6Key key) {
+    uint32_t hash = ip6_table_hash(key);
+    uint32_t hole = hash & table->mask;
+
+    for (;; hole = (hole + 1) & table->mask) {
+        if (table->slots[hole].value == IP_TABLE_EMPTY) return;
+        if (table->slots[hole].hash == hash && ip6_key_equal(table->slots[hole].key, key)) break;
+    }
+
+    for (uint32_t i = (hole + 1) & table->mask; table->slots[i].value != IP_TABLE_EMPTY; i = (i + 1) & table->mask) {
+        uint32_t home = table->slots[i].hash & table->mask;
+
+        if (((hole - home) & table->mask) < ((i - home) & table->mask)) {
+            table->slots[hole] = table->slots[i];
+            hole = i;
+        }
+    }
+
+    table->slots[hole].value = IP_TABLE_EMPTY;
+    table->count--;
+}
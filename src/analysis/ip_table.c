@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/ip_table.h"
+
+/* ========================================================================= *
+ * ÍNDICE HASH IPv4 (ENDEREÇAMENTO ABERTO)                                   *
+ * ========================================================================= *
+ * Substitui a varredura linear do vetor de suspeitos: a busca custa O(1)    *
+ * esperado independentemente de quantas origens estão sendo rastreadas.     */
+
+#define IP_TABLE_MIN_CAPACITY 16
+
+/**
+ * @brief Aloca os slots (todos livres) para a capacidade informada.
+ */
+static void alloc_slots(IpTable *table, uint32_t capacity) {
+    table->slots = malloc((size_t)capacity * sizeof(IpSlot));
+    for (uint32_t i = 0; i < capacity; i++) {
+        table->slots[i].value = IP_TABLE_EMPTY;
+    }
+    table->mask = capacity - 1;
+    table->count = 0;
+}
+
+/**
+ * @brief Inicializa a tabela com espaço para ao menos min_capacity entradas.
+ * * A capacidade real é a menor potência de dois que mantém a ocupação <= 50%.
+ */
+void ip_table_init(IpTable *table, uint32_t min_capacity) {
+    uint32_t capacity = IP_TABLE_MIN_CAPACITY;
+    while (capacity < min_capacity * 2) capacity <<= 1;
+    alloc_slots(table, capacity);
+}
+
+void ip_table_free(IpTable *table) {
+    free(table->slots);
+    table->slots = NULL;
+}
+
+/**
+ * @brief Esvazia a tabela mantendo a capacidade atual.
+ */
+void ip_table_clear(IpTable *table) {
+    for (uint32_t i = 0; i <= table->mask; i++) {
+        table->slots[i].value = IP_TABLE_EMPTY;
+    }
+    table->count = 0;
+}
+
+/**
+ * @brief Busca a chave usando um hash já calculado (fase de consulta do lote).
+ * @return Valor associado, ou IP_TABLE_EMPTY se a chave não estiver na tabela.
+ */
+int32_t ip_table_find_hashed(const IpTable *table, uint32_t key, uint32_t hash) {
+    for (uint32_t i = hash & table->mask; ; i = (i + 1) & table->mask) {
+        const IpSlot *slot = &table->slots[i];
+        if (slot->value == IP_TABLE_EMPTY) return IP_TABLE_EMPTY;
+        if (slot->key == key) return slot->value;
+    }
+}
+
+int32_t ip_table_find(const IpTable *table, uint32_t key) {
+    return ip_table_find_hashed(table, key, ip_table_hash(key));
+}
+
+/**
+ * @brief Dobra a capacidade e reinsere todas as chaves.
+ */
+static void grow(IpTable *table) {
+    IpSlot *old = table->slots;
+    uint32_t old_capacity = table->mask + 1;
+
+    alloc_slots(table, old_capacity * 2);
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old[i].value != IP_TABLE_EMPTY) ip_table_insert(table, old[i].key, old[i].value);
+    }
+    free(old);
+}
+
+/**
+ * @brief Insere uma chave que ainda não está na tabela.
+ */
+void ip_table_insert(IpTable *table, uint32_t key, int32_t value) {
+    if ((table->count + 1) * 2 > table->mask + 1) grow(table);
+
+    uint32_t i = ip_table_hash(key) & table->mask;
+    while (table->slots[i].value != IP_TABLE_EMPTY) i = (i + 1) & table->mask;
+
+    table->slots[i].key = key;
+    table->slots[i].value = value;
+    table->count++;
+}
+
+/**
+ * @brief Troca o valor de uma chave existente (Ex: entrada movida dentro do pool).
+ */
+void ip_table_update(IpTable *table, uint32_t key, int32_t value) {
+    for (uint32_t i = ip_table_hash(key) & table->mask; ; i = (i + 1) & table->mask) {
+        IpSlot *slot = &table->slots[i];
+        if (slot->value == IP_TABLE_EMPTY) return;
+        if (slot->key == key) {
+            slot->value = value;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Remove a chave com backward-shift deletion.
+ * * Após liberar o slot, as entradas seguintes do mesmo cluster são puxadas
+ * para trás sempre que o buraco fica entre o slot ideal delas e a posição
+ * atual; o cluster continua sem lacunas e nenhuma busca precisa de tombstones.
+ */
+void ip_table_remove(IpTable *table, uint32_t key) {
+    uint32_t hole = ip_table_hash(key) & table->mask;
+
+    for (;; hole = (hole + 1) & table->mask) {
+        if (table->slots[hole].value == IP_TABLE_EMPTY) return;
+        if (table->slots[hole].key == key) break;
+    }
+
+    for (uint32_t i = (hole + 1) & table->mask; table->slots[i].value != IP_TABLE_EMPTY; i = (i + 1) & table->mask) {
+        uint32_t home = ip_table_hash(table->slots[i].key) & table->mask;
+
+        // Distância (circular) do slot ideal até o buraco e até a posição atual
+        if (((hole - home) & table->mask) < ((i - home) & table->mask)) {
+            table->slots[hole] = table->slots[i];
+            hole = i;
+        }
+    }
+
+    table->slots[hole].value = IP_TABLE_EMPTY;
+    table->count--;
+}
@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/port_set.h"
+
+/* ========================================================================= *
+ * CONJUNTO ADAPTATIVO DE PORTAS                                             *
+ * ========================================================================= *
+ * A maioria das origens toca poucas portas e cabe nos 16 bytes da própria   *
+ * estrutura; só varreduras de fato pagam pelo bitmap de 8 KiB.              */
+
+// A união de bitmaps (mesclagem do modo batch) é despachada em tempo de execução
+// para a melhor variante suportada pela CPU: Ice Lake+ vetoriza o popcount
+// (AVX-512 VPOPCNTDQ), AVX2 vetoriza o OR e POPCNT substitui a contagem por tabela.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PORT_SET_SIMD __attribute__((target_clones("arch=icelake-server", "avx2", "popcnt", "default")))
+#else
+#define PORT_SET_SIMD
+#endif
+
+static int is_bitmap(const PortSet *set) {
+    return set->capacity == PORT_SET_BITMAP;
+}
+
+/**
+ * @brief Portas do modo inline ou vetor, em ordem crescente.
+ */
+static uint16_t *sorted_items(PortSet *set) {
+    return set->capacity == 0 ? set->small : set->array;
+}
+
+static const uint16_t *const_sorted_items(const PortSet *set) {
+    return set->capacity == 0 ? set->small : set->array;
+}
+
+/**
+ * @brief Posição de port no vetor ordenado (ou onde ela deveria ser inserida).
+ */
+static uint32_t lower_bound(const uint16_t *items, uint32_t count, uint16_t port) {
+    uint32_t lo = 0, hi = count;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (items[mid] < port) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Converte o conjunto para o bitmap de 65536 bits.
+ */
+static void promote_to_bitmap(PortSet *set) {
+    uint64_t *bitmap = calloc(PORT_SET_WORDS, sizeof(uint64_t));
+    const uint16_t *items = const_sorted_items(set);
+
+    for (uint32_t i = 0; i < set->count; i++) {
+        bitmap[items[i] >> 6] |= 1ull << (items[i] & 63);
+    }
+
+    if (set->capacity != 0) free(set->array);
+    set->bitmap = bitmap;
+    set->capacity = PORT_SET_BITMAP;
+}
+
+/**
+ * @brief Garante espaço para mais uma porta no modo inline/vetor.
+ * @return 0 se ainda há espaço em modo ordenado; 1 se o conjunto virou bitmap.
+ */
+static int reserve_one(PortSet *set) {
+    uint32_t capacity = set->capacity == 0 ? PORT_SET_INLINE : set->capacity;
+    if (set->count < capacity) return 0;
+
+    if (capacity * 2 > PORT_SET_ARRAY_MAX) {
+        promote_to_bitmap(set);
+        return 1;
+    }
+
+    uint16_t *array = malloc(capacity * 2 * sizeof(uint16_t));
+    memcpy(array, sorted_items(set), set->count * sizeof(uint16_t));
+    if (set->capacity != 0) free(set->array);
+    set->array = array;
+    set->capacity = (uint16_t)(capacity * 2);
+    return 0;
+}
+
+/**
+ * @brief Registra a porta no conjunto.
+ * @return 1 se a porta é nova; 0 se já estava registrada.
+ */
+int port_set_add(PortSet *set, uint16_t port) {
+    if (!is_bitmap(set)) {
+        uint16_t *items = sorted_items(set);
+        uint32_t pos = lower_bound(items, set->count, port);
+        if (pos < set->count && items[pos] == port) return 0;
+
+        if (!reserve_one(set)) {
+            items = sorted_items(set);
+            memmove(&items[pos + 1], &items[pos], (set->count - pos) * sizeof(uint16_t));
+            items[pos] = port;
+            set->count++;
+            return 1;
+        }
+    }
+
+    uint64_t bit = 1ull << (port & 63);
+    uint64_t *word = &set->bitmap[port >> 6];
+    if (*word & bit) return 0;
+
+    *word |= bit;
+    set->count++;
+    return 1;
+}
+
+int port_set_contains(const PortSet *set, uint16_t port) {
+    if (is_bitmap(set)) return (set->bitmap[port >> 6] >> (port & 63)) & 1;
+
+    const uint16_t *items = const_sorted_items(set);
+    uint32_t pos = lower_bound(items, set->count, port);
+    return pos < set->count && items[pos] == port;
+}
+
+/**
+ * @brief dst |= src sobre bitmaps completos.
+ * @return Popcount do resultado (nova contagem exata de dst).
+ */
+static PORT_SET_SIMD uint32_t bitmap_union(uint64_t *restrict dst, const uint64_t *restrict src) {
+    uint64_t count = 0;
+
+    for (int i = 0; i < PORT_SET_WORDS; i++) {
+        dst[i] |= src[i];
+        count += (uint64_t)__builtin_popcountll(dst[i]);
+    }
+    return (uint32_t)count;
+}
+
+/**
+ * @brief Acrescenta a dst todas as portas de src (mesclagem de shards).
+ */
+void port_set_union(PortSet *dst, const PortSet *src) {
+    if (!is_bitmap(src)) {
+        const uint16_t *items = const_sorted_items(src);
+        for (uint32_t i = 0; i < src->count; i++) port_set_add(dst, items[i]);
+        return;
+    }
+
+    if (!is_bitmap(dst)) promote_to_bitmap(dst);
+    dst->count = bitmap_union(dst->bitmap, src->bitmap);
+}
+
+/**
+ * @brief Quantidade de portas de a que não estão em b (|a \ b|), sem alterar os conjuntos.
+ */
+uint32_t port_set_difference_count(const PortSet *a, const PortSet *b) {
+    if (!is_bitmap(a)) {
+        const uint16_t *items = const_sorted_items(a);
+        uint32_t missing = 0;
+        for (uint32_t i = 0; i < a->count; i++) missing += !port_set_contains(b, items[i]);
+        return missing;
+    }
+
+    // a em bitmap: desconta as portas de b que também estão em a
+    if (!is_bitmap(b)) {
+        const uint16_t *items = const_sorted_items(b);
+        uint32_t common = 0;
+        for (uint32_t i = 0; i < b->count; i++) common += port_set_contains(a, items[i]);
+        return a->count - common;
+    }
+
+    uint64_t count = 0;
+    for (int i = 0; i < PORT_SET_WORDS; i++) count += (uint64_t)__builtin_popcountll(a->bitmap[i] & ~b->bitmap[i]);
+    return (uint32_t)count;
+}
+
+/**
+ * @brief Libera o armazenamento no heap e volta o conjunto ao estado vazio.
+ */
+void port_set_free(PortSet *set) {
+    if (set->capacity != 0) free(set->array);
+    memset(set, 0, sizeof(*set));
+}
+
+/**
+ * @brief Bytes alocados no heap pelo conjunto (0 no modo inline).
+ */
+size_t port_set_heap_bytes(const PortSet *set) {
+    if (is_bitmap(set)) return PORT_SET_WORDS * sizeof(uint64_t);
+    return (size_t)set->capacity * sizeof(uint16_t);
+}
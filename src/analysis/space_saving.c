@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/space_saving.h"
+
+/* ========================================================================= *
+ * RESUMO SPACE-SAVING (TOP-K)                                               *
+ * ========================================================================= *
+ * Memória fixa independentemente da diversidade do tráfego: uma chave nova  *
+ * herda o contador da menos pesada, e o peso herdado fica registrado como   *
+ * erro máximo da estimativa.                                                */
+
+void space_saving_init(SpaceSaving *summary, int capacity) {
+    summary->heap = malloc((size_t)capacity * sizeof(SpaceSavingEntry));
+    ip_table_init(&summary->index, (uint32_t)capacity);
+    summary->size = 0;
+    summary->capacity = capacity;
+}
+
+void space_saving_free(SpaceSaving *summary) {
+    free(summary->heap);
+    ip_table_free(&summary->index);
+    summary->heap = NULL;
+}
+
+/**
+ * @brief Esvazia o resumo (início de um novo intervalo), mantendo a memória.
+ */
+void space_saving_clear(SpaceSaving *summary) {
+    ip_table_clear(&summary->index);
+    summary->size = 0;
+}
+
+/**
+ * @brief Desce a entrada 'pos' até restaurar a propriedade de min-heap.
+ */
+static void sift_down(SpaceSaving *summary, int pos) {
+    SpaceSavingEntry moving = summary->heap[pos];
+
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= summary->size) break;
+        if (child + 1 < summary->size && summary->heap[child + 1].count < summary->heap[child].count) child++;
+        if (summary->heap[child].count >= moving.count) break;
+
+        summary->heap[pos] = summary->heap[child];
+        ip_table_update(&summary->index, summary->heap[pos].key, pos);
+        pos = child;
+    }
+
+    summary->heap[pos] = moving;
+    ip_table_update(&summary->index, moving.key, pos);
+}
+
+/**
+ * @brief Soma 'weight' ao peso da chave (pacotes, bytes, portas novas...).
+ * * Uma chave ausente ocupa um contador livre ou, com o resumo cheio, substitui
+ * a de menor count, herdando-o como erro.
+ */
+void space_saving_add(SpaceSaving *summary, uint32_t key, uint64_t weight) {
+    int32_t pos = ip_table_find(&summary->index, key);
+
+    if (pos == IP_TABLE_EMPTY) {
+        if (summary->size < summary->capacity) {
+            // Contador livre: entra com count 0 na última posição e sobe pelo heap
+            pos = summary->size++;
+            while (pos > 0 && summary->heap[(pos - 1) / 2].count > 0) {
+                summary->heap[pos] = summary->heap[(pos - 1) / 2];
+                ip_table_update(&summary->index, summary->heap[pos].key, pos);
+                pos = (pos - 1) / 2;
+            }
+            summary->heap[pos] = (SpaceSavingEntry){ key, 0, 0 };
+            ip_table_insert(&summary->index, key, pos);
+        } else {
+            pos = 0;
+            ip_table_remove(&summary->index, summary->heap[0].key);
+            summary->heap[0].key = key;
+            summary->heap[0].error = summary->heap[0].count;
+            ip_table_insert(&summary->index, key, 0);
+        }
+    }
+
+    summary->heap[pos].count += weight;
+    sift_down(summary, pos);
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const SpaceSavingEntry *ea = a, *eb = b;
+    if (ea->count != eb->count) return ea->count < eb->count ? 1 : -1;
+    return (ea->key > eb->key) - (ea->key < eb->key);
+}
+
+/**
+ * @brief Copia para out as até k chaves mais pesadas, em ordem decrescente.
+ * @return Quantidade de entradas copiadas.
+ */
+int space_saving_top(const SpaceSaving *summary, SpaceSavingEntry *out, int k) {
+    SpaceSavingEntry *sorted = malloc((size_t)(summary->size > 0 ? summary->size : 1) * sizeof(SpaceSavingEntry));
+
+    memcpy(sorted, summary->heap, (size_t)summary->size * sizeof(SpaceSavingEntry));
+    qsort(sorted, (size_t)summary->size, sizeof(SpaceSavingEntry), compare_entries);
+
+    int n = summary->size < k ? summary->size : k;
+    memcpy(out, sorted, (size_t)n * sizeof(SpaceSavingEntry));
+    free(sorted);
+    return n;
+}
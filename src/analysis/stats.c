@@ -0,0 +1,5 @@
+#include "../../include/stats.h"
+
+/* Instrumentação por estágio do pipeline (desligada na captura ao vivo) */
+_Thread_local StageStats stage_stats;
+int stage_timing_enabled = 0;
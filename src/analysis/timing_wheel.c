@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include "../../include/timing_wheel.h"
+
+/* ========================================================================= *
+ * RODA DE TEMPORIZAÇÃO HIERÁRQUICA                                          *
+ * ========================================================================= *
+ * Cada nível tem 64 slots; um slot do nível L cobre 64^L ticks. Entradas    *
+ * distantes ficam nos níveis altos e descem (cascata) quando o slot delas   *
+ * é alcançado, de modo que cada entrada é movida no máximo WHEEL_LEVELS     *
+ * vezes. A expiração devolve uma entrada por chamada: o chamador decide     *
+ * quantas processar por pacote e nenhum pacote paga por uma varredura.      */
+
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+// Maior distância (em ticks) representável antes de saturar no último nível
+#define WHEEL_SPAN ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+
+/**
+ * @brief Aloca os encadeamentos para um pool de 'capacity' entradas, todas fora da roda.
+ */
+void timing_wheel_init(TimingWheel *wheel, int capacity) {
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            wheel->heads[level][slot] = WHEEL_NONE;
+        }
+        wheel->occupied[level] = 0;
+    }
+
+    wheel->links = malloc((size_t)capacity * sizeof(WheelLink));
+    for (int i = 0; i < capacity; i++) {
+        wheel->links[i].bucket = WHEEL_NONE;
+    }
+    wheel->current = 0;
+    wheel->count = 0;
+}
+
+void timing_wheel_free(TimingWheel *wheel) {
+    free(wheel->links);
+    wheel->links = NULL;
+}
+
+/**
+ * @brief Encadeia a entrada no slot correspondente ao seu deadline.
+ */
+static void place(TimingWheel *wheel, int32_t id) {
+    WheelLink *link = &wheel->links[id];
+    uint64_t deadline = link->deadline;
+
+    // Deadlines vencidos disparam no tick corrente; os muito distantes saturam no último nível
+    if (deadline < wheel->current) deadline = wheel->current;
+    if (deadline - wheel->current >= WHEEL_SPAN) deadline = wheel->current + WHEEL_SPAN - 1;
+
+    uint64_t delta = deadline - wheel->current;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= ((uint64_t)1 << (WHEEL_BITS * (level + 1)))) level++;
+
+    int slot = (int)((deadline >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    int32_t *head = &wheel->heads[level][slot];
+
+    link->bucket = level * WHEEL_SLOTS + slot;
+    link->prev = WHEEL_NONE;
+    link->next = *head;
+    if (*head != WHEEL_NONE) wheel->links[*head].prev = id;
+    *head = id;
+    wheel->occupied[level] |= 1ull << slot;
+}
+
+/**
+ * @brief Desencadeia a entrada do slot em que ela está.
+ */
+static void unlink_entry(TimingWheel *wheel, int32_t id) {
+    WheelLink *link = &wheel->links[id];
+    int level = link->bucket / WHEEL_SLOTS;
+    int slot = link->bucket % WHEEL_SLOTS;
+
+    if (link->prev != WHEEL_NONE) {
+        wheel->links[link->prev].next = link->next;
+    } else {
+        wheel->heads[level][slot] = link->next;
+        if (link->next == WHEEL_NONE) wheel->occupied[level] &= ~(1ull << slot);
+    }
+    if (link->next != WHEEL_NONE) wheel->links[link->next].prev = link->prev;
+
+    link->bucket = WHEEL_NONE;
+}
+
+/**
+ * @brief Agenda a entrada 'id' (ainda fora da roda) para expirar em deadline_ns.
+ */
+void timing_wheel_schedule(TimingWheel *wheel, int32_t id, uint64_t deadline_ns) {
+    wheel->links[id].deadline = wheel_tick(deadline_ns);
+    place(wheel, id);
+    wheel->count++;
+}
+
+/**
+ * @brief Retira a entrada da roda (Ex: despejo). Sem efeito se ela não estiver agendada.
+ */
+void timing_wheel_cancel(TimingWheel *wheel, int32_t id) {
+    if (wheel->links[id].bucket == WHEEL_NONE) return;
+
+    unlink_entry(wheel, id);
+    wheel->count--;
+}
+
+/**
+ * @brief Acompanha a movimentação de uma entrada no pool do chamador (from -> to).
+ * * O destino deve estar fora da roda; os vizinhos e a cabeça do slot passam a
+ * apontar para o novo índice.
+ */
+void timing_wheel_move(TimingWheel *wheel, int32_t from, int32_t to) {
+    WheelLink *link = &wheel->links[to];
+
+    *link = wheel->links[from];
+    wheel->links[from].bucket = WHEEL_NONE;
+    if (link->bucket == WHEEL_NONE) return;
+
+    if (link->prev != WHEEL_NONE) {
+        wheel->links[link->prev].next = to;
+    } else {
+        wheel->heads[link->bucket / WHEEL_SLOTS][link->bucket % WHEEL_SLOTS] = to;
+    }
+    if (link->next != WHEEL_NONE) wheel->links[link->next].prev = to;
+}
+
+/**
+ * @brief Redistribui um slot de nível superior pelos níveis abaixo dele.
+ */
+static void cascade(TimingWheel *wheel, int level) {
+    int slot = (int)((wheel->current >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    int32_t id = wheel->heads[level][slot];
+
+    wheel->heads[level][slot] = WHEEL_NONE;
+    wheel->occupied[level] &= ~(1ull << slot);
+
+    while (id != WHEEL_NONE) {
+        int32_t next = wheel->links[id].next;
+        place(wheel, id);
+        id = next;
+    }
+}
+
+/**
+ * @brief Avança a roda até now_ns e devolve uma entrada cujo deadline chegou.
+ * * Os ticks sem nada agendado no nível 0 são saltados via bitmap de ocupação,
+ * então um intervalo longo entre pacotes custa no máximo uma iteração por
+ * volta do nível 0, e não uma por tick.
+ * @return Índice da entrada expirada (já fora da roda), ou WHEEL_NONE.
+ */
+int32_t timing_wheel_expire(TimingWheel *wheel, uint64_t now_ns) {
+    uint64_t now = wheel_tick(now_ns);
+
+    // Roda vazia: nada a cascatear, o relógio simplesmente acompanha os pacotes
+    if (wheel->count == 0) {
+        if (now > wheel->current) wheel->current = now;
+        return WHEEL_NONE;
+    }
+
+    for (;;) {
+        int pos = (int)(wheel->current & WHEEL_MASK);
+        int32_t id = wheel->heads[0][pos];
+
+        if (id != WHEEL_NONE) {
+            if (wheel->current > now) return WHEEL_NONE;
+            unlink_entry(wheel, id);
+            wheel->count--;
+            return id;
+        }
+        if (wheel->current >= now) return WHEEL_NONE;
+
+        // Próximo slot ocupado desta volta do nível 0 ou, se não houver, a próxima volta
+        uint64_t ahead = wheel->occupied[0] & (~0ull << pos);
+        uint64_t next = ahead ? (wheel->current & ~(uint64_t)WHEEL_MASK) + (uint64_t)__builtin_ctzll(ahead)
+                              : (wheel->current | WHEEL_MASK) + 1;
+
+        if (next > now) {
+            wheel->current = now;
+            return WHEEL_NONE;
+        }
+        wheel->current = next;
+
+        // Fim de uma volta: desce os slots dos níveis superiores (do mais alto ao mais baixo)
+        if ((wheel->current & WHEEL_MASK) == 0) {
+            for (int level = WHEEL_LEVELS - 1; level > 0; level--) {
+                uint64_t mask = ((uint64_t)1 << (WHEEL_BITS * level)) - 1;
+                if ((wheel->current & mask) == 0) cascade(wheel, level);
+            }
+        }
+    }
+}
@@ -0,0 +1,463 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include "../../include/afpacket.h"
+#include "../../include/analyzer.h"
+#include "../../include/publisher.h"
+#include "../../include/filter.h"
+#include "../../include/capture.h"
+
+/* ========================================================================= *
+ * BACKEND AF_PACKET TPACKET_V3 (ZERO-COPY)                                  *
+ * ========================================================================= *
+ * O kernel escreve os frames diretamente em um anel de blocos mapeado via   *
+ * mmap(). O sensor percorre cada bloco liberado e entrega ao analisador um  *
+ * ponteiro para dentro do próprio anel, sem nenhuma cópia intermediária.   */
+
+static volatile sig_atomic_t ring_running = 1;
+
+/**
+ * @struct RingWorker
+ * @brief Contexto de um worker de captura: socket, anel mapeado e shard do IDS.
+ */
+typedef struct {
+    int id;
+    int fd;
+    uint8_t *ring;
+    size_t ring_size;
+    struct tpacket_req3 req;
+    IdsShard *shard;                    // Estado exclusivo deste worker (sem locks)
+    int burst;                          // Pacotes por chamada a analyze_batch_shard (1 = por pacote)
+    RingStats stats;
+    pthread_t thread;
+} RingWorker;
+
+/**
+ * @brief Preenche a configuração do anel com os valores padrão de afpacket.h.
+ */
+void ring_config_defaults(RingConfig *cfg) {
+    cfg->block_size = RING_BLOCK_SIZE;
+    cfg->block_count = RING_BLOCK_COUNT;
+    cfg->retire_ms = RING_RETIRE_MS;
+    cfg->workers = 1;
+    cfg->filter = NULL;
+    cfg->snaplen = SNAP_LEN;
+    cfg->burst = ANALYZE_BATCH_MAX;
+}
+
+/**
+ * @brief Sinaliza o laço de captura para encerrar no próximo poll().
+ * * Seguro para ser chamado de dentro de um signal handler.
+ */
+void stop_afpacket_sniffer(void) {
+    ring_running = 0;
+}
+
+/**
+ * @brief Lê (e zera) os contadores do kernel e acumula nas estatísticas do anel.
+ */
+static void collect_kernel_stats(int fd, RingStats *stats) {
+    struct tpacket_stats_v3 kstats;
+    socklen_t len = sizeof(kstats);
+
+    // PACKET_STATISTICS zera os contadores a cada leitura, por isso acumulamos
+    if (getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &kstats, &len) == 0) {
+        stats->packets += kstats.tp_packets;
+        stats->drops += kstats.tp_drops;
+        stats->freezes += kstats.tp_freeze_q_cnt;
+    }
+}
+
+static void print_ring_stats(const RingWorker *worker) {
+    const RingStats *stats = &worker->stats;
+    double per_block = stats->blocks ? (double)stats->packets / (double)stats->blocks : 0.0;
+    char tag[32];
+
+    printf("[RING w%d] blocos=%llu (timeout=%llu, com perda=%llu) | aceitos pelo filtro=%llu (%.1f/bloco) | drops=%llu | freezes=%llu\n",
+           worker->id, stats->blocks, stats->blocks_timeout, stats->blocks_losing,
+           stats->packets, per_block, stats->drops, stats->freezes);
+
+    snprintf(tag, sizeof(tag), "TRACKER w%d", worker->id);
+    print_tracker_stats(tag, worker->shard);
+}
+
+/**
+ * @brief Timestamp do frame em ns, preenchido pelo kernel (tp_nsec já é em ns no V3).
+ */
+static inline uint64_t frame_timestamp_ns(const struct tpacket3_hdr *frame) {
+    return (uint64_t)frame->tp_sec * NSEC_PER_SEC + frame->tp_nsec;
+}
+
+/**
+ * @brief Percorre todos os frames de um bloco liberado pelo kernel.
+ * * Os frames são analisados in-place: o ponteiro passado ao analisador aponta
+ * diretamente para a memória compartilhada do anel.
+ */
+static void walk_block(RingWorker *worker, struct tpacket_block_desc *block) {
+    uint32_t num_pkts = block->hdr.bh1.num_pkts;
+    struct tpacket3_hdr *frame = (struct tpacket3_hdr *)((uint8_t *)block + block->hdr.bh1.offset_to_first_pkt);
+
+    if (worker->burst <= 1) {
+        for (uint32_t i = 0; i < num_pkts; i++) {
+            analyze_packet_shard(worker->shard, (const u_char *)frame + frame->tp_mac,
+                                 (int)frame->tp_snaplen, (int)frame->tp_len, frame_timestamp_ns(frame));
+            frame = (struct tpacket3_hdr *)((uint8_t *)frame + frame->tp_next_offset);
+        }
+    } else {
+        // Os frames continuam no anel até o bloco ser devolvido: o lote referencia-os sem cópia
+        PacketRef refs[ANALYZE_BATCH_MAX];
+        size_t pending = 0;
+
+        for (uint32_t i = 0; i < num_pkts; i++) {
+            refs[pending++] = (PacketRef){ (const u_char *)frame + frame->tp_mac, frame->tp_snaplen,
+                                           frame->tp_len, frame_timestamp_ns(frame) };
+            if (pending == (size_t)worker->burst) {
+                analyze_batch_shard(worker->shard, refs, pending);
+                pending = 0;
+            }
+            frame = (struct tpacket3_hdr *)((uint8_t *)frame + frame->tp_next_offset);
+        }
+        if (pending > 0) analyze_batch_shard(worker->shard, refs, pending);
+    }
+
+    worker->stats.blocks++;
+    if (block->hdr.bh1.block_status & TP_STATUS_BLK_TMO) worker->stats.blocks_timeout++;
+    if (block->hdr.bh1.block_status & TP_STATUS_LOSING) worker->stats.blocks_losing++;
+}
+
+/**
+ * @brief Tipo de enlace (DLT_*) dos frames que um socket SOCK_RAW recebe da interface.
+ * * Equivale ao pcap_datalink() do backend pcap: Ethernet e loopback entregam o
+ * cabeçalho Ethernet; interfaces sem cabeçalho de enlace (tun, WireGuard, PPP)
+ * entregam o datagrama IP diretamente.
+ * @return DLT_* correspondente; -1 se o hardware da interface não é suportado.
+ */
+static int interface_datalink(const char *device) {
+    struct ifreq ifr;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", device);
+    int rc = fd < 0 ? -1 : ioctl(fd, SIOCGIFHWADDR, &ifr);
+    if (fd >= 0) close(fd);
+    if (rc < 0) return -1;
+
+    switch (ifr.ifr_hwaddr.sa_family) {
+        case ARPHRD_ETHER:
+        case ARPHRD_LOOPBACK:
+            return DLT_EN10MB;
+        case ARPHRD_NONE:
+        case ARPHRD_PPP:
+#ifdef ARPHRD_RAWIP
+        case ARPHRD_RAWIP:
+#endif
+            return DLT_RAW;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Cria o socket AF_PACKET, configura o anel TPACKET_V3 e associa à interface.
+ * * @param datalink Tipo de enlace da interface, para a compilação do filtro.
+ * @return Descritor do socket; encerra o processo em caso de falha (mesmo padrão do start_sniffer).
+ */
+static int open_ring_socket(const char *device, const RingConfig *cfg, int datalink, struct tpacket_req3 *req, int verbose) {
+    int fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (fd < 0) {
+        fprintf(stderr, "Erro: socket AF_PACKET.\nMotivo: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    // O filtro é anexado antes do bind para que nenhum frame não filtrado entre no anel;
+    // o valor de retorno do programa também aplica o snaplen
+    char default_filter[FILTER_MAX_LEN];
+    const char *filter = cfg->filter;
+    if (filter == NULL) {
+        build_default_filter(get_enabled_detectors(), get_flow_budget() > 0, datalink, default_filter, sizeof(default_filter));
+        filter = default_filter;
+    }
+    if (attach_socket_filter(fd, filter, cfg->snaplen, datalink, verbose) < 0) exit(1);
+
+    int version = TPACKET_V3;
+    if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        fprintf(stderr, "Erro: TPACKET_V3 não suportado.\nMotivo: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    memset(req, 0, sizeof(*req));
+    req->tp_block_size = cfg->block_size;
+    req->tp_block_nr = cfg->block_count;
+    req->tp_frame_size = RING_FRAME_SIZE;
+    // O produto é calculado em 64 bits: um anel de 4 GiB ou mais estouraria o unsigned int
+    uint64_t frames = (uint64_t)cfg->block_size * cfg->block_count / RING_FRAME_SIZE;
+    if (frames > UINT32_MAX) {
+        fprintf(stderr, "Erro: anel de %u blocos de %u KiB excede o limite de %u frames de %d bytes.\n",
+                cfg->block_count, cfg->block_size / 1024, UINT32_MAX, RING_FRAME_SIZE);
+        exit(1);
+    }
+    req->tp_frame_nr = (unsigned int)frames;
+    req->tp_retire_blk_tov = cfg->retire_ms;
+    req->tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+    if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, req, sizeof(*req)) < 0) {
+        fprintf(stderr, "Erro: PACKET_RX_RING (%u blocos de %u bytes).\nMotivo: %s\n",
+                cfg->block_count, cfg->block_size, strerror(errno));
+        exit(1);
+    }
+
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = (int)if_nametoindex(device);
+
+    if (addr.sll_ifindex == 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Erro: %s.\nMotivo: %s\n", device, strerror(errno));
+        exit(1);
+    }
+
+    // Modo promíscuo, equivalente ao promisc=1 do pcap_open_live. Sem ele, numa porta
+    // SPAN o sensor só veria os quadros endereçados ao host: a falha encerra a captura
+    struct packet_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.mr_ifindex = addr.sll_ifindex;
+    mreq.mr_type = PACKET_MR_PROMISC;
+    if (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        fprintf(stderr, "Erro: modo promíscuo em %s.\nMotivo: %s\n", device, strerror(errno));
+        exit(1);
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Decide, antes de qualquer worker entrar no grupo, se o kernel aceita PACKET_FANOUT_CBPF.
+ * * Todos os sockets de um grupo precisam usar o mesmo modo: um worker que caísse
+ * para HASH depois de outro criar o grupo em CBPF não conseguiria entrar, e um
+ * socket que já entrou em CBPF não pode repetir o PACKET_FANOUT em outro modo.
+ * A sonda usa um socket descartável no próprio group_id; ao fechá-lo, o grupo
+ * (que só tinha esse membro) deixa de existir, e os workers entram nele depois
+ * com o modo decidido aqui.
+ * @return PACKET_FANOUT_CBPF ou PACKET_FANOUT_HASH (kernels < 4.2).
+ */
+static int probe_fanout_mode(int group_id) {
+    struct sock_filter accept_all[] = { BPF_STMT(BPF_RET | BPF_K, 0) };
+    struct sock_fprog prog = { .len = 1, .filter = accept_all };
+    int fanout = (group_id & 0xffff) | (PACKET_FANOUT_CBPF << 16);
+    int mode = PACKET_FANOUT_HASH;
+
+    // Com protocolo ETH_P_ALL o socket já está ativo sem bind, o que o PACKET_FANOUT exige
+    int fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (fd >= 0 && setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) == 0 &&
+        setsockopt(fd, SOL_PACKET, PACKET_FANOUT_DATA, &prog, sizeof(prog)) == 0) {
+        mode = PACKET_FANOUT_CBPF;
+    } else {
+        fprintf(stderr, "[RING] PACKET_FANOUT_CBPF indisponível (%s); usando PACKET_FANOUT_HASH\n", strerror(errno));
+    }
+    if (fd >= 0) close(fd);
+    return mode;
+}
+
+/**
+ * @brief Associa o socket ao grupo de fanout, distribuindo os pacotes por IP de origem.
+ * * O PACKET_FANOUT_HASH do kernel usa o hash do fluxo (5-tupla), o que espalharia
+ * um port scan entre vários workers. Por isso o grupo usa um programa cBPF que
+ * devolve um hash apenas do endereço de origem: todos os pacotes de uma mesma
+ * origem caem no mesmo worker/shard. Kernels sem PACKET_FANOUT_CBPF (< 4.2)
+ * recebem o modo HASH, decidido uma única vez por probe_fanout_mode().
+ * @param mode Modo comum a todos os workers do grupo.
+ */
+static void join_fanout_group(int fd, int group_id, int mode) {
+    // No IPv6 só entram os bits do prefixo de agregação (--ipv6-prefix): os endereços
+    // temporários de um mesmo /64 precisam chegar ao mesmo shard
+    unsigned int prefix = get_ipv6_prefix() < 64 ? get_ipv6_prefix() : 64;
+    uint32_t mask_hi = prefix >= 32 ? 0xffffffffu : prefix ? 0xffffffffu << (32 - prefix) : 0;
+    uint32_t mask_lo = prefix >= 64 ? 0xffffffffu : prefix > 32 ? 0xffffffffu << (64 - prefix) : 0;
+
+    // Offsets relativos ao cabeçalho de rede (SKF_NET_OFF): no fanout o skb->data
+    // aponta para L2 em pacotes de saída e para L3 em pacotes de entrada. Sem offload
+    // de VLAN, um quadro com tag chega com o EtherType da tag e o cabeçalho de rede
+    // começando nela: as (até duas) tags são puladas com X como deslocamento, para que
+    // o tráfego de uma porta SPAN com VLAN também se espalhe entre os workers
+    struct sock_filter src_hash[] = {
+        BPF_STMT(BPF_LDX | BPF_W   | BPF_IMM, 0),                              // X = bytes de tags VLAN
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, SKF_AD_OFF + SKF_AD_PROTOCOL),   // EtherType
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_8021Q, 2, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_8021AD, 1, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_QINQ1, 0, 5),
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_IND, SKF_NET_OFF + 2),                // EtherType depois da tag
+        BPF_STMT(BPF_LDX | BPF_W   | BPF_IMM, 4),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_8021Q, 0, 2),                // QinQ: tag interna 802.1Q
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_IND, SKF_NET_OFF + 2),
+        BPF_STMT(BPF_LDX | BPF_W   | BPF_IMM, 8),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 2),
+        BPF_STMT(BPF_LD  | BPF_W   | BPF_IND, SKF_NET_OFF + 12),               // IPv4: ip_src
+        BPF_JUMP(BPF_JMP | BPF_JA, 8, 0, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, 10),
+        BPF_STMT(BPF_LD  | BPF_W   | BPF_IND, SKF_NET_OFF + 8),                // IPv6: 32 primeiros bits da origem
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, mask_hi),
+        BPF_STMT(BPF_ST, 0),                                                   // M[0]: X guarda o deslocamento
+        BPF_STMT(BPF_LD  | BPF_W   | BPF_IND, SKF_NET_OFF + 12),               // IPv6: 32 bits seguintes
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, mask_lo),
+        BPF_STMT(BPF_LDX | BPF_W   | BPF_MEM, 0),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, 0x9E3779B1),                       // Hash multiplicativo (Fibonacci)
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+        BPF_STMT(BPF_RET | BPF_A, 0),                                          // Kernel aplica "% num_workers"
+        BPF_STMT(BPF_RET | BPF_K, 0),                                          // Demais protocolos e 3+ tags: worker 0
+    };
+    struct sock_fprog prog = { .len = sizeof(src_hash) / sizeof(src_hash[0]), .filter = src_hash };
+
+    int fanout = (group_id & 0xffff) | (mode << 16);
+    if (setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0) {
+        fprintf(stderr, "Erro: PACKET_FANOUT.\nMotivo: %s\n", strerror(errno));
+        exit(1);
+    }
+    if (mode == PACKET_FANOUT_CBPF && setsockopt(fd, SOL_PACKET, PACKET_FANOUT_DATA, &prog, sizeof(prog)) < 0) {
+        fprintf(stderr, "Erro: PACKET_FANOUT_DATA.\nMotivo: %s\n", strerror(errno));
+        exit(1);
+    }
+}
+
+static void map_ring(RingWorker *worker) {
+    worker->ring_size = (size_t)worker->req.tp_block_size * worker->req.tp_block_nr;
+    worker->ring = mmap(NULL, worker->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, worker->fd, 0);
+    if (worker->ring == MAP_FAILED) {
+        // MAP_LOCKED pode falhar por RLIMIT_MEMLOCK; tenta novamente sem travar as páginas
+        worker->ring = mmap(NULL, worker->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, worker->fd, 0);
+    }
+    if (worker->ring == MAP_FAILED) {
+        fprintf(stderr, "Erro: mmap do anel (%zu bytes).\nMotivo: %s\n", worker->ring_size, strerror(errno));
+        exit(1);
+    }
+}
+
+/**
+ * @brief Laço principal de um worker: consome blocos do anel até o encerramento.
+ */
+static void run_ring_loop(RingWorker *worker) {
+    struct pollfd pfd = { .fd = worker->fd, .events = POLLIN | POLLERR, .revents = 0 };
+    unsigned int current = 0;
+    time_t last_report = time(NULL);
+
+    while (ring_running) {
+        struct tpacket_block_desc *block =
+            (struct tpacket_block_desc *)(worker->ring + (size_t)current * worker->req.tp_block_size);
+
+        // Bloco ainda pertence ao kernel: aguarda até que seja liberado
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+            poll(&pfd, 1, 1000);
+        } else {
+            walk_block(worker, block);
+
+            // Devolve o bloco ao kernel; a barreira garante que terminamos de ler os frames antes
+            __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+            current = (current + 1) % worker->req.tp_block_nr;
+        }
+
+        time_t now = time(NULL);
+        if (now - last_report >= RING_STATS_INTERVAL) {
+            collect_kernel_stats(worker->fd, &worker->stats);
+            print_ring_stats(worker);
+            last_report = now;
+        }
+    }
+
+    flush_ids_shard(worker->shard);
+    collect_kernel_stats(worker->fd, &worker->stats);
+    print_ring_stats(worker);
+}
+
+/**
+ * @brief Corpo da thread worker: fixa a CPU, abre a própria conexão AMQP e consome o anel.
+ */
+static void *ring_worker_main(void *arg) {
+    RingWorker *worker = arg;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(worker->id % cpus, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    init_queue();
+    run_ring_loop(worker);
+    close_queue();
+    return NULL;
+}
+
+/**
+ * @brief Inicia a captura via anel TPACKET_V3 na interface informada.
+ * * Alternativa ao start_sniffer() para links de alta taxa: elimina a cópia do
+ * kernel para o buffer da libpcap. Com cfg->workers > 1, cada worker abre o
+ * próprio socket/anel no mesmo grupo PACKET_FANOUT e possui um shard privado do
+ * IDS. Bloqueia até stop_afpacket_sniffer().
+ * * @param device Nome da interface de rede (Ex: eth0).
+ * @param cfg Dimensionamento do anel de blocos (aplicado a cada worker).
+ */
+void start_afpacket_sniffer(const char *device, const RingConfig *cfg) {
+    unsigned int count = cfg->workers ? cfg->workers : 1;
+    RingWorker *workers = calloc(count, sizeof(RingWorker));
+    int group_id = getpid() & 0xffff;
+    int fanout_mode = count > 1 ? probe_fanout_mode(group_id) : PACKET_FANOUT_HASH;
+
+    // Resolvido uma vez: todos os workers usam o decodificador especializado da interface
+    int datalink = interface_datalink(device);
+    if (datalink < 0) {
+        fprintf(stderr, "Erro: %s.\nMotivo: tipo de hardware da interface não suportado pelo backend afpacket\n", device);
+        exit(1);
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        workers[i].id = (int)i;
+        workers[i].fd = open_ring_socket(device, cfg, datalink, &workers[i].req, i == 0);
+        if (count > 1) join_fanout_group(workers[i].fd, group_id, fanout_mode);
+        map_ring(&workers[i]);
+        // O orçamento do rastreador é repartido igualmente entre os workers
+        workers[i].shard = create_ids_shard(SHARD_LIVE, get_tracker_budget() / count);
+        set_shard_datalink(workers[i].shard, datalink);
+        workers[i].burst = cfg->burst;
+    }
+
+    printf("[RING] AF_PACKET TPACKET_V3 em %s: %u worker(s) x %u blocos x %u KiB (retire=%u ms, snaplen=%d, lote=%d)\n",
+           device, count, cfg->block_count, cfg->block_size / 1024, cfg->retire_ms, cfg->snaplen, cfg->burst);
+
+    if (count == 1) {
+        // Modo single-thread: usa a conexão AMQP já aberta pela thread principal
+        run_ring_loop(&workers[0]);
+    } else {
+        for (unsigned int i = 0; i < count; i++) {
+            pthread_create(&workers[i].thread, NULL, ring_worker_main, &workers[i]);
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        munmap(workers[i].ring, workers[i].ring_size);
+        close(workers[i].fd);
+        destroy_ids_shard(workers[i].shard);
+    }
+    free(workers);
+}
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <pcap.h>
+#include "../../include/batch.h"
+#include "../../include/analyzer.h"
+#include "../../include/capture.h"
+#include "../../include/stats.h"
+#include "../../include/filter.h"
+
+/* ========================================================================= *
+ * ANÁLISE FORENSE EM LOTE                                                   *
+ * ========================================================================= *
+ * Os arquivos de um diretório são distribuídos entre um pool de threads.   *
+ * Cada thread acumula o próprio estado (shard forense) e, ao final, os     *
+ * shards são mesclados de forma determinística: os alertas são idênticos   *
+ * aos de uma execução serial (--jobs 1), independentemente do escalonamento.*/
+
+/**
+ * @struct BatchJob
+ * @brief Estado compartilhado do pool: lista de arquivos e o próximo índice livre.
+ */
+typedef struct {
+    char **files;
+    size_t file_count;
+    size_t next;                        // Próximo arquivo a ser reivindicado (atômico)
+} BatchJob;
+
+/**
+ * @struct BatchWorker
+ * @brief Contexto de uma thread do pool com o seu shard forense privado.
+ */
+typedef struct {
+    BatchJob *job;
+    const char *filter;
+    IdsShard *shard;
+    unsigned long long packets;
+    unsigned long long bytes;
+    pthread_t thread;
+} BatchWorker;
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @brief Lista os arquivos regulares do diretório em ordem alfabética.
+ */
+static char **list_capture_files(const char *directory, size_t *count) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) return NULL;
+
+    size_t capacity = 64, n = 0;
+    char **files = malloc(capacity * sizeof(char *));
+    struct dirent *entry;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        size_t len = strlen(directory) + strlen(entry->d_name) + 2;
+        char *path = malloc(len);
+        snprintf(path, len, "%s/%s", directory, entry->d_name);
+
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            free(path);
+            continue;
+        }
+
+        if (n == capacity) {
+            capacity *= 2;
+            files = realloc(files, capacity * sizeof(char *));
+        }
+        files[n++] = path;
+    }
+    closedir(dir);
+
+    qsort(files, n, sizeof(char *), compare_names);
+    *count = n;
+    return files;
+}
+
+/**
+ * @brief Processa um arquivo inteiro dentro do shard da thread chamadora.
+ */
+static void analyze_file(BatchWorker *worker, const char *path) {
+    char error_buffer[PCAP_ERRBUF_SIZE];
+    pcap_t *handle = pcap_open_offline_with_tstamp_precision(path, PCAP_TSTAMP_PRECISION_NANO, error_buffer);
+
+    if (handle == NULL) {
+        fprintf(stderr, "[BATCH] Ignorando %s: %s\n", path, error_buffer);
+        return;
+    }
+
+    // Cada arquivo traz o próprio tipo de enlace; o shard troca de decodificador entre arquivos
+    int datalink = pcap_datalink(handle);
+    if (set_shard_datalink(worker->shard, datalink) < 0) {
+        fprintf(stderr, "[BATCH] Ignorando %s: tipo de enlace %d não suportado\n", path, datalink);
+        pcap_close(handle);
+        return;
+    }
+
+    // O modo batch não exporta fluxos: o filtro padrão só considera os detectores
+    if (apply_capture_filter(handle, worker->filter, 0, 0) < 0) {
+        pcap_close(handle);
+        return;
+    }
+
+    struct pcap_pkthdr *header;
+    const u_char *packet;
+
+    // As taxas são medidas dentro de cada arquivo, qualquer que seja a thread
+    restart_rate_windows(worker->shard);
+
+    while (pcap_next_ex(handle, &header, &packet) == 1) {
+        analyze_packet_shard(worker->shard, packet, header->caplen, header->len, pcap_timestamp_ns(header, 1));
+        worker->packets++;
+        worker->bytes += header->len;
+    }
+
+    pcap_close(handle);
+}
+
+static void *batch_worker_main(void *arg) {
+    BatchWorker *worker = arg;
+    BatchJob *job = worker->job;
+
+    for (;;) {
+        size_t index = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (index >= job->file_count) break;
+        analyze_file(worker, job->files[index]);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Executa a análise forense de um diretório de capturas.
+ * * @param cfg Diretório de entrada e tamanho do pool de threads.
+ * @return Quantidade de alertas emitidos; -1 em caso de erro.
+ */
+int run_batch(const BatchConfig *cfg) {
+    BatchJob job = { NULL, 0, 0 };
+    job.files = list_capture_files(cfg->directory, &job.file_count);
+
+    if (job.files == NULL) {
+        fprintf(stderr, "Erro: não foi possível listar o diretório %s.\n", cfg->directory);
+        return -1;
+    }
+
+    unsigned int jobs = cfg->jobs;
+    if (jobs == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? (unsigned int)cpus : 1;
+    }
+    if (jobs > job.file_count && job.file_count > 0) jobs = (unsigned int)job.file_count;
+
+    printf("[BATCH] %zu arquivo(s) em %s, %u thread(s), filtro \"%s\"\n",
+           job.file_count, cfg->directory, jobs, cfg->filter ? cfg->filter : "padrão dos detectores");
+
+    uint64_t start = monotonic_ns();
+    BatchWorker *workers = calloc(jobs, sizeof(BatchWorker));
+
+    for (unsigned int i = 0; i < jobs; i++) {
+        workers[i].job = &job;
+        workers[i].filter = cfg->filter;
+        workers[i].shard = create_ids_shard(SHARD_FORENSIC, 0);
+        pthread_create(&workers[i].thread, NULL, batch_worker_main, &workers[i]);
+    }
+
+    // Mescla na ordem dos workers; como a mesclagem é comutativa, o resultado é único
+    unsigned long long packets = 0, bytes = 0;
+    for (unsigned int i = 0; i < jobs; i++) {
+        pthread_join(workers[i].thread, NULL);
+        packets += workers[i].packets;
+        bytes += workers[i].bytes;
+        if (i > 0) {
+            merge_ids_shard(workers[0].shard, workers[i].shard);
+            destroy_ids_shard(workers[i].shard);
+        }
+    }
+
+    uint64_t elapsed = monotonic_ns() - start;
+    int alerts = report_ids_shard(workers[0].shard);
+
+    printf("[BATCH] %llu pacotes, %llu bytes em %.3f s | %d alerta(s)\n",
+           packets, bytes, (double)elapsed / 1e9, alerts);
+
+    destroy_ids_shard(workers[0].shard);
+    free(workers);
+    for (size_t i = 0; i < job.file_count; i++) free(job.files[i]);
+    free(job.files);
+    return alerts;
+}
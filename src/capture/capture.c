@@ -1,21 +1,77 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pcap.h>
 // Importa as headers
 #include "../../include/capture.h"
 #include "../../include/analyzer.h"
+#include "../../include/filter.h"
+
+// Handle ativo, mantido para permitir o encerramento via sinal (pcap_breakloop)
+static pcap_t *active_handle = NULL;
+
+// 1 quando a interface aceitou timestamps em nanossegundos
+static int ts_nano = 0;
 
 void packet_handler(u_char *args, const struct pcap_pkthdr *header, const u_char *packet) {
-    analyze_packet(packet, header->len);
+    (void)args;
+    // caplen limita a leitura do buffer; len é o tamanho original no fio
+    analyze_packet(packet, header->caplen, header->len, pcap_timestamp_ns(header, ts_nano));
+}
+
+/**
+ * @brief Copia os cabeçalhos do pacote para o próximo slot livre do lote.
+ */
+void batch_append(PacketBatch *batch, const struct pcap_pkthdr *header, const u_char *packet) {
+    uint32_t copied = header->caplen < BATCH_SLOT_SIZE ? header->caplen : BATCH_SLOT_SIZE;
+    u_char *slot = batch->data[batch->count];
+
+    memcpy(slot, packet, copied);
+    batch->refs[batch->count++] = (PacketRef){ slot, copied, header->len, pcap_timestamp_ns(header, batch->nano) };
+}
+
+/**
+ * @brief Callback do pcap_dispatch no modo em lote: só acumula, a análise vem depois.
+ */
+static void batch_handler(u_char *args, const struct pcap_pkthdr *header, const u_char *packet) {
+    batch_append((PacketBatch *)args, header, packet);
+}
+
+/**
+ * @brief Interrompe o pcap_loop em andamento. Seguro para uso em signal handler.
+ */
+void stop_sniffer(void) {
+    if (active_handle != NULL) pcap_breakloop(active_handle);
+}
+
+/**
+ * @brief Exibe os contadores do kernel: pacotes aceitos pelo filtro e descartados.
+ */
+static void print_kernel_stats(pcap_t *handle) {
+    struct pcap_stat stats;
+
+    if (pcap_stats(handle, &stats) == 0) {
+        printf("[BPF] Kernel: %u pacotes aceitos pelo filtro | %u descartados (buffer) | %u descartados (interface)\n",
+               stats.ps_recv, stats.ps_drop, stats.ps_ifdrop);
+    }
 }
 
-void start_sniffer(char *device)
+/**
+ * @brief Inicia a captura via libpcap na interface informada.
+ * * @param device Nome da interface de rede (Ex: eth0).
+ * @param filter Expressão BPF anexada no kernel (NULL = derivada dos detectores e do tipo de enlace).
+ * @param snaplen Bytes copiados por frame (SNAP_LEN ou o perfil somente cabeçalhos).
+ * @param burst Pacotes por pcap_dispatch/analyze_batch (1 = pcap_loop por pacote).
+ */
+void start_sniffer(char *device, const char *filter, int snaplen, int burst)
 {
     char error_buffer[PCAP_ERRBUF_SIZE];
     pcap_t *handle;
 
 
-    handle = pcap_open_live(device, SNAP_LEN, 1, 1000, error_buffer);
+    // Equivalente ao pcap_open_live(), mas pedindo timestamps em nanossegundos
+    // antes da ativação (nem todo driver suporta; nesse caso ficam em µs)
+    handle = pcap_create(device, error_buffer);
 
     if (handle ==NULL)
     {
@@ -26,7 +82,52 @@ void start_sniffer(char *device)
         exit(1);
     }
 
+    pcap_set_snaplen(handle, snaplen);
+    pcap_set_promisc(handle, 1);
+    pcap_set_timeout(handle, 1000);
+    pcap_set_tstamp_precision(handle, PCAP_TSTAMP_PRECISION_NANO);
+
+    if (pcap_activate(handle) < 0)
+    {
+        fprintf(stderr, "Erro: %s.\nMotivo: %s\n", device, pcap_geterr(handle));
+        exit(1);
+    }
+    ts_nano = pcap_get_tstamp_precision(handle) == PCAP_TSTAMP_PRECISION_NANO;
+
+    // O tipo de enlace é resolvido aqui, uma vez: o analisador usa o decodificador especializado
+    int datalink = pcap_datalink(handle);
+    if (set_datalink(datalink) < 0) {
+        fprintf(stderr, "Erro: %s.\nMotivo: tipo de enlace %d não suportado\n", device, datalink);
+        exit(1);
+    }
+
+    // Pré-filtro no kernel: tráfego que nenhum detector usa nunca chega ao user-space
+    if (apply_capture_filter(handle, filter, get_flow_budget() > 0, 1) < 0) exit(1);
+
     printf("passou");
-    pcap_loop(handle, -1, packet_handler, NULL);
+    active_handle = handle;
+    if (burst <= 1) {
+        pcap_loop(handle, -1, packet_handler, NULL);
+    } else {
+        // Cada pcap_dispatch entrega até 'burst' pacotes de um único buffer do kernel,
+        // analisados em seguida numa só chamada
+        PacketBatch *batch = malloc(sizeof(PacketBatch));
+        int rc;
+
+        batch->nano = ts_nano;
+        do {
+            batch->count = 0;
+            rc = pcap_dispatch(handle, burst, batch_handler, (u_char *)batch);
+            if (batch->count > 0) analyze_batch(batch->refs, batch->count);
+        } while (rc >= 0);
+
+        free(batch);
+    }
+
+    flush_ids_shard(get_default_shard());
+    print_kernel_stats(handle);
+    print_tracker_stats("TRACKER", get_default_shard());
+    active_handle = NULL;
+    pcap_close(handle);
 }
 
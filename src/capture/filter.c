@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <linux/filter.h>
+#include <pcap.h>
+#include "../../include/filter.h"
+#include "../../include/analyzer.h"
+
+/* ========================================================================= *
+ * PRÉ-FILTRO BPF NO KERNEL                                                  *
+ * ========================================================================= *
+ * O filtro é compilado com a libpcap e anexado ao socket de captura, de     *
+ * modo que o tráfego irrelevante para os detectores é descartado dentro do  *
+ * kernel, antes de qualquer cópia ou troca de contexto.                     */
+
+/**
+ * @brief Monta o filtro padrão a partir dos detectores habilitados.
+ * * Ex: port scan + ICMP flood => "(ip or ip6) and (tcp or icmp or icmp6 or
+ * proto 47 or udp dst port 4789)", com GRE e VXLAN enquanto --tunnel-depth > 0;
+ * com --ipv6-prefix 0 e --tunnel-depth 0, apenas "ip and (tcp or icmp)". Na Ethernet a mesma
+ * expressão é repetida sob uma e duas tags VLAN: na libpcap cada "vlan"
+ * desloca em 4 bytes os offsets das primitivas que vêm depois dele.
+ * @param flows Tabela de fluxos ligada: TCP, UDP e ICMP sobem mesmo sem detector.
+ * @param datalink Tipo de enlace da captura (pcap_datalink).
+ */
+void build_default_filter(unsigned int detectors, int flows, int datalink, char *buffer, size_t size) {
+    char protocols[FILTER_MAX_LEN] = "";
+    char expression[FILTER_MAX_LEN];
+    int ipv6 = get_ipv6_prefix() > 0;
+
+    // O host sweep acompanha os destinos tanto de TCP quanto de ICMP
+    if (flows || (detectors & (DETECT_PORT_SCAN | DETECT_STEALTH | DETECT_SYN_FLOOD | DETECT_HOST_SWEEP))) strcat(protocols, " or tcp");
+    if (flows || (detectors & (DETECT_UDP_SCAN | DETECT_UDP_FLOOD))) strcat(protocols, " or udp");
+
+    // O UDP scan também lê os port-unreachables devolvidos às origens
+    if (flows || (detectors & (DETECT_ICMP_FLOOD | DETECT_HOST_SWEEP | DETECT_UDP_SCAN))) {
+        strcat(protocols, ipv6 ? " or icmp or icmp6" : " or icmp");
+    }
+
+    if (protocols[0] == '\0') {
+        // Nenhum detector ativo: nada precisa chegar ao user-space
+        snprintf(buffer, size, "less 1");
+        return;
+    }
+
+    // Túneis sobem inteiros: o filtro só enxerga os cabeçalhos externos
+    if (get_tunnel_depth() > 0) strcat(protocols, " or proto 47 or udp dst port 4789");
+
+    // Descarta o " or " inicial
+    snprintf(expression, sizeof(expression), "(%s and (%s))", ipv6 ? "(ip or ip6)" : "ip", protocols + 4);
+
+    if (datalink == DLT_EN10MB) {
+        snprintf(buffer, size, "%s or (vlan and (%s or (vlan and %s)))", expression, expression, expression);
+    } else {
+        snprintf(buffer, size, "%s", expression);
+    }
+}
+
+/**
+ * @brief Aplica a expressão informada ou, se NULL, o filtro padrão do tipo de enlace do handle.
+ * * @param flows Repassado a build_default_filter().
+ * @return 0 em caso de sucesso; -1 se a expressão for inválida.
+ */
+int apply_capture_filter(pcap_t *handle, const char *expression, int flows, int verbose) {
+    char default_filter[FILTER_MAX_LEN];
+
+    if (expression == NULL) {
+        build_default_filter(get_enabled_detectors(), flows, pcap_datalink(handle), default_filter, sizeof(default_filter));
+        expression = default_filter;
+    }
+    return apply_pcap_filter(handle, expression, verbose);
+}
+
+static void print_program(const char *expression, const struct bpf_program *program) {
+    printf("[BPF] Filtro \"%s\" compilado em %u instruções:\n", expression, program->bf_len);
+    for (u_int i = 0; i < program->bf_len; i++) {
+        printf("[BPF]   %s\n", bpf_image(&program->bf_insns[i], (int)i));
+    }
+}
+
+/**
+ * @brief Compila e aplica o filtro em um handle da libpcap (captura ao vivo ou offline).
+ * * @return 0 em caso de sucesso; -1 se a expressão for inválida.
+ */
+int apply_pcap_filter(pcap_t *handle, const char *expression, int verbose) {
+    struct bpf_program program;
+
+    if (pcap_compile(handle, &program, expression, 1, PCAP_NETMASK_UNKNOWN) < 0) {
+        fprintf(stderr, "Erro: filtro BPF \"%s\".\nMotivo: %s\n", expression, pcap_geterr(handle));
+        return -1;
+    }
+
+    if (verbose) print_program(expression, &program);
+
+    int rc = pcap_setfilter(handle, &program);
+    if (rc < 0) {
+        fprintf(stderr, "Erro: pcap_setfilter.\nMotivo: %s\n", pcap_geterr(handle));
+    }
+
+    pcap_freecode(&program);
+    return rc < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Compila o filtro para o tipo de enlace do socket e o anexa a ele (SO_ATTACH_FILTER).
+ * * A struct bpf_insn da libpcap tem o mesmo layout da struct sock_filter do kernel.
+ * O valor de retorno do programa ("ret #snaplen") também é o snaplen do AF_PACKET:
+ * o kernel copia para o anel apenas os primeiros snaplen bytes de cada frame.
+ * @return 0 em caso de sucesso; -1 em caso de erro.
+ */
+int attach_socket_filter(int fd, const char *expression, int snaplen, int datalink, int verbose) {
+    pcap_t *dead = pcap_open_dead(datalink, snaplen);
+    struct bpf_program program;
+
+    if (dead == NULL || pcap_compile(dead, &program, expression, 1, PCAP_NETMASK_UNKNOWN) < 0) {
+        fprintf(stderr, "Erro: filtro BPF \"%s\".\nMotivo: %s\n", expression, dead ? pcap_geterr(dead) : "pcap_open_dead");
+        if (dead) pcap_close(dead);
+        return -1;
+    }
+
+    if (verbose) print_program(expression, &program);
+
+    struct sock_fprog fprog = {
+        .len = (unsigned short)program.bf_len,
+        .filter = (struct sock_filter *)program.bf_insns
+    };
+
+    int rc = setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+    if (rc < 0) {
+        fprintf(stderr, "Erro: SO_ATTACH_FILTER.\nMotivo: %s\n", strerror(errno));
+    }
+
+    pcap_freecode(&program);
+    pcap_close(dead);
+    return rc < 0 ? -1 : 0;
+}
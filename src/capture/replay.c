@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <pcap.h>
+#include "../../include/replay.h"
+#include "../../include/analyzer.h"
+#include "../../include/stats.h"
+#include "../../include/filter.h"
+#include "../../include/capture.h"
+#include "../../include/header_kernel.h"
+
+/* ========================================================================= *
+ * REPLAY OFFLINE (PCAP / PCAPNG)                                            *
+ * ========================================================================= *
+ * Reexecuta o mesmo pipeline do analyze_packet() sobre capturas gravadas,  *
+ * permitindo reanálise de incidentes e benchmarks reproduzíveis sem root   *
+ * nem interface de rede.                                                    */
+
+static volatile sig_atomic_t replay_running = 1;
+
+/**
+ * @brief Interrompe o replay no próximo pacote. Seguro para uso em signal handler.
+ */
+void stop_replay(void) {
+    replay_running = 0;
+}
+
+/**
+ * @brief Dorme até o instante (monotônico) em que o pacote deve ser reproduzido.
+ */
+static void wait_until(uint64_t deadline_ns) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000ull),
+        .tv_nsec = (long)(deadline_ns % 1000000000ull)
+    };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && replay_running) {
+    }
+}
+
+static void print_stage(const char *name, uint64_t ns, unsigned long long packets) {
+    printf("[REPLAY]   %-10s %10.2f ms  (%7.1f ns/pacote)\n",
+           name, (double)ns / 1e6, packets ? (double)ns / (double)packets : 0.0);
+}
+
+/**
+ * @brief Imprime o relatório final de throughput e o tempo gasto em cada estágio.
+ */
+static void print_replay_report(const ReplayConfig *cfg, unsigned long long packets,
+                                unsigned long long bytes, uint64_t elapsed_ns) {
+    double seconds = (double)elapsed_ns / 1e9;
+    double pps = seconds > 0 ? (double)packets / seconds : 0.0;
+    double bps = seconds > 0 ? (double)bytes / seconds : 0.0;
+
+    printf("[REPLAY] %s: %llu pacotes, %llu bytes em %.3f s (%s, lote=%d)\n",
+           cfg->path, packets, bytes, seconds, cfg->speed > 0 ? "temporizado" : "velocidade máxima",
+           cfg->burst > 1 ? cfg->burst : 1);
+    printf("[REPLAY] Throughput: %.0f pacotes/s | %.2f MB/s (%.1f Mbit/s)\n",
+           pps, bps / 1e6, bps * 8 / 1e6);
+    printf("[REPLAY] Tempo por estágio:\n");
+    print_stage("leitura", stage_stats.read_ns, packets);
+    print_stage("análise", stage_stats.analyze_ns - stage_stats.publish_ns, packets);
+    print_stage("publicação", stage_stats.publish_ns, packets);
+    printf("[REPLAY] Mensagens publicadas: %llu\n", (unsigned long long)stage_stats.published);
+    print_tracker_stats("TRACKER", get_default_shard());
+}
+
+/**
+ * @brief Analisa os pacotes acumulados no lote e contabiliza o estágio de análise.
+ */
+static void flush_batch(PacketBatch *batch) {
+    if (batch->count == 0) return;
+
+    uint64_t t0 = monotonic_ns();
+    analyze_batch(batch->refs, batch->count);
+    stage_stats.analyze_ns += monotonic_ns() - t0;
+    batch->count = 0;
+}
+
+/**
+ * @brief Carrega a captura em memória e mede só a fase de decodificação.
+ * * A leitura fica fora da medição: o resultado é o custo por pacote do
+ * decodificador especializado, comparável entre capturas do mesmo tráfego
+ * gravadas com tipos de enlace diferentes. No Ethernet, cada implementação
+ * do kernel de cabeçalhos suportada pela CPU é medida em seguida, com o
+ * ganho sobre o decodificador e a conferência dos descritores.
+ */
+static void bench_link_decoder(pcap_t *handle, int datalink, unsigned int rounds) {
+    size_t capacity = 1024, count = 0;
+    PacketRef *refs = malloc(capacity * sizeof(PacketRef));
+    struct pcap_pkthdr *header;
+    const u_char *packet;
+    DecodeBenchmark base = { 0 }, bench;
+
+    while (replay_running && pcap_next_ex(handle, &header, &packet) == 1) {
+        if (count == capacity) {
+            capacity *= 2;
+            refs = realloc(refs, capacity * sizeof(PacketRef));
+        }
+        u_char *copy = malloc(header->caplen ? header->caplen : 1);
+        memcpy(copy, packet, header->caplen);
+        refs[count++] = (PacketRef){ copy, header->caplen, header->len, 0 };
+    }
+
+    const char *name = pcap_datalink_val_to_name(datalink);
+    if (benchmark_decoder(datalink, HEADER_KERNEL_NONE, refs, count, rounds, &base) == 0) {
+        printf("[REPLAY] Decodificador %s: %zu pacotes x %u passadas | %.2f ns/pacote (%.1f Mpps)\n",
+               name ? name : "?", count, rounds, base.ns_per_packet, base.ns_per_packet > 0 ? 1e3 / base.ns_per_packet : 0.0);
+    }
+
+    for (int kernel = HEADER_KERNEL_SCALAR; datalink == DLT_EN10MB && kernel <= (int)header_kernel_detect(); kernel++) {
+        if (benchmark_decoder(datalink, kernel, refs, count, rounds, &bench) != 0) break;
+        printf("[REPLAY] Kernel de cabeçalhos %s: %.2f ns/pacote (%.1f Mpps, %.2fx) | caminho rápido %zu/%zu | %s\n",
+               header_kernel_name((HeaderKernel)kernel), bench.ns_per_packet,
+               bench.ns_per_packet > 0 ? 1e3 / bench.ns_per_packet : 0.0,
+               bench.ns_per_packet > 0 ? base.ns_per_packet / bench.ns_per_packet : 0.0, bench.fast, count,
+               bench.mismatches ? "DESCRITORES DIVERGENTES" : "descritores idênticos");
+        if (bench.mismatches) fprintf(stderr, "[REPLAY] %zu descritores do kernel %s divergem do decodificador\n",
+                                      bench.mismatches, header_kernel_name((HeaderKernel)kernel));
+    }
+
+    for (size_t i = 0; i < count; i++) free((void *)refs[i].data);
+    free(refs);
+}
+
+/**
+ * @brief Reproduz uma captura gravada pelo pipeline de análise.
+ * * Com speed == 0 os pacotes são processados o mais rápido possível (modo
+ * benchmark). Com speed > 0 os intervalos originais são respeitados, divididos
+ * pelo multiplicador (Ex: 2.0 reproduz duas vezes mais rápido).
+ * * Com cfg->burst > 1 os cabeçalhos são copiados para um lote (a libpcap reutiliza
+ * o buffer a cada leitura) e analisados via analyze_batch(); a cópia entra no
+ * tempo de leitura, o que permite comparar os dois caminhos pelo relatório.
+ * * Com cfg->bench_decode > 0 nada é analisado: só a decodificação é medida (o
+ * decodificador de enlace e cada kernel de cabeçalhos suportado pela CPU).
+ * * @param cfg Arquivo de entrada (pcap/pcapng ou "-" para stdin), velocidade e lote.
+ */
+void start_replay(const ReplayConfig *cfg) {
+    char error_buffer[PCAP_ERRBUF_SIZE];
+    // Timestamps em ns: as janelas de detecção seguem o relógio da captura, não o do replay
+    pcap_t *handle = pcap_open_offline_with_tstamp_precision(cfg->path, PCAP_TSTAMP_PRECISION_NANO, error_buffer);
+
+    if (handle == NULL) {
+        fprintf(stderr, "Erro: %s.\nMotivo: %s\n", cfg->path, error_buffer);
+        exit(1);
+    }
+
+    // O decodificador segue o tipo de enlace do arquivo, resolvido uma única vez
+    int datalink = pcap_datalink(handle);
+    if (set_datalink(datalink) < 0) {
+        fprintf(stderr, "Erro: %s.\nMotivo: tipo de enlace %d não suportado\n", cfg->path, datalink);
+        exit(1);
+    }
+
+    if (apply_capture_filter(handle, cfg->filter, get_flow_budget() > 0, 1) < 0) exit(1);
+
+    if (cfg->bench_decode > 0) {
+        bench_link_decoder(handle, datalink, cfg->bench_decode);
+        pcap_close(handle);
+        return;
+    }
+
+    stage_timing_enabled = 1;
+    memset(&stage_stats, 0, sizeof(stage_stats));
+
+    struct pcap_pkthdr *header;
+    const u_char *packet;
+    unsigned long long packets = 0, bytes = 0;
+    uint64_t first_ts = 0, start = monotonic_ns();
+    int rc = 0;
+
+    PacketBatch *batch = cfg->burst > 1 ? malloc(sizeof(PacketBatch)) : NULL;
+    if (batch != NULL) {
+        batch->count = 0;
+        batch->nano = 1;
+    }
+
+    while (replay_running) {
+        uint64_t t0 = monotonic_ns();
+        rc = pcap_next_ex(handle, &header, &packet);
+        uint64_t t1 = monotonic_ns();
+        if (rc != 1) break;
+        stage_stats.read_ns += t1 - t0;
+
+        if (cfg->speed > 0) {
+            uint64_t ts = pcap_timestamp_ns(header, 1);
+            if (packets == 0) first_ts = ts;
+
+            // Reposiciona o pacote na linha do tempo original, escalada pelo multiplicador
+            uint64_t offset = ts > first_ts ? ts - first_ts : 0;
+            uint64_t deadline = start + (uint64_t)((double)offset / cfg->speed);
+
+            // Pacotes já devidos não esperam o lote encher enquanto o replay dorme
+            if (batch != NULL && deadline > t1) flush_batch(batch);
+            wait_until(deadline);
+            t1 = monotonic_ns();
+        }
+
+        if (batch != NULL) {
+            batch_append(batch, header, packet);
+            stage_stats.read_ns += monotonic_ns() - t1;
+            if (batch->count == (size_t)cfg->burst) flush_batch(batch);
+        } else {
+            analyze_packet(packet, header->caplen, header->len, pcap_timestamp_ns(header, 1));
+            stage_stats.analyze_ns += monotonic_ns() - t1;
+        }
+
+        packets++;
+        bytes += header->len;
+    }
+
+    if (batch != NULL) {
+        flush_batch(batch);
+        free(batch);
+    }
+
+    if (rc == PCAP_ERROR) {
+        fprintf(stderr, "[REPLAY] Erro de leitura: %s\n", pcap_geterr(handle));
+    }
+
+    flush_ids_shard(get_default_shard());
+    print_replay_report(cfg, packets, bytes, monotonic_ns() - start);
+    pcap_close(handle);
+}
@@ -76,6 +76,52 @@ class SOCIngestor:
 
         return None, None
 
+    def _write_top_talkers(self, data: dict) -> None:
+        """
+        Persiste o resumo periódico de maiores emissores (uma linha por métrica e posição).
+        O campo 'error' é o quanto o valor pode estar superestimado pelo Space-Saving.
+        """
+        ts = int(data.get('ts', 0))
+        points = []
+        for metric in ('bytes', 'packets', 'ports'):
+            for rank, talker in enumerate(data.get(metric, []), start=1):
+                points.append(
+                    Point("top_talkers")
+                    .tag("metric", metric)
+                    .tag("rank", str(rank))
+                    .tag("src_ip", talker.get('src_ip', '0.0.0.0'))
+                    .field("value", float(talker.get('value', 0)))
+                    .field("error", float(talker.get('error', 0)))
+                    .time(ts, write_precision='s')
+                )
+
+        self.write_api.write(bucket=INFLUX_BUCKET, record=points)
+        logger.info(f"📊 [TOP-K] Resumo de {data.get('interval', 0)}s com {len(points)} entradas")
+
+    def _write_flow(self, data: dict) -> None:
+        """
+        Persiste um registro de fluxo bidirecional exportado pelo sensor.
+        Os campos 'r*' são o sentido de resposta; o timestamp é o do último pacote.
+        """
+        point = Point("flows") \
+            .tag("proto", data.get('proto', 'UNKNOWN')) \
+            .tag("state", data.get('state', 'none')) \
+            .tag("reason", data.get('reason', 'idle')) \
+            .field("src_ip", data.get('src_ip', '0.0.0.0')) \
+            .field("dst_ip", data.get('dst_ip', '0.0.0.0')) \
+            .field("src_port", int(data.get('src_port', 0))) \
+            .field("dst_port", int(data.get('dst_port', 0))) \
+            .field("packets", int(data.get('packets', 0))) \
+            .field("bytes", float(data.get('bytes', 0))) \
+            .field("rpackets", int(data.get('rpackets', 0))) \
+            .field("rbytes", float(data.get('rbytes', 0))) \
+            .field("flags", int(data.get('flags', 0))) \
+            .field("rflags", int(data.get('rflags', 0))) \
+            .field("duration_ms", (int(data.get('last_ns', 0)) - int(data.get('first_ns', 0))) / 1e6) \
+            .time(int(data.get('last_ns', 0)), write_precision='ns')
+
+        self.write_api.write(bucket=INFLUX_BUCKET, record=point)
+
     def _process_event(self, ch, method, properties, body: bytes) -> None:
         """
         Callback disparado pelo RabbitMQ a cada nova mensagem na fila.
@@ -84,11 +130,25 @@ class SOCIngestor:
         try:
             # Desserialização do payload em C
             data = json.loads(body.decode('utf-8'))
+
+            # Mensagens de resumo são roteadas pelo campo 'type'; sem ele, é telemetria de pacote
+            if data.get('type') == 'top_talkers':
+                self._write_top_talkers(data)
+                return
+            if data.get('type') == 'flow':
+                self._write_flow(data)
+                return
+
             src_ip = data.get('src_ip', '0.0.0.0')
+            dst_ip = data.get('dst_ip', '0.0.0.0')
             proto = data.get('proto', 'UNKNOWN')
-            is_scan = data.get('is_scan', 0)
+            # O sensor publica o tipo do ataque; is_scan é derivado para os painéis existentes
+            scan_type = data.get('scan_type', 'none')
+            is_scan = 0 if scan_type == 'none' else 1
             bytes_count = data.get('bytes', 0)
             port = data.get('port', 0)
+            scan_ports = data.get('scan_ports', 0)
+            scan_hosts = data.get('scan_hosts', 0)
 
             # Construção do "Point" (linha) para o InfluxDB
             # Nota técnica: Casting para float em 'bytes' e 'is_scan' previne o erro HTTP 422
@@ -96,9 +156,17 @@ class SOCIngestor:
             point = Point("traffic") \
                 .tag("src_ip", src_ip) \
                 .tag("protocol", proto) \
+                .tag("scan_type", scan_type) \
+                .field("dst_ip", dst_ip) \
                 .field("port", int(port)) \
                 .field("bytes", float(bytes_count)) \
-                .field("is_scan", float(is_scan))
+                .field("is_scan", float(is_scan)) \
+                .field("scan_ports", int(scan_ports)) \
+                .field("scan_hosts", int(scan_hosts))
+
+            # Tráfego decapsulado pelo sensor: túnel e VNI/sessão viram tags para filtrar por espelhamento
+            if 'tunnel' in data:
+                point.tag("tunnel", data['tunnel']).tag("tunnel_id", str(data.get('tunnel_id', 0)))
 
             # Enriquecimento com coordenadas geográficas
             lat, lon = self._get_location(src_ip)
@@ -109,7 +177,7 @@ class SOCIngestor:
             self.write_api.write(bucket=INFLUX_BUCKET, record=point)
 
             # Feedback de console (Logger)
-            status_icon = "🚨 [ATTACK]" if is_scan == 1 else "✅ [NORMAL]"
+            status_icon = f"🚨 [ATTACK:{scan_type}]" if is_scan == 1 else "✅ [NORMAL]"
             logger.info(f"{status_icon} {proto} | IP: {src_ip} | Loc: {lat},{lon}")
 
         except json.JSONDecodeError:
@@ -1,23 +1,319 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <getopt.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
 #include "../include/publisher.h"
 #include "../include/capture.h"
+#include "../include/afpacket.h"
+#include "../include/replay.h"
+#include "../include/batch.h"
+#include "../include/analyzer.h"
+
+/* Backends de captura selecionáveis na inicialização */
+typedef enum {
+    BACKEND_PCAP,       // libpcap padrão (pcap_open_live + pcap_loop)
+    BACKEND_AFPACKET    // Anel AF_PACKET TPACKET_V3 zero-copy
+} CaptureBackend;
+
+static void usage(const char *prog) {
+    printf("Uso: %s [opções] <interface>\n", prog);
+    printf("     %s [opções] -r <arquivo.pcap|->\n", prog);
+    printf("     %s [opções] -d <diretório> [-j <threads>]\n", prog);
+    printf("  -b, --backend <pcap|afpacket>  Backend de captura (padrão: pcap)\n");
+    printf("      --ring-blocks <n>          Quantidade de blocos do anel AF_PACKET (padrão: %d)\n", RING_BLOCK_COUNT);
+    printf("      --ring-block-kb <kb>       Tamanho de cada bloco em KiB (padrão: %d)\n", RING_BLOCK_SIZE / 1024);
+    printf("      --ring-retire-ms <ms>      Timeout de aposentadoria de blocos (padrão: %d)\n", RING_RETIRE_MS);
+    printf("  -w, --workers <n>              Threads de captura em PACKET_FANOUT (implica afpacket)\n");
+    printf("  -r, --read <arquivo|->         Reanalisa uma captura pcap/pcapng (\"-\" lê do stdin)\n");
+    printf("      --speed <x>                Replay temporizado com multiplicador (padrão: 0 = máximo)\n");
+    printf("      --bench-decode <n>         Replay mede só a decodificação (decodificador de enlace e kernels escalar/SSE4.2/AVX2), em n passadas\n");
+    printf("  -d, --batch-dir <dir>          Análise forense em lote de todos os pcaps do diretório\n");
+    printf("  -j, --jobs <n>                 Threads do modo batch (padrão: uma por CPU)\n");
+    printf("  -f, --filter <expr>            Filtro BPF aplicado no kernel (padrão: derivado dos detectores e do enlace)\n");
+    printf("      --detectors <lista>        Detectores ativos: portscan,stealth,synflood,udpscan,udpflood,icmp,sweep (padrão: todos)\n");
+    printf("  -s, --snaplen <bytes>          Bytes capturados por frame (padrão: %d)\n", SNAP_LEN);
+    printf("  -H, --headers-only             Perfil somente cabeçalhos (snaplen %d, ajustado aos detectores)\n", SNAP_LEN_HEADERS);
+    printf("      --tracker-mb <mb>          Memória do rastreador de origens, repartida entre workers (padrão: %d)\n", TRACKER_BUDGET_MB);
+    printf("      --scan-threshold <n>       Portas distintas que caracterizam um port scan (padrão: %d)\n", SCAN_THRESHOLD);
+    printf("      --stealth-threshold <n>    Segmentos NULL/FIN/Xmas/SYN-FIN que caracterizam um stealth scan (padrão: %d)\n", STEALTH_THRESHOLD);
+    printf("      --synflood-rate <n>        Handshakes meio-abertos/s por serviço que caracterizam um SYN flood (padrão: %d)\n", SYNFLOOD_RATE);
+    printf("      --synflood-ratio <n>       Razão SYN/SYN-ACK que caracteriza um SYN flood (padrão: %d)\n", SYNFLOOD_RATIO);
+    printf("      --udp-scan-threshold <n>   Portas UDP distintas que caracterizam um UDP scan (padrão: %d)\n", UDP_SCAN_THRESHOLD);
+    printf("      --udp-unreach <n>          Port-unreachables que confirmam a sondagem e reduzem o limiar à metade (padrão: %d)\n", UDP_UNREACH_CONFIRM);
+    printf("      --udp-pps <n>              Pacotes UDP/s por origem que caracterizam um flood (padrão: %d)\n", UDP_PPS_THRESHOLD);
+    printf("      --udp-bps <n>              Bytes UDP/s por origem que caracterizam um flood (padrão: %d)\n", UDP_BPS_THRESHOLD);
+    printf("      --icmp-pps <n>             Pacotes ICMP/s por origem que caracterizam um flood (padrão: %d)\n", ICMP_PPS_THRESHOLD);
+    printf("      --icmp-bps <n>             Bytes ICMP/s por origem que caracterizam um flood (padrão: %d)\n", ICMP_BPS_THRESHOLD);
+    printf("      --icmp-window <ms>         Janela deslizante das taxas ICMP (padrão: %d)\n", ICMP_WINDOW_MS);
+    printf("      --promote-threshold <n>    Pacotes para uma origem nova entrar no rastreador cheio, 1 = sem filtro (padrão: %d)\n", PROMOTE_THRESHOLD);
+    printf("      --top-k <n>                Posições do resumo de maiores emissores, 0 = desliga (padrão: %d)\n", TOPK_SIZE);
+    printf("      --top-interval <s>         Intervalo entre resumos de maiores emissores (padrão: %d)\n", TOPK_INTERVAL_S);
+    printf("      --flow-mb <mb>             Memória da tabela de fluxos, 0 = telemetria por pacote (padrão: %d)\n", FLOW_TABLE_MB);
+    printf("      --flow-idle <s>            Inatividade que encerra um fluxo (padrão: %d)\n", FLOW_IDLE_S);
+    printf("      --flow-active <s>          Duração máxima de um fluxo antes de um registro parcial (padrão: %d)\n", FLOW_ACTIVE_S);
+    printf("      --ipv6-prefix <bits>       Bits do endereço IPv6 que identificam uma origem, 0 = ignora IPv6 (padrão: %d)\n", IPV6_PREFIX);
+    printf("      --tunnel-depth <n>         Túneis GRE/VXLAN/ERSPAN aninhados removidos antes da detecção, 0 = desliga (padrão: %d)\n", TUNNEL_DEPTH);
+    printf("      --sweep-threshold <n>      Destinos distintos que caracterizam um host sweep (padrão: %d)\n", SWEEP_THRESHOLD);
+    printf("      --sketch-audit             Compara o sketch de destinos com a contagem exata (modo batch)\n");
+    printf("      --burst <n>                Pacotes por lote de análise, 1 = por pacote (padrão: %d)\n", ANALYZE_BATCH_MAX);
+    printf("  -n, --no-broker                Não conecta ao RabbitMQ (eventos são descartados)\n");
+}
+
+/**
+ * @brief Converte a lista "portscan,icmp" na máscara de detectores do analisador.
+ * @return Máscara correspondente; 0 se algum nome for desconhecido.
+ */
+static unsigned int parse_detectors(char *list) {
+    unsigned int mask = 0;
+
+    for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        if (strcmp(name, "portscan") == 0) {
+            mask |= DETECT_PORT_SCAN;
+        } else if (strcmp(name, "stealth") == 0) {
+            mask |= DETECT_STEALTH;
+        } else if (strcmp(name, "synflood") == 0) {
+            mask |= DETECT_SYN_FLOOD;
+        } else if (strcmp(name, "icmp") == 0) {
+            mask |= DETECT_ICMP_FLOOD;
+        } else if (strcmp(name, "sweep") == 0) {
+            mask |= DETECT_HOST_SWEEP;
+        } else if (strcmp(name, "udpscan") == 0) {
+            mask |= DETECT_UDP_SCAN;
+        } else if (strcmp(name, "udpflood") == 0) {
+            mask |= DETECT_UDP_FLOOD;
+        } else {
+            fprintf(stderr, "Detector desconhecido: %s\n", name);
+            return 0;
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Lê um inteiro positivo de uma opção, sem aceitar sobras, sinal ou valores acima de max.
+ * @return 0 em caso de sucesso; -1 (com a mensagem em stderr) se o valor é inválido.
+ */
+static int parse_positive(const char *option, const char *arg, unsigned long max, unsigned long *value) {
+    char *end;
+
+    errno = 0;
+    *value = strtoul(arg, &end, 10);
+    if (errno != 0 || end == arg || *end != '\0' || arg[0] == '-' || *value == 0 || *value > max) {
+        fprintf(stderr, "Valor inválido para --%s: %s (inteiro entre 1 e %lu)\n", option, arg, max);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Valida --ring-block-kb: o bloco do TPACKET_V3 é múltiplo da página e do frame nominal.
+ * @return Tamanho do bloco em bytes; 0 (com a mensagem em stderr) se o valor é inválido.
+ */
+static unsigned int parse_ring_block_kb(const char *arg) {
+    unsigned long kb;
+    if (parse_positive("ring-block-kb", arg, UINT_MAX / 1024, &kb) < 0) return 0;
+
+    unsigned long bytes = kb * 1024;
+    long page = sysconf(_SC_PAGESIZE);
+    if ((page > 0 && bytes % (unsigned long)page != 0) || bytes % RING_FRAME_SIZE != 0) {
+        fprintf(stderr, "Valor inválido para --ring-block-kb: %s (o bloco precisa ser múltiplo da página de %ld bytes "
+                "e do frame de %d bytes)\n", arg, page, RING_FRAME_SIZE);
+        return 0;
+    }
+    return (unsigned int)bytes;
+}
+
+/**
+ * @brief Encerra a captura de forma graciosa ao receber SIGINT/SIGTERM (Ctrl+C).
+ * * Permite que o close_queue() seja executado e as estatísticas finais impressas.
+ */
+static void handle_signal(int signo) {
+    (void)signo;
+    stop_sniffer();
+    stop_afpacket_sniffer();
+    stop_replay();
+}
 
 int main(int argc, char *argv[]) {
+    CaptureBackend backend = BACKEND_PCAP;
+    RingConfig ring;
+    ring_config_defaults(&ring);
+    ReplayConfig replay = { .path = NULL, .speed = 0.0, .filter = NULL, .burst = ANALYZE_BATCH_MAX, .bench_decode = 0 };
+    BatchConfig batch = { .directory = NULL, .jobs = 0, .filter = NULL };
+    int use_broker = 1;
+    const char *filter = NULL;
+    int snaplen = SNAP_LEN;
+    int burst = ANALYZE_BATCH_MAX;
+
+    static const struct option long_opts[] = {
+        {"backend",        required_argument, NULL, 'b'},
+        {"ring-blocks",    required_argument, NULL, 1000},
+        {"ring-block-kb",  required_argument, NULL, 1001},
+        {"ring-retire-ms", required_argument, NULL, 1002},
+        {"workers",        required_argument, NULL, 'w'},
+        {"read",           required_argument, NULL, 'r'},
+        {"speed",          required_argument, NULL, 1003},
+        {"no-broker",      no_argument,       NULL, 'n'},
+        {"batch-dir",      required_argument, NULL, 'd'},
+        {"jobs",           required_argument, NULL, 'j'},
+        {"filter",         required_argument, NULL, 'f'},
+        {"detectors",      required_argument, NULL, 1004},
+        {"snaplen",        required_argument, NULL, 's'},
+        {"headers-only",   no_argument,       NULL, 'H'},
+        {"burst",          required_argument, NULL, 1005},
+        {"tracker-mb",     required_argument, NULL, 1006},
+        {"scan-threshold", required_argument, NULL, 1007},
+        {"sweep-threshold", required_argument, NULL, 1008},
+        {"sketch-audit",   no_argument,       NULL, 1009},
+        {"icmp-pps",       required_argument, NULL, 1010},
+        {"icmp-bps",       required_argument, NULL, 1011},
+        {"icmp-window",    required_argument, NULL, 1012},
+        {"promote-threshold", required_argument, NULL, 1013},
+        {"top-k",          required_argument, NULL, 1014},
+        {"top-interval",   required_argument, NULL, 1015},
+        {"stealth-threshold", required_argument, NULL, 1016},
+        {"synflood-rate",  required_argument, NULL, 1017},
+        {"synflood-ratio", required_argument, NULL, 1018},
+        {"flow-mb",        required_argument, NULL, 1019},
+        {"flow-idle",      required_argument, NULL, 1020},
+        {"flow-active",    required_argument, NULL, 1021},
+        {"udp-scan-threshold", required_argument, NULL, 1022},
+        {"udp-unreach",    required_argument, NULL, 1023},
+        {"udp-pps",        required_argument, NULL, 1024},
+        {"udp-bps",        required_argument, NULL, 1025},
+        {"ipv6-prefix",    required_argument, NULL, 1026},
+        {"bench-decode",   required_argument, NULL, 1027},
+        {"tunnel-depth",   required_argument, NULL, 1028},
+        {"help",           no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
 
-    if (argc != 2) {
-        printf("Uso: %s <interface>\n", argv[0]);
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:w:r:nd:j:f:s:Hh", long_opts, NULL)) != -1) {
+        switch (opt) {
+            case 'b':
+                if (strcmp(optarg, "pcap") == 0) {
+                    backend = BACKEND_PCAP;
+                } else if (strcmp(optarg, "afpacket") == 0) {
+                    backend = BACKEND_AFPACKET;
+                } else {
+                    fprintf(stderr, "Backend desconhecido: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 1000: {
+                unsigned long blocks;
+                if (parse_positive("ring-blocks", optarg, UINT_MAX, &blocks) < 0) return 1;
+                ring.block_count = (unsigned int)blocks;
+                break;
+            }
+            case 1001:
+                ring.block_size = parse_ring_block_kb(optarg);
+                if (ring.block_size == 0) return 1;
+                break;
+            case 1002: ring.retire_ms = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'w':
+                // O modo multi-worker depende do fanout do AF_PACKET
+                ring.workers = (unsigned int)strtoul(optarg, NULL, 10);
+                backend = BACKEND_AFPACKET;
+                break;
+            case 'r': replay.path = optarg; break;
+            case 1003: replay.speed = strtod(optarg, NULL); break;
+            case 'n': use_broker = 0; break;
+            case 'd': batch.directory = optarg; break;
+            case 'j': batch.jobs = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'f': filter = optarg; break;
+            case 's': snaplen = (int)strtol(optarg, NULL, 10); break;
+            case 'H': snaplen = SNAP_LEN_HEADERS; break;
+            case 1005: burst = (int)strtol(optarg, NULL, 10); break;
+            case 1006: set_tracker_budget((size_t)strtoul(optarg, NULL, 10) << 20); break;
+            case 1007: set_scan_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1008: set_sweep_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1009: set_sketch_audit(1); break;
+            case 1010: set_icmp_pps_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1011: set_icmp_bps_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1012: set_icmp_window((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1013: set_promote_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1014: set_topk_size((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1015: set_topk_interval((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1016: set_stealth_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1017: set_synflood_rate((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1018: set_synflood_ratio((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1019: set_flow_budget((size_t)strtoul(optarg, NULL, 10) << 20); break;
+            case 1020: set_flow_idle((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1021: set_flow_active((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1022: set_udp_scan_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1023: set_udp_unreach_confirm((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1024: set_udp_pps_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1025: set_udp_bps_threshold((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1026: set_ipv6_prefix((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1027: replay.bench_decode = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 1028: set_tunnel_depth((unsigned int)strtoul(optarg, NULL, 10)); break;
+            case 1004: {
+                unsigned int mask = parse_detectors(optarg);
+                if (mask == 0) return 1;
+                set_enabled_detectors(mask);
+                break;
+            }
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    // Replay e batch dispensam a interface; a captura ao vivo exige exatamente uma
+    int offline = replay.path != NULL || batch.directory != NULL;
+    if ((!offline && optind != argc - 1) || (offline && optind != argc)) {
+        usage(argv[0]);
         return 1;
     }
 
+    // Sem filtro explícito, cada backend monta o padrão dos detectores ativos depois
+    // de conhecer o tipo de enlace da captura
+    ring.filter = filter;
+
+    // Um snaplen menor que o lido pelos detectores truncaria os cabeçalhos que eles inspecionam
+    int minimum = required_snaplen(get_enabled_detectors());
+    if (snaplen < minimum) {
+        printf("[CAPTURE] snaplen %d insuficiente para os detectores ativos; usando %d\n", snaplen, minimum);
+        snaplen = minimum;
+    }
+    ring.snaplen = snaplen;
+
+    // O lote é limitado pelos vetores de tamanho fixo do analisador
+    if (burst < 1) burst = 1;
+    if (burst > ANALYZE_BATCH_MAX) burst = ANALYZE_BATCH_MAX;
+    ring.burst = burst;
+    replay.burst = burst;
+    replay.filter = filter;
+    batch.filter = filter;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
     printf("Iniciando sniffer (Pressione Ctrl+C para parar)\n");
 
     // Start sniffer
+    if (!use_broker) disable_queue();
     init_queue();
 
-    start_sniffer(argv[1]);
+    if (batch.directory != NULL) {
+        run_batch(&batch);
+    } else if (replay.path != NULL) {
+        start_replay(&replay);
+    } else if (backend == BACKEND_AFPACKET) {
+        start_afpacket_sniffer(argv[optind], &ring);
+    } else {
+        start_sniffer(argv[optind], filter, snaplen, burst);
+    }
 
     close_queue();
     return 0;
-}
\ No newline at end of file
+}
@@ -2,9 +2,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <arpa/inet.h>
 #include <amqp_tcp_socket.h>
 #include <amqp.h>
 #include <amqp_framing.h>
+#include "../../include/stats.h"
 
 /* ========================================================================= *
  * CONFIGURAÇÕES DO BROKER (RABBITMQ)                                        *
@@ -19,8 +21,35 @@
 #define MAX_FRAME_SIZE  131072          // Tamanho máximo do frame AMQP
 #define MAX_JSON_SIZE   512             // Buffer para o payload JSON
 
-// Estado global da conexão com o RabbitMQ mantido em memória
-static amqp_connection_state_t conn;
+// Estado da conexão com o RabbitMQ mantido em memória. É thread-local para que
+// cada worker de captura publique pelo próprio socket, sem lock no caminho quente.
+static _Thread_local amqp_connection_state_t conn;
+
+// Quando desligado (--no-broker), init_queue() não conecta e as mensagens são descartadas
+static int queue_disabled = 0;
+
+// Nome exibido no console e identificador publicado no JSON, indexados por ScanType
+static const char *const scan_labels[SCAN_TYPE_COUNT] = {
+    "NENHUMA", "PORT SCAN", "HOST SWEEP", "ICMP FLOOD",
+    "NULL SCAN", "FIN SCAN", "XMAS SCAN", "SYN/FIN SCAN", "ACK SCAN", "SYN FLOOD",
+    "UDP SCAN", "UDP FLOOD"
+};
+static const char *const scan_ids[SCAN_TYPE_COUNT] = {
+    "none", "port", "sweep", "icmp_flood", "null", "fin", "xmas", "syn_fin", "ack", "syn_flood",
+    "udp", "udp_flood"
+};
+
+// Identificador publicado no JSON e rótulo do console do túnel removido, indexados por TunnelType
+static const char *const tunnel_ids[TUNNEL_TYPE_COUNT] = { "none", "gre", "vxlan", "erspan" };
+static const char *const tunnel_labels[TUNNEL_TYPE_COUNT] = { "", "GRE chave", "VXLAN VNI", "ERSPAN sessão" };
+
+// Identificadores do estado TCP e do motivo de exportação de um fluxo
+static const char *const flow_states[FLOW_STATE_COUNT] = {
+    "none", "syn_sent", "syn_received", "established", "closing", "closed", "reset"
+};
+static const char *const flow_reasons[FLOW_END_COUNT] = {
+    "idle", "active", "fin", "rst", "evicted", "shutdown"
+};
 
 /* ========================================================================= *
  * FUNÇÕES INTERNAS (HELPERS)                                                *
@@ -35,6 +64,9 @@ static amqp_connection_state_t conn;
 static void send_message(const char *message) {
     amqp_basic_properties_t props;
 
+    // Sem conexão (modo --no-broker): a mensagem é apenas descartada
+    if (conn == NULL) return;
+
     // Configura as propriedades básicas do pacote AMQP
     props._flags = AMQP_BASIC_CONTENT_TYPE_FLAG | AMQP_BASIC_DELIVERY_MODE_FLAG;
     props.content_type = amqp_cstring_bytes("application/json");
@@ -48,15 +80,68 @@ static void send_message(const char *message) {
                        0, 0, &props, amqp_cstring_bytes(message));
 }
 
+/**
+ * @brief Serializa os dados da rede em JSON e os despacha para a mensageria.
+ * * Converte a estrutura plana do C em um formato compatível para que o
+ * ingestor em Python possa consumir, tipar e enviar ao InfluxDB.
+ * * @param src_ip Endereço IP do dispositivo origem (já em texto).
+ * @param dst_ip Endereço IP de destino (já em texto).
+ * @param event Porta, protocolo, tamanho, tipo de ataque, amplitudes e túnel de origem.
+ */
+static void format_and_send(const char* src_ip, const char* dst_ip, const IdsEvent *event) {
+    char message[MAX_JSON_SIZE];
+    char tunnel[64] = "", tunnel_tag[48] = "";
+
+    // Tratamento de segurança (fallback) para evitar NULL Pointers no snprintf
+    const char* safe_ip = src_ip ? src_ip : "0.0.0.0";
+    const char* safe_dst = dst_ip ? dst_ip : "0.0.0.0";
+    const char* safe_proto = event->proto ? event->proto : "UNKNOWN";
+
+    // Pacotes decapsulados levam o túnel (VNI, sessão ERSPAN ou chave GRE) de onde saíram
+    if (event->tunnel != TUNNEL_NONE && event->tunnel < TUNNEL_TYPE_COUNT) {
+        snprintf(tunnel, sizeof(tunnel), ", \"tunnel\":\"%s\", \"tunnel_id\":%u", tunnel_ids[event->tunnel], event->tunnel_id);
+        snprintf(tunnel_tag, sizeof(tunnel_tag), " [%s %u]", tunnel_labels[event->tunnel], event->tunnel_id);
+    }
+
+    // Constrói o payload estruturado
+    snprintf(message, sizeof(message),
+             "{\"src_ip\":\"%s\", \"dst_ip\":\"%s\", \"port\":%d, \"proto\":\"%s\", \"bytes\":%d, "
+             "\"scan_type\":\"%s\", \"scan_ports\":%u, \"scan_hosts\":%u%s}",
+             safe_ip, safe_dst, event->port, safe_proto, event->bytes, scan_type_id(event->scan_type),
+             event->scan_ports, event->scan_hosts, tunnel);
+
+    send_message(message);
+
+    // Feedback visual local no terminal do sensor
+    if (event->scan_type != SCAN_NONE) {
+        const char *signature = scan_type_label(event->scan_type);
+
+        if (event->scan_type == SCAN_SYN_FLOOD) {
+            printf("🚨 [IDS] Alerta de Segurança: Assinatura de SYN FLOOD detectada contra %s:%u%s\n",
+                   safe_dst, event->port, tunnel_tag);
+        } else if (event->scan_type == SCAN_HOST_SWEEP) {
+            printf("🚨 [IDS] Alerta de Segurança: Assinatura de HOST SWEEP detectada originada de %s (~%u destinos)%s\n",
+                   safe_ip, event->scan_hosts, tunnel_tag);
+        } else if (event->scan_type != SCAN_ICMP_FLOOD && event->scan_type != SCAN_UDP_FLOOD && event->scan_ports > 0) {
+            printf("🚨 [IDS] Alerta de Segurança: Assinatura de %s detectada originada de %s (varreu %u portas)%s\n",
+                   signature, safe_ip, event->scan_ports, tunnel_tag);
+        } else {
+            printf("🚨 [IDS] Alerta de Segurança: Assinatura de %s detectada originada de %s%s\n", signature, safe_ip, tunnel_tag);
+        }
+    }
+}
+
 /* ========================================================================= *
  * API PÚBLICA (Exposta via publisher.h)                                     *
  * ========================================================================= */
 
 /**
  * @brief Inicializa a comunicação TCP e o canal AMQP com o broker RabbitMQ.
- * * Esta função deve ser chamada apenas uma vez durante o boot do IDS.
+ * * Deve ser chamada uma vez durante o boot do IDS e uma vez por thread worker.
  */
 void init_queue() {
+    if (queue_disabled) return;
+
     conn = amqp_new_connection();
     amqp_socket_t *socket = amqp_tcp_socket_new(conn);
 
@@ -85,33 +170,149 @@ void init_queue() {
 }
 
 /**
- * @brief Serializa os dados da rede em JSON e os despacha para a mensageria.
- * * Converte a estrutura plana do C em um formato compatível para que o
- * ingestor em Python possa consumir, tipar e enviar ao InfluxDB.
- * * @param src_ip Endereço IP do dispositivo origem.
- * @param port Porta de destino acessada.
- * @param proto Protocolo de transporte/rede (Ex: TCP, UDP, ICMP).
- * @param bytes Tamanho capturado do pacote.
- * @param is_scan Flag booleana (1 para ataque, 0 para normal).
+ * @brief Desliga a mensageria: útil para replays e benchmarks sem um broker disponível.
+ * * Deve ser chamada antes de init_queue().
  */
-void publish_packet(const char* src_ip, int port, const char* proto, int bytes, int is_scan) {
+void disable_queue() {
+    queue_disabled = 1;
+}
+
+const char *scan_type_label(ScanType type) {
+    return (unsigned)type < SCAN_TYPE_COUNT ? scan_labels[type] : scan_labels[SCAN_NONE];
+}
+
+const char *scan_type_id(ScanType type) {
+    return (unsigned)type < SCAN_TYPE_COUNT ? scan_ids[type] : scan_ids[SCAN_NONE];
+}
+
+/**
+ * @brief Publica um único evento já com o IP em formato texto.
+ * * Ver format_and_send() para o formato do payload.
+ */
+void publish_packet(const char* src_ip, int port, const char* proto, int bytes, ScanType scan_type) {
+    uint64_t start = stage_timing_enabled ? monotonic_ns() : 0;
+
+    IdsEvent event = { .port = (uint16_t)port, .proto = proto, .bytes = bytes, .scan_type = scan_type };
+
+    format_and_send(src_ip, NULL, &event);
+
+    if (stage_timing_enabled) {
+        stage_stats.publish_ns += monotonic_ns() - start;
+        stage_stats.published++;
+    }
+}
+
+/**
+ * @brief Publica de uma vez os eventos acumulados por um lote do analisador.
+ * * A conversão do IP (IPv4 ou IPv6) para texto só acontece aqui, fora do laço de inspeção,
+ * e o tempo do lote inteiro é contabilizado numa única medição.
+ * * @param events Vetor de eventos na ordem em que os pacotes foram analisados.
+ * @param count Quantidade de eventos.
+ */
+void publish_events(const IdsEvent *events, size_t count) {
+    char src_str[INET6_ADDRSTRLEN], dst_str[INET6_ADDRSTRLEN];
+    uint64_t start = stage_timing_enabled ? monotonic_ns() : 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].ipv6) {
+            inet_ntop(AF_INET6, events[i].src6, src_str, sizeof(src_str));
+            inet_ntop(AF_INET6, events[i].dst6, dst_str, sizeof(dst_str));
+        } else {
+            inet_ntop(AF_INET, &events[i].src_ip, src_str, sizeof(src_str));
+            inet_ntop(AF_INET, &events[i].dst_ip, dst_str, sizeof(dst_str));
+        }
+        format_and_send(src_str, dst_str, &events[i]);
+    }
+
+    if (stage_timing_enabled) {
+        stage_stats.publish_ns += monotonic_ns() - start;
+        stage_stats.published += count;
+    }
+}
+
+/**
+ * @brief Publica os registros de fluxo exportados pelo analisador.
+ * * Formato: {"type":"flow", "src_ip", "dst_ip", "src_port", "dst_port", "proto",
+ * "packets", "bytes", "rpackets", "rbytes", "flags", "rflags", "first_ns",
+ * "last_ns", "state", "reason"}; os campos "r*" são do sentido de resposta.
+ */
+void publish_flows(const FlowRecord *flows, size_t count) {
     char message[MAX_JSON_SIZE];
+    char src_str[INET_ADDRSTRLEN], dst_str[INET_ADDRSTRLEN], proto_str[8];
+    uint64_t start = stage_timing_enabled ? monotonic_ns() : 0;
 
-    // Tratamento de segurança (fallback) para evitar NULL Pointers no snprintf
-    const char* safe_ip = src_ip ? src_ip : "0.0.0.0";
-    const char* safe_proto = proto ? proto : "UNKNOWN";
+    for (size_t i = 0; i < count; i++) {
+        const FlowRecord *flow = &flows[i];
+        const char *proto = flow->proto == IPPROTO_TCP ? "TCP" : flow->proto == IPPROTO_UDP ? "UDP"
+                          : flow->proto == IPPROTO_ICMP ? "ICMP" : NULL;
 
-    // Constrói o payload estruturado
-    snprintf(message, sizeof(message),
-             "{\"src_ip\":\"%s\", \"port\":%d, \"proto\":\"%s\", \"bytes\":%d, \"is_scan\":%d}",
-             safe_ip, port, safe_proto, bytes, is_scan);
+        if (proto == NULL) {
+            snprintf(proto_str, sizeof(proto_str), "%u", flow->proto);
+            proto = proto_str;
+        }
+        inet_ntop(AF_INET, &flow->src_ip, src_str, sizeof(src_str));
+        inet_ntop(AF_INET, &flow->dst_ip, dst_str, sizeof(dst_str));
+
+        snprintf(message, sizeof(message),
+                 "{\"type\":\"flow\", \"src_ip\":\"%s\", \"dst_ip\":\"%s\", \"src_port\":%u, \"dst_port\":%u, "
+                 "\"proto\":\"%s\", \"packets\":%u, \"bytes\":%llu, \"rpackets\":%u, \"rbytes\":%llu, "
+                 "\"flags\":%u, \"rflags\":%u, \"first_ns\":%llu, \"last_ns\":%llu, \"state\":\"%s\", \"reason\":\"%s\"}",
+                 src_str, dst_str, flow->src_port, flow->dst_port, proto,
+                 flow->packets[0], (unsigned long long)flow->bytes[0],
+                 flow->packets[1], (unsigned long long)flow->bytes[1],
+                 flow->tcp_flags[0], flow->tcp_flags[1],
+                 (unsigned long long)flow->first_ns, (unsigned long long)flow->last_ns,
+                 flow->state < FLOW_STATE_COUNT ? flow_states[flow->state] : "none",
+                 flow->reason < FLOW_END_COUNT ? flow_reasons[flow->reason] : "idle");
+        send_message(message);
+    }
+
+    if (stage_timing_enabled) {
+        stage_stats.publish_ns += monotonic_ns() - start;
+        stage_stats.published += count;
+    }
+}
+
+/**
+ * @brief Publica numa única mensagem os rankings top-K de um intervalo.
+ * * Formato: {"type":"top_talkers", "ts":..., "interval":..., "<métrica>":[{"src_ip",
+ * "value", "error"}, ...], ...}. O tamanho do payload depende de K, então o
+ * buffer é dimensionado a cada chamada em vez de usar MAX_JSON_SIZE.
+ * * @param ts_ns Fim do intervalo (timestamp de captura em ns).
+ * @param interval_s Duração do intervalo em segundos.
+ * @param lists Um ranking por métrica.
+ * @param list_count Quantidade de rankings.
+ */
+void publish_top_talkers(uint64_t ts_ns, unsigned int interval_s, const TopTalkerList *lists, int list_count) {
+    char src_str[INET_ADDRSTRLEN];
+    uint64_t start = stage_timing_enabled ? monotonic_ns() : 0;
+    size_t size = 128;
+
+    for (int l = 0; l < list_count; l++) size += 32 + (size_t)lists[l].count * 112;
+
+    char *message = malloc(size);
+    size_t used = (size_t)snprintf(message, size, "{\"type\":\"top_talkers\", \"ts\":%llu, \"interval\":%u",
+                                   (unsigned long long)(ts_ns / NSEC_PER_SEC), interval_s);
+
+    for (int l = 0; l < list_count; l++) {
+        used += (size_t)snprintf(message + used, size - used, ", \"%s\":[", lists[l].metric);
+        for (int i = 0; i < lists[l].count; i++) {
+            const TopTalker *talker = &lists[l].talkers[i];
+            inet_ntop(AF_INET, &talker->src_ip, src_str, sizeof(src_str));
+            used += (size_t)snprintf(message + used, size - used, "%s{\"src_ip\":\"%s\", \"value\":%llu, \"error\":%llu}",
+                                     i > 0 ? ", " : "", src_str,
+                                     (unsigned long long)talker->value, (unsigned long long)talker->error);
+        }
+        used += (size_t)snprintf(message + used, size - used, "]");
+    }
+    snprintf(message + used, size - used, "}");
 
     send_message(message);
+    free(message);
 
-    // Feedback visual local no terminal do sensor
-    if (is_scan) {
-        printf("🚨 [IDS] Alerta de Segurança: Assinatura de %s detectada originada de %s\n",
-               (strcmp(safe_proto, "ICMP") == 0) ? "ICMP FLOOD" : "PORT SCAN", safe_ip);
+    if (stage_timing_enabled) {
+        stage_stats.publish_ns += monotonic_ns() - start;
+        stage_stats.published++;
     }
 }
 
@@ -121,8 +322,11 @@ void publish_packet(const char* src_ip, int port, const char* proto, int bytes,
  * caso o programa em C seja finalizado pelo usuário (Ctrl+C).
  */
 void close_queue() {
+    if (conn == NULL) return;
+
     amqp_channel_close(conn, RMQ_CHANNEL, AMQP_REPLY_SUCCESS);
     amqp_connection_close(conn, AMQP_REPLY_SUCCESS);
     amqp_destroy_connection(conn);
+    conn = NULL;
     printf("🐰 [RABBIT] Conexão encerrada com segurança.\n");
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test_support.h"
+
+/* ========================================================================= *
+ * DETERMINISMO DO MODO BATCH (-j1 CONTRA -jN)                               *
+ * ========================================================================= *
+ * Cada cenário grava um diretório de capturas em que o estado de uma mesma  *
+ * origem se divide entre arquivos; com -jN cada thread fica com um arquivo, *
+ * e os alertas da mesclagem precisam ser idênticos aos da execução serial.  */
+
+#define FILLER_PACKETS 20000    // Tráfego benigno por arquivo: mantém cada thread ocupada com o seu
+#define PARALLEL_RUNS 3         // Execuções -jN comparadas com a serial (o escalonamento varia)
+#define ALERTS_MAX 8192
+#define MAX_FILES 4
+
+/**
+ * @struct Scenario
+ * @brief Diretório temporário de capturas de um cenário.
+ */
+typedef struct {
+    char dir[64];
+    FILE *files[MAX_FILES];
+    int count;
+    uint64_t ts;                        // Próximo timestamp (ns), crescente em todos os arquivos
+} Scenario;
+
+static int scenario_open(Scenario *sc, int count) {
+    char path[128];
+
+    snprintf(sc->dir, sizeof(sc->dir), "/tmp/nta-batch-XXXXXX");
+    if (mkdtemp(sc->dir) == NULL) return -1;
+
+    sc->count = count;
+    sc->ts = 1700000000ull * 1000000000ull;
+    for (int i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/part%d.pcap", sc->dir, i);
+        sc->files[i] = pcap_writer_open(path);
+        if (sc->files[i] == NULL) return -1;
+
+        // Uma conexão legítima longa por arquivo, de uma origem própria
+        TestFrame frame;
+        frame_tcp(&frame, htonl(0xc0a86400u + (uint32_t)i), test_ip("192.168.200.1"), 40000, 443, 0x18);
+        for (int p = 0; p < FILLER_PACKETS; p++) pcap_writer_add(sc->files[i], sc->ts += 1000, &frame);
+    }
+    return 0;
+}
+
+static void scenario_add(Scenario *sc, int file, const TestFrame *frame) {
+    pcap_writer_add(sc->files[file], sc->ts += 1000, frame);
+}
+
+static void scenario_close(Scenario *sc) {
+    for (int i = 0; i < sc->count; i++) fclose(sc->files[i]);
+}
+
+static void scenario_remove(const Scenario *sc) {
+    char path[128];
+
+    for (int i = 0; i < sc->count; i++) {
+        snprintf(path, sizeof(path), "%s/part%d.pcap", sc->dir, i);
+        unlink(path);
+    }
+    rmdir(sc->dir);
+}
+
+/**
+ * @brief Executa o sensor em modo batch e guarda só as linhas de alerta do relatório.
+ * @return 0 em caso de sucesso; -1 se o sensor falhou.
+ */
+static int run_sensor(const char *sensor, const char *dir, int jobs, char *alerts, size_t size) {
+    char command[512], line[512];
+    size_t used = 0;
+
+    snprintf(command, sizeof(command), "'%s' -n -d '%s' -j %d 2>/dev/null", sensor, dir, jobs);
+    FILE *out = popen(command, "r");
+    if (out == NULL) return -1;
+
+    alerts[0] = '\0';
+    while (fgets(line, sizeof(line), out) != NULL) {
+        if (strncmp(line, "[IDS]", 5) != 0) continue;
+        used += (size_t)snprintf(alerts + used, used < size ? size - used : 0, "%s", line);
+    }
+    return pclose(out) == 0 && used < size ? 0 : -1;
+}
+
+/**
+ * @brief Compara a execução serial com PARALLEL_RUNS execuções de uma thread por arquivo.
+ * @param serial Recebe os alertas da execução -j1.
+ */
+static int check_deterministic(const char *sensor, const Scenario *sc, char *serial) {
+    char parallel[ALERTS_MAX];
+
+    CHECK(run_sensor(sensor, sc->dir, 1, serial, ALERTS_MAX) == 0, "falha ao executar %s -j1", sensor);
+    for (int run = 0; run < PARALLEL_RUNS; run++) {
+        CHECK(run_sensor(sensor, sc->dir, sc->count, parallel, ALERTS_MAX) == 0, "falha ao executar %s -j%d", sensor, sc->count);
+        CHECK(strcmp(serial, parallel) == 0, "alertas divergentes\n-j1:\n%s-j%d:\n%s", serial, sc->count, parallel);
+    }
+    return 0;
+}
+
+/**
+ * @brief ACK scan: as portas de uma origem abertas por SYN num arquivo e só com ACKs no
+ * outro não contam; a origem que só envia ACKs isolados, dividida entre arquivos, conta.
+ */
+static int test_ack_scan(const char *sensor) {
+    Scenario sc;
+    TestFrame frame;
+    char alerts[ALERTS_MAX];
+
+    CHECK(scenario_open(&sc, 2) == 0, "não foi possível criar as capturas");
+    for (uint16_t port = 1000; port < 1020; port++) {
+        frame_tcp(&frame, test_ip("10.0.0.1"), test_ip("10.0.1.1"), 50000, port, 0x02);
+        scenario_add(&sc, 0, &frame);
+        frame_tcp(&frame, test_ip("10.0.0.1"), test_ip("10.0.1.1"), 50000, port, 0x10);
+        scenario_add(&sc, 1, &frame);
+        frame_tcp(&frame, test_ip("10.0.0.2"), test_ip("10.0.1.1"), 50000, (uint16_t)(port + 1000), 0x10);
+        scenario_add(&sc, port < 1010 ? 0 : 1, &frame);
+    }
+    scenario_close(&sc);
+
+    int failed = check_deterministic(sensor, &sc, alerts);
+    scenario_remove(&sc);
+    if (failed) return 1;
+
+    CHECK(strstr(alerts, "PORT SCAN: 10.0.0.1 (varreu 20 portas") != NULL, "PORT SCAN de 10.0.0.1 ausente:\n%s", alerts);
+    CHECK(strstr(alerts, "ACK SCAN: 10.0.0.1") == NULL, "portas abertas por SYN contadas como ACK scan:\n%s", alerts);
+    CHECK(strstr(alerts, "ACK SCAN: 10.0.0.2 (20 segmentos") != NULL, "ACK SCAN de 10.0.0.2 ausente:\n%s", alerts);
+    return 0;
+}
+
+/**
+ * @brief UDP scan: os port-unreachables chegam num arquivo diferente do das sondas e,
+ * somados na mesclagem, reduzem o limiar da origem à metade.
+ */
+static int test_udp_unreachable(const char *sensor) {
+    Scenario sc;
+    TestFrame probe, reply;
+    char alerts[ALERTS_MAX];
+
+    CHECK(scenario_open(&sc, 2) == 0, "não foi possível criar as capturas");
+    for (uint16_t port = 2000; port < 2010; port++) {
+        frame_udp(&probe, test_ip("10.0.0.3"), test_ip("10.0.1.3"), 53000, port, 0);
+        scenario_add(&sc, 0, &probe);
+        if (port < 2003) {
+            frame_port_unreachable(&reply, test_ip("10.0.1.3"), &probe);
+            scenario_add(&sc, 1, &reply);
+        }
+    }
+    scenario_close(&sc);
+
+    int failed = check_deterministic(sensor, &sc, alerts);
+    scenario_remove(&sc);
+    if (failed) return 1;
+
+    CHECK(strstr(alerts, "UDP SCAN: 10.0.0.3 (varreu 10 portas UDP distintas, 3 port-unreachable") != NULL,
+          "UDP SCAN confirmado de 10.0.0.3 ausente:\n%s", alerts);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Uso: %s <NetworkTrafficAnalyzer>\n", argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    failures += test_ack_scan(argv[1]);
+    failures += test_udp_unreachable(argv[1]);
+
+    if (failures == 0) printf("batch -j1 e -jN: alertas idênticos\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "test_support.h"
+#include "../include/analyzer.h"
+#include "../include/publisher.h"
+#include "../include/stats.h"
+
+/* ========================================================================= *
+ * DECODIFICADOR: QUADROS TRUNCADOS E MALFORMADOS                            *
+ * ========================================================================= *
+ * Cada quadro é copiado para o fim de uma página seguida de uma página sem  *
+ * permissão de acesso: qualquer leitura além do caplen derruba o teste. O   *
+ * quadro é cortado em todos os comprimentos, e um shard forense novo diz se *
+ * o pacote chegou aos detectores (toda origem decodificada é rastreada).    */
+
+#define NEVER INT_MAX           // O quadro não é aceito em nenhum comprimento
+#define CORPUS_MAX 32
+#define MUTATIONS 200000
+
+#define TH_SYN 0x02
+
+static const uint64_t TS = 1700000000ull * NSEC_PER_SEC;
+
+// Fim da área legível: a página seguinte é PROT_NONE
+static uint8_t *guard;
+
+// Quadros conferidos até aqui, reaproveitados pelo teste de mutações
+static TestFrame corpus[CORPUS_MAX];
+static size_t corpus_count;
+
+/**
+ * @brief Copia os caplen primeiros bytes do quadro para encostar na página protegida.
+ */
+static const u_char *guarded(const TestFrame *frame, int caplen) {
+    uint8_t *data = guard - caplen;
+    memcpy(data, frame->data, (size_t)caplen);
+    return data;
+}
+
+/* ========================================================================= *
+ * MONTAGEM DOS QUADROS                                                      *
+ * ========================================================================= */
+
+static size_t put_eth(uint8_t *p, uint16_t ethertype) {
+    static const uint8_t macs[12] = { 0x02, 0, 0, 0, 0, 0x01, 0x02, 0, 0, 0, 0, 0x02 };
+    memcpy(p, macs, sizeof(macs));
+    put16(p + 12, ethertype);
+    return 14;
+}
+
+/**
+ * @brief Cabeçalho IPv4 com 'options' bytes de NOP e 'payload' bytes de transporte.
+ */
+static size_t put_ipv4(uint8_t *p, uint32_t src, uint32_t dst, uint8_t proto, size_t options, size_t payload) {
+    size_t header = 20 + options;
+    memset(p, 0, 20);
+    memset(p + 20, 1, options);
+    p[0] = (uint8_t)(0x40 | header / 4);
+    put16(p + 2, (uint16_t)(header + payload));
+    p[8] = 64;
+    p[9] = proto;
+    memcpy(p + 12, &src, 4);
+    memcpy(p + 16, &dst, 4);
+    return header;
+}
+
+static size_t put_ipv6(uint8_t *p, uint8_t next, size_t payload) {
+    static const uint8_t src[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01 };
+    static const uint8_t dst[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0x01, 0, 0, 0, 0, 0, 0, 0, 0x01 };
+    memset(p, 0, 8);
+    p[0] = 0x60;
+    put16(p + 4, (uint16_t)payload);
+    p[6] = next;
+    p[7] = 64;
+    memcpy(p + 8, src, 16);
+    memcpy(p + 24, dst, 16);
+    return 40;
+}
+
+static size_t put_tcp_syn(uint8_t *p, uint16_t sport) {
+    memset(p, 0, 20);
+    put16(p, sport);
+    put16(p + 2, 80);
+    p[12] = 5 << 4;
+    p[13] = TH_SYN;
+    put16(p + 14, 65535);
+    return 20;
+}
+
+/* ========================================================================= *
+ * TRUNCAMENTO                                                               *
+ * ========================================================================= */
+
+/**
+ * @brief Corta o quadro em todos os comprimentos e confere quando ele é aceito.
+ * * O quadro é aceito a partir de 'boundary' bytes e, num túnel, também no
+ * intervalo [outer_from, outer_to), em que só o datagrama externo foi capturado
+ * e não há cabeçalho de túnel para remover. A origem rastreada é conferida com
+ * um SYN simples dela (0 = origem IPv6, não conferida): a contagem não muda.
+ */
+static int check_truncations(const char *name, const TestFrame *frame, int boundary,
+                             int outer_from, int outer_to, uint32_t inner, uint32_t outer) {
+    TrackerStats stats;
+    TestFrame plain;
+
+    if (corpus_count < CORPUS_MAX) corpus[corpus_count++] = *frame;
+
+    for (int caplen = 0; caplen <= (int)frame->len; caplen++) {
+        IdsShard *shard = create_ids_shard(SHARD_FORENSIC, 0);
+        int expected = caplen >= boundary || (caplen >= outer_from && caplen < outer_to);
+
+        analyze_packet_shard(shard, guarded(frame, caplen), caplen, (int)frame->len, TS);
+        get_tracker_stats(shard, &stats);
+        CHECK(stats.tracked == (unsigned long long)expected, "%s, caplen %d: %llu origens, esperado %d",
+              name, caplen, stats.tracked, expected);
+
+        uint32_t source = caplen >= boundary ? inner : outer;
+        if (expected && source != 0) {
+            frame_tcp(&plain, source, test_ip("192.168.0.1"), 1234, 80, TH_SYN);
+            analyze_packet_shard(shard, plain.data, (int)plain.len, (int)plain.len, TS);
+            get_tracker_stats(shard, &stats);
+            CHECK(stats.tracked == 1, "%s, caplen %d: a origem rastreada não é %08x", name, caplen, ntohl(source));
+        }
+        destroy_ids_shard(shard);
+    }
+    return 0;
+}
+
+/**
+ * @brief IPv4: opções, comprimento total, ip_hl, fragmentos e UDP truncado.
+ */
+static int test_ipv4(void) {
+    uint32_t src = test_ip("10.0.0.1"), dst = test_ip("192.168.0.1");
+    TestFrame frame;
+    uint8_t *ip = frame.data + 14;
+
+    // Portas e flags TCP vão até o byte 13 do transporte: 14 + 20 + 14
+    frame_tcp(&frame, src, dst, 40000, 80, TH_SYN);
+    if (check_truncations("IPv4/TCP", &frame, 48, 0, 0, src, 0)) return 1;
+
+    size_t len = put_eth(frame.data, 0x0800);
+    len += put_ipv4(frame.data + len, src, dst, 6, 4, 20);
+    len += put_tcp_syn(frame.data + len, 40000);
+    frame.len = len;
+    if (check_truncations("IPv4 com opções", &frame, 52, 0, 0, src, 0)) return 1;
+
+    // Comprimento total até as flags: o resto é padding e não é lido
+    frame_tcp(&frame, src, dst, 40000, 80, TH_SYN);
+    put16(ip + 2, 34);
+    if (check_truncations("IPv4 com padding", &frame, 48, 0, 0, src, 0)) return 1;
+    put16(ip + 2, 33);
+    if (check_truncations("IPv4 curto demais para as flags", &frame, NEVER, 0, 0, src, 0)) return 1;
+    put16(ip + 2, 0);
+    if (check_truncations("IPv4 com comprimento 0 (TSO)", &frame, 48, 0, 0, src, 0)) return 1;
+
+    frame_tcp(&frame, src, dst, 40000, 80, TH_SYN);
+    ip[0] = 0x4f;
+    if (check_truncations("ip_hl além do capturado", &frame, NEVER, 0, 0, src, 0)) return 1;
+    ip[0] = 0x44;
+    if (check_truncations("ip_hl abaixo do mínimo", &frame, NEVER, 0, 0, src, 0)) return 1;
+
+    frame_tcp(&frame, src, dst, 40000, 80, TH_SYN);
+    put16(ip + 6, 0x2000);
+    if (check_truncations("primeiro fragmento", &frame, 48, 0, 0, src, 0)) return 1;
+    put16(ip + 6, 0x0001);
+    if (check_truncations("fragmento não inicial", &frame, NEVER, 0, 0, src, 0)) return 1;
+
+    // UDP sem as portas ainda conta para os detectores volumétricos
+    frame_udp(&frame, src, dst, 40000, 53, 0);
+    return check_truncations("IPv4/UDP", &frame, 34, 0, 0, src, 0);
+}
+
+/**
+ * @brief Tags 802.1ad + 802.1Q empilhadas e o limite de VLAN_MAX_TAGS.
+ */
+static int test_vlan(void) {
+    uint32_t src = test_ip("10.0.0.2"), dst = test_ip("192.168.0.1");
+    TestFrame frame;
+
+    size_t len = put_eth(frame.data, 0x88a8);
+    put16(frame.data + len, 100);
+    put16(frame.data + len + 2, 0x8100);
+    put16(frame.data + len + 4, 200);
+    put16(frame.data + len + 6, 0x0800);
+    len += 8;
+    len += put_ipv4(frame.data + len, src, dst, 6, 0, 20);
+    len += put_tcp_syn(frame.data + len, 40000);
+    frame.len = len;
+    if (check_truncations("QinQ", &frame, 56, 0, 0, src, 0)) return 1;
+
+    // Uma terceira tag excede o limite
+    memmove(frame.data + 18, frame.data + 14, frame.len - 14);
+    put16(frame.data + 14, 300);
+    put16(frame.data + 16, 0x8100);
+    frame.len += 4;
+    return check_truncations("três tags VLAN", &frame, NEVER, 0, 0, src, 0);
+}
+
+/**
+ * @brief IPv6: cadeia de extensões, fragmentos e ICMPv6 de controle do enlace.
+ */
+static int test_ipv6(void) {
+    TestFrame frame;
+
+    // Hop-by-hop (8) + fragmento (8) + TCP: 14 + 40 + 16 + 14
+    size_t len = put_eth(frame.data, 0x86dd);
+    len += put_ipv6(frame.data + len, 0, 16 + 20);
+    uint8_t *hop = frame.data + len;
+    memset(hop, 0, 16);
+    hop[0] = 44;
+    hop[8] = 6;
+    put16(hop + 10, 0x0001);            // Offset 0, mais fragmentos
+    len += 16;
+    len += put_tcp_syn(frame.data + len, 40000);
+    frame.len = len;
+    if (check_truncations("IPv6 + extensões/TCP", &frame, 84, 0, 0, 0, 0)) return 1;
+
+    put16(hop + 10, 0x0008);
+    if (check_truncations("fragmento IPv6 não inicial", &frame, NEVER, 0, 0, 0, 0)) return 1;
+
+    // Hop-by-hop que declara 16 bytes, dos quais só 8 existem
+    put16(frame.data + 18, 8);
+    hop[0] = 6;
+    hop[1] = 1;
+    frame.len = 14 + 40 + 8;
+    if (check_truncations("extensão além do quadro", &frame, NEVER, 0, 0, 0, 0)) return 1;
+
+    // Echo request (128) é aceito a partir do tipo; Neighbor Solicitation (135), nunca
+    len = put_eth(frame.data, 0x86dd);
+    len += put_ipv6(frame.data + len, 58, 8);
+    memset(frame.data + len, 0, 8);
+    frame.data[len] = 128;
+    frame.len = len + 8;
+    if (check_truncations("ICMPv6 echo", &frame, 55, 0, 0, 0, 0)) return 1;
+    frame.data[len] = 135;
+    return check_truncations("ICMPv6 NDP", &frame, NEVER, 0, 0, 0, 0);
+}
+
+/**
+ * @brief GRE com chave e VXLAN: o pacote só conta com o cabeçalho interno inteiro.
+ */
+static int test_tunnels(void) {
+    uint32_t outer = test_ip("172.16.0.1"), inner = test_ip("10.0.0.3"), dst = test_ip("192.168.0.1");
+    TestFrame frame;
+
+    // 14 + 20 + GRE com chave (8) + 20 + 14
+    size_t len = put_eth(frame.data, 0x0800);
+    len += put_ipv4(frame.data + len, outer, test_ip("172.16.0.2"), 47, 0, 8 + 40);
+    memset(frame.data + len, 0, 8);
+    frame.data[len] = 0x20;
+    put16(frame.data + len + 2, 0x0800);
+    put16(frame.data + len + 6, 42);
+    len += 8;
+    len += put_ipv4(frame.data + len, inner, dst, 6, 0, 20);
+    len += put_tcp_syn(frame.data + len, 40000);
+    frame.len = len;
+    if (check_truncations("GRE", &frame, 76, 0, 0, inner, 0)) return 1;
+
+    // 14 + 20 + UDP (8) + VXLAN (8) + 14 + 20 + 14. Com menos de 4 bytes de UDP não
+    // há porta de destino, e até o fim do cabeçalho UDP não há VXLAN: conta o externo
+    len = put_eth(frame.data, 0x0800);
+    len += put_ipv4(frame.data + len, outer, test_ip("172.16.0.2"), 17, 0, 8 + 8 + 54);
+    put16(frame.data + len, 50000);
+    put16(frame.data + len + 2, 4789);
+    put16(frame.data + len + 4, 8 + 8 + 54);
+    put16(frame.data + len + 6, 0);
+    len += 8;
+    memset(frame.data + len, 0, 8);
+    frame.data[len] = 0x08;
+    frame.data[len + 6] = 7;
+    len += 8;
+    len += put_eth(frame.data + len, 0x0800);
+    len += put_ipv4(frame.data + len, inner, dst, 6, 0, 20);
+    len += put_tcp_syn(frame.data + len, 40000);
+    frame.len = len;
+    return check_truncations("VXLAN", &frame, 98, 34, 42, inner, outer);
+}
+
+/* ========================================================================= *
+ * MUTAÇÕES                                                                  *
+ * ========================================================================= */
+
+/**
+ * @brief Bytes sorteados dos quadros conferidos, cortados em comprimentos sorteados.
+ * * Campos de tamanho, ip_hl, extensões e flags de túnel aleatórios só podem
+ * levar ao descarte; a página protegida pega qualquer leitura fora do quadro.
+ */
+static int test_mutations(void) {
+    IdsShard *shard = create_ids_shard(SHARD_FORENSIC, 0);
+    uint64_t rng = 0x7a3c9d5e1b2f4068ull;
+    TrackerStats stats;
+    TestFrame frame;
+
+    CHECK(corpus_count > 0, "nenhum quadro para mutar");
+    for (int i = 0; i < MUTATIONS; i++) {
+        uint64_t r = test_random(&rng);
+        frame = corpus[r % corpus_count];
+
+        for (int flips = 1 + (int)((r >> 8) % 4); flips > 0; flips--) {
+            uint64_t pick = test_random(&rng);
+            frame.data[pick % frame.len] = (uint8_t)(pick >> 32);
+        }
+        int caplen = (int)((r >> 16) % (frame.len + 1));
+        analyze_packet_shard(shard, guarded(&frame, caplen), caplen, (int)frame.len, TS);
+    }
+
+    get_tracker_stats(shard, &stats);
+    CHECK(stats.tracked > 0 && stats.tracked <= MUTATIONS, "%llu origens após %d mutações", stats.tracked, MUTATIONS);
+    destroy_ids_shard(shard);
+    return 0;
+}
+
+int main(void) {
+    long page = sysconf(_SC_PAGESIZE);
+    uint8_t *area = mmap(NULL, (size_t)page * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED || mprotect(area + page, (size_t)page, PROT_NONE) != 0) {
+        perror("mmap");
+        return 1;
+    }
+    guard = area + page;
+
+    int failures = 0;
+
+    disable_queue();
+    set_flow_budget(0);
+    set_topk_size(0);
+
+    failures += test_ipv4();
+    failures += test_vlan();
+    failures += test_ipv6();
+    failures += test_tunnels();
+    failures += test_mutations();
+
+    if (failures == 0) printf("decodificador: nenhuma leitura além do caplen, limites conferem\n");
+    munmap(area, (size_t)page * 2);
+    return failures ? 1 : 0;
+}
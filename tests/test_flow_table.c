@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <netinet/in.h>
+#include "test_support.h"
+#include "../include/flow_table.h"
+
+/* ========================================================================= *
+ * TABELA DE FLUXOS BIDIRECIONAIS                                            *
+ * ========================================================================= *
+ * Os registros exportados são capturados por um destino de teste. Nenhum    *
+ * pacote pode se perder entre abertura, expiração e despejo: somados por    *
+ * 5-tupla e sentido, os registros reproduzem exatamente o tráfego gerado.   */
+
+#define MS 1000000ull
+#define SEC (1000 * MS)
+#define TUPLES 300
+#define EXPORTED_MAX 65536
+
+#define TH_FIN 0x01
+#define TH_SYN 0x02
+#define TH_RST 0x04
+#define TH_ACK 0x10
+
+// Registros entregues ao destino de exportação (zerados no início de cada teste)
+static FlowRecord exported[EXPORTED_MAX];
+static size_t exported_count;
+
+static void collect(const FlowRecord *flows, size_t count) {
+    for (size_t i = 0; i < count && exported_count < EXPORTED_MAX; i++) exported[exported_count++] = flows[i];
+}
+
+/**
+ * @struct Tuple
+ * @brief 5-tupla orientada do cliente para o servidor, com o tráfego de referência por sentido.
+ */
+typedef struct {
+    uint32_t client, server;
+    uint16_t client_port, server_port;
+    uint8_t proto;
+    uint64_t packets[2];                // [0] cliente -> servidor
+    uint64_t bytes[2];
+} Tuple;
+
+/**
+ * @brief Soma os registros exportados por 5-tupla e confere com o tráfego gerado.
+ */
+static int check_conservation(const Tuple *tuples, int count) {
+    static uint64_t packets[TUPLES][2], bytes[TUPLES][2];
+    memset(packets, 0, sizeof(packets));
+    memset(bytes, 0, sizeof(bytes));
+
+    CHECK(exported_count < EXPORTED_MAX, "registros demais para o teste");
+    for (size_t r = 0; r < exported_count; r++) {
+        const FlowRecord *flow = &exported[r];
+        int match = -1, swapped = 0;
+
+        CHECK(flow->first_ns <= flow->last_ns, "registro %zu termina antes de começar", r);
+        CHECK(flow->reason < FLOW_END_COUNT, "motivo %u inválido", flow->reason);
+        for (int t = 0; t < count && match < 0; t++) {
+            const Tuple *tuple = &tuples[t];
+            if (flow->proto != tuple->proto) continue;
+            if (flow->src_ip == tuple->client && flow->src_port == tuple->client_port &&
+                flow->dst_ip == tuple->server && flow->dst_port == tuple->server_port) match = t;
+            if (flow->src_ip == tuple->server && flow->src_port == tuple->server_port &&
+                flow->dst_ip == tuple->client && flow->dst_port == tuple->client_port) match = t, swapped = 1;
+        }
+        CHECK(match >= 0, "registro %zu não corresponde a nenhuma 5-tupla gerada", r);
+
+        // O sentido 0 do registro é o do primeiro pacote dele, que pode ter sido a resposta
+        for (int d = 0; d < 2; d++) {
+            packets[match][d ^ swapped] += flow->packets[d];
+            bytes[match][d ^ swapped] += flow->bytes[d];
+        }
+    }
+
+    for (int t = 0; t < count; t++) {
+        for (int d = 0; d < 2; d++) {
+            CHECK(packets[t][d] == tuples[t].packets[d] && bytes[t][d] == tuples[t].bytes[d],
+                  "5-tupla %d, sentido %d: %llu pacotes/%llu bytes exportados, %llu/%llu gerados", t, d,
+                  (unsigned long long)packets[t][d], (unsigned long long)bytes[t][d],
+                  (unsigned long long)tuples[t].packets[d], (unsigned long long)tuples[t].bytes[d]);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Tráfego aleatório nos dois sentidos, com ou sem pressão de memória.
+ * @param budget Orçamento da tabela; pequeno o bastante para forçar despejos quando evict = 1.
+ */
+static int run_conservation(size_t budget, int evict) {
+    static Tuple tuples[TUPLES];
+    uint64_t rng = 0xda3e39cb94b95bdbull;
+    uint64_t now = 1700000000ull * SEC;
+    FlowTable table;
+
+    for (int t = 0; t < TUPLES; t++) {
+        tuples[t] = (Tuple){ htonl(0x0a000001u + (uint32_t)(t % 37)), htonl(0xc0a80001u + (uint32_t)(t % 11)),
+                             (uint16_t)(40000 + t), (uint16_t)(t % 3 == 0 ? 53 : 443),
+                             (uint8_t)(t % 3 == 0 ? IPPROTO_UDP : IPPROTO_TCP), {0, 0}, {0, 0} };
+    }
+
+    exported_count = 0;
+    flow_table_init(&table, budget, 2 * SEC, 30 * SEC, collect);
+    CHECK(flow_table_bytes(&table) <= budget, "tabela (%zu bytes) acima do orçamento %zu", flow_table_bytes(&table), budget);
+
+    for (int p = 0; p < 40000; p++) {
+        uint64_t r = test_random(&rng);
+        // Metade dos pacotes vai para 10 fluxos quentes, que vivem além do tempo ativo
+        Tuple *tuple = &tuples[(r >> 8) & 1 ? r % 10 : r % TUPLES];
+        int dir = (int)((r >> 16) & 1);
+        int length = 60 + (int)((r >> 24) % 1400);
+
+        // Sem FIN/RST: os registros saem por inatividade, tempo ativo, despejo ou fim da captura.
+        // Como no analisador, o relógio da tabela avança antes de cada pacote
+        now += (r >> 40) % (25 * MS);
+        flow_table_expire(&table, now);
+        flow_table_update(&table, dir ? tuple->server : tuple->client, dir ? tuple->client : tuple->server,
+                          dir ? tuple->server_port : tuple->client_port, dir ? tuple->client_port : tuple->server_port,
+                          tuple->proto, tuple->proto == IPPROTO_TCP ? TH_ACK : 0, length, now);
+        tuple->packets[dir]++;
+        tuple->bytes[dir] += (uint64_t)length;
+
+        CHECK(table.count <= table.capacity, "%d fluxos com capacidade %d", table.count, table.capacity);
+    }
+
+    unsigned long long idle = table.exported[FLOW_END_IDLE], active = table.exported[FLOW_END_ACTIVE];
+    unsigned long long evicted = table.exported[FLOW_END_EVICTED];
+    flow_table_drain(&table);
+    CHECK(table.count == 0, "drain deixou %d fluxos abertos", table.count);
+
+    if (evict) {
+        CHECK(evicted > 0, "nenhum despejo com a tabela de %d fluxos", table.capacity);
+    } else {
+        CHECK(evicted == 0, "%llu despejos sem pressão de memória", evicted);
+        CHECK(idle > 0 && active > 0, "sem exportações por inatividade (%llu) ou tempo ativo (%llu)", idle, active);
+    }
+    if (check_conservation(tuples, TUPLES)) return 1;
+
+    flow_table_free(&table);
+    return 0;
+}
+
+static int test_conservation(void) {
+    if (run_conservation(8 << 20, 0)) return 1;
+    return run_conservation(4096, 1);
+}
+
+/**
+ * @brief Ciclo de vida TCP: handshake, fechamento pelos dois lados e RST.
+ */
+static int test_tcp_lifecycle(void) {
+    uint32_t client = test_ip("10.0.0.1"), server = test_ip("192.168.0.1");
+    uint64_t now = 1700000000ull * SEC;
+    FlowTable table;
+
+    exported_count = 0;
+    flow_table_init(&table, 1 << 20, 15 * SEC, 120 * SEC, collect);
+    flow_table_expire(&table, now);
+
+    flow_table_update(&table, client, server, 40000, 80, IPPROTO_TCP, TH_SYN, 60, now += MS);
+    CHECK(table.flows[0].state == FLOW_STATE_SYN_SENT, "SYN: estado %u", table.flows[0].state);
+    flow_table_update(&table, server, client, 80, 40000, IPPROTO_TCP, TH_SYN | TH_ACK, 60, now += MS);
+    CHECK(table.flows[0].state == FLOW_STATE_SYN_RECEIVED, "SYN-ACK: estado %u", table.flows[0].state);
+    flow_table_update(&table, client, server, 40000, 80, IPPROTO_TCP, TH_ACK, 60, now += MS);
+    CHECK(table.flows[0].state == FLOW_STATE_ESTABLISHED, "ACK: estado %u", table.flows[0].state);
+    flow_table_update(&table, client, server, 40000, 80, IPPROTO_TCP, TH_FIN | TH_ACK, 60, now += MS);
+    CHECK(table.flows[0].state == FLOW_STATE_CLOSING, "FIN do cliente: estado %u", table.flows[0].state);
+    flow_table_update(&table, server, client, 80, 40000, IPPROTO_TCP, TH_FIN | TH_ACK, 60, now += MS);
+    CHECK(table.flows[0].state == FLOW_STATE_CLOSED, "FIN do servidor: estado %u", table.flows[0].state);
+    CHECK(table.count == 1, "o fluxo bidirecional ocupou %d entradas", table.count);
+
+    // O último ACK chega durante a espera e ainda entra no registro
+    flow_table_update(&table, client, server, 40000, 80, IPPROTO_TCP, TH_ACK, 60, now += MS);
+    flow_table_expire(&table, now += SEC / 2);
+    CHECK(exported_count == 0 && table.count == 1, "fluxo exportado antes do fim da espera");
+
+    // RST encerra outro fluxo na hora, com a mesma espera
+    flow_table_update(&table, client, server, 40001, 80, IPPROTO_TCP, TH_SYN, 60, now += MS);
+    flow_table_update(&table, server, client, 80, 40001, IPPROTO_TCP, TH_RST | TH_ACK, 60, now += MS);
+
+    for (int i = 0; i < 40; i++) flow_table_expire(&table, now += 100 * MS);
+    flow_table_flush(&table);
+    CHECK(table.count == 0, "%d fluxos encerrados continuam abertos", table.count);
+    CHECK(exported_count == 2, "%zu registros exportados, esperados 2", exported_count);
+
+    const FlowRecord *fin = exported[0].src_port == 40000 ? &exported[0] : &exported[1];
+    const FlowRecord *rst = fin == &exported[0] ? &exported[1] : &exported[0];
+    CHECK(fin->reason == FLOW_END_FIN && fin->state == FLOW_STATE_CLOSED, "fechamento: motivo %u, estado %u", fin->reason, fin->state);
+    CHECK(fin->src_ip == client && fin->packets[0] == 4 && fin->packets[1] == 2, "fechamento: %u/%u pacotes por sentido",
+          fin->packets[0], fin->packets[1]);
+    CHECK(fin->tcp_flags[0] == (TH_SYN | TH_ACK | TH_FIN) && fin->tcp_flags[1] == (TH_SYN | TH_ACK | TH_FIN),
+          "flags por sentido %02x/%02x", fin->tcp_flags[0], fin->tcp_flags[1]);
+    CHECK(rst->reason == FLOW_END_RST && rst->state == FLOW_STATE_RESET, "RST: motivo %u, estado %u", rst->reason, rst->state);
+
+    flow_table_free(&table);
+    return 0;
+}
+
+/**
+ * @brief Prazos que vencem no meio de um tick da roda saem na primeira chamada do tick.
+ * * A roda só distingue ticks (~134 ms): um fluxo devolvido antes do seu prazo
+ * em nanossegundos, mas no mesmo tick, não pode voltar para o slot corrente e
+ * ser devolvido de novo a cada chamada, prendendo os outros fluxos do slot.
+ */
+static int test_expiry_within_tick(void) {
+    uint64_t tick_ns = 1ull << WHEEL_TICK_SHIFT;
+    uint64_t tick_start = (1700000000ull * SEC / tick_ns + 1) * tick_ns;
+    uint64_t created = tick_start + tick_ns / 2 - 2 * SEC;
+    FlowTable table;
+
+    exported_count = 0;
+    flow_table_init(&table, 1 << 20, 2 * SEC, 30 * SEC, collect);
+    flow_table_expire(&table, created);
+
+    // Dois fluxos com prazo de inatividade na metade do mesmo tick
+    flow_table_update(&table, test_ip("10.0.0.1"), test_ip("192.168.0.1"), 40000, 53, IPPROTO_UDP, 0, 60, created);
+    flow_table_update(&table, test_ip("10.0.0.2"), test_ip("192.168.0.1"), 40001, 53, IPPROTO_UDP, 0, 60, created + MS);
+
+    // O relógio avança dentro do tick, ainda antes dos prazos em nanossegundos
+    flow_table_expire(&table, tick_start - MS);
+    flow_table_flush(&table);
+    CHECK(exported_count == 0 && table.count == 2, "fluxos exportados antes do tick do prazo");
+    for (uint64_t now = tick_start; now < tick_start + tick_ns; now += 10 * MS) {
+        flow_table_expire(&table, now);
+        flow_table_flush(&table);
+        CHECK(exported_count == 2 && table.count == 0, "tick do prazo, %llu ms dentro dele: %zu de 2 fluxos exportados",
+              (unsigned long long)((now - tick_start) / MS), exported_count);
+        CHECK(table.expiry.count == 0, "%d fluxos reagendados no tick corrente", table.expiry.count);
+    }
+    CHECK(exported[0].reason == FLOW_END_IDLE && exported[1].reason == FLOW_END_IDLE, "motivos %u/%u",
+          exported[0].reason, exported[1].reason);
+
+    flow_table_free(&table);
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_conservation();
+    failures += test_tcp_lifecycle();
+    failures += test_expiry_within_tick();
+
+    if (failures == 0) printf("tabela de fluxos: registros conservam todo o tráfego\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "test_support.h"
+#include "../include/analyzer.h"
+#include "../include/header_kernel.h"
+#include "../include/publisher.h"
+#include "../include/stats.h"
+
+/* ========================================================================= *
+ * KERNEL DE CABEÇALHOS CONTRA O DECODIFICADOR DE ENLACE                     *
+ * ========================================================================= *
+ * Uma mistura de quadros dentro e fora do perfil do caminho rápido passa    *
+ * por cada nível de kernel suportado pela CPU. O descritor de todo pacote   *
+ * que o kernel resolve tem de ser idêntico ao do decodificador, e nenhum    *
+ * pacote do perfil pode ficar para trás. Cada quadro encosta numa página    *
+ * protegida, como no teste do decodificador: as cargas vetoriais não podem  *
+ * ler além do caplen.                                                       */
+
+#define PACKETS 4099            // Ímpar e fora de múltiplos de 32: sobras nos lotes e nos pares do AVX2
+#define FAST_CAPLEN 48          // Até o byte de flags TCP, como no kernel
+#define VXLAN_PORT 4789
+
+#define TH_SYN 0x02
+#define TH_ACK 0x10
+
+static const uint64_t TS = 1700000000ull * NSEC_PER_SEC;
+
+/**
+ * @enum Shape
+ * @brief Variações sorteadas para cada quadro da mistura.
+ */
+typedef enum {
+    SHAPE_TCP,                  // Perfil
+    SHAPE_UDP,                  // Perfil
+    SHAPE_FRAGMENT_FIRST,       // Perfil: MF com offset 0
+    SHAPE_PADDED,               // Perfil: comprimento total menor que o quadro
+    SHAPE_VXLAN,                // Perfil só com a decapsulação desligada
+    SHAPE_OPTIONS,
+    SHAPE_VLAN,
+    SHAPE_IPV6,
+    SHAPE_ICMP,
+    SHAPE_FRAGMENT,
+    SHAPE_SHORT_TOTAL,          // Comprimento total abaixo de IPv4 + flags TCP (inclui 0, TSO)
+    SHAPE_COUNT
+} Shape;
+
+/**
+ * @brief Monta um quadro da forma pedida com endereços, portas e campos ignorados sorteados.
+ * @return 1 se o quadro está no perfil do kernel (antes de truncar).
+ */
+static int build_frame(TestFrame *frame, Shape shape, uint64_t *rng, int tunnel_port) {
+    uint64_t r = test_random(rng);
+    uint32_t src = htonl(0x0a000000u | (uint32_t)(r & 0xffffff));
+    uint32_t dst = htonl(0xc0a80000u | (uint32_t)((r >> 24) & 0xffff));
+    uint16_t sport = (uint16_t)(r >> 40), dport = (uint16_t)(r >> 20);
+    if (dport == VXLAN_PORT) dport++;
+    uint8_t *ip = frame->data + 14;
+
+    if (shape == SHAPE_UDP || shape == SHAPE_VXLAN) {
+        frame_udp(frame, src, dst, sport, shape == SHAPE_VXLAN ? VXLAN_PORT : dport, (r >> 56) % 64);
+    } else if (shape == SHAPE_ICMP) {
+        frame_ipv4(frame, src, dst, 1, 8 + (r >> 56) % 64);
+        frame->data[TEST_L4_OFFSET] = 8;
+    } else {
+        frame_tcp(frame, src, dst, sport, dport, (r >> 56) & 1 ? TH_SYN : TH_ACK);
+    }
+
+    // Campos fora da comparação do perfil: TOS, identificação, DF, TTL e checksum
+    uint64_t noise = test_random(rng);
+    ip[1] = (uint8_t)noise;
+    put16(ip + 4, (uint16_t)(noise >> 8));
+    ip[6] = (noise >> 24) & 1 ? 0x40 : 0;
+    ip[8] = (uint8_t)(noise >> 32);
+    put16(ip + 10, (uint16_t)(noise >> 40));
+
+    switch (shape) {
+        case SHAPE_FRAGMENT_FIRST:
+            ip[6] |= 0x20;
+            return 1;
+        case SHAPE_PADDED:
+            put16(ip + 2, (uint16_t)(34 + (r >> 56) % 6));
+            return 1;
+        case SHAPE_VXLAN:
+            return tunnel_port == 0;
+        case SHAPE_OPTIONS:
+            memmove(ip + 24, ip + 20, frame->len - 34);
+            memset(ip + 20, 1, 4);
+            ip[0] = 0x46;
+            put16(ip + 2, (uint16_t)(frame->len - 14 + 4));
+            frame->len += 4;
+            return 0;
+        case SHAPE_VLAN:
+            memmove(frame->data + 16, frame->data + 12, frame->len - 12);
+            put16(frame->data + 12, 0x8100);
+            put16(frame->data + 14, (uint16_t)(noise & 0x0fff));
+            frame->len += 4;
+            return 0;
+        case SHAPE_IPV6:
+            // Mesmo tamanho de cabeçalhos que o IPv4 do perfil, mas EtherType e versão 6
+            put16(frame->data + 12, 0x86dd);
+            ip[0] = 0x60;
+            put16(ip + 4, 0);
+            ip[6] = 6;
+            return 0;
+        case SHAPE_FRAGMENT:
+            put16(ip + 6, (uint16_t)(1 + (noise >> 48) % 0x1fff));
+            return 0;
+        case SHAPE_SHORT_TOTAL:
+            put16(ip + 2, (uint16_t)((r >> 56) % 34));
+            return 0;
+        default:
+            return shape != SHAPE_ICMP;
+    }
+}
+
+/**
+ * @brief Sorteia a mistura; um quarto dos quadros é truncado num comprimento qualquer.
+ * * Cada quadro fica no fim da sua página, antes de uma página PROT_NONE.
+ * @return Pacotes que o kernel deve resolver.
+ */
+static size_t build_mix(uint8_t *area, long page, PacketRef *refs, int tunnel_port) {
+    uint64_t rng = 0x6a09e667f3bcc908ull;
+    size_t fast = 0;
+    TestFrame frame;
+
+    for (size_t i = 0; i < PACKETS; i++) {
+        uint64_t r = test_random(&rng);
+        int profile = build_frame(&frame, (Shape)(r % SHAPE_COUNT), &rng, tunnel_port);
+        size_t caplen = (r >> 8) % 4 == 0 ? (r >> 16) % (frame.len + 1) : frame.len;
+        uint8_t *data = area + (size_t)page * (2 * i + 1) - caplen;
+
+        memcpy(data, frame.data, caplen);
+        refs[i] = (PacketRef){ .data = data, .caplen = (uint32_t)caplen, .len = (uint32_t)frame.len, .ts_ns = TS + i };
+        fast += profile && caplen >= FAST_CAPLEN;
+    }
+    return fast;
+}
+
+/**
+ * @brief Todos os níveis suportados, com e sem decapsulação de VXLAN.
+ */
+static int test_kernels(uint8_t *area, long page, PacketRef *refs) {
+    for (unsigned int depth = 0; depth <= 1; depth++) {
+        DecodeBenchmark result;
+
+        set_tunnel_depth(depth);
+        size_t expected = build_mix(area, page, refs, depth > 0 ? VXLAN_PORT : 0);
+        CHECK(expected > 0 && expected < PACKETS, "mistura sem pacotes dentro e fora do perfil");
+
+        CHECK(benchmark_decoder(DLT_EN10MB, HEADER_KERNEL_NONE, refs, PACKETS, 1, &result) == 0, "DLT_EN10MB rejeitado");
+        CHECK(result.fast == 0, "sem kernel, %zu pacotes pelo caminho rápido", result.fast);
+
+        for (int kernel = HEADER_KERNEL_SCALAR; kernel <= (int)header_kernel_detect(); kernel++) {
+            const char *name = header_kernel_name((HeaderKernel)kernel);
+
+            CHECK(benchmark_decoder(DLT_EN10MB, kernel, refs, PACKETS, 1, &result) == 0, "kernel %s rejeitado", name);
+            CHECK(result.mismatches == 0, "kernel %s (túneis %u): %zu descritores diferentes do decodificador",
+                  name, depth, result.mismatches);
+            CHECK(result.fast == expected, "kernel %s (túneis %u): %zu pacotes resolvidos, esperados %zu",
+                  name, depth, result.fast, expected);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief O lote (kernel da CPU + decodificador) rastreia as mesmas origens que a análise pacote a pacote.
+ */
+static int test_batch_matches_packets(uint8_t *area, long page, PacketRef *refs) {
+    TrackerStats batch_stats, packet_stats;
+    IdsShard *batch = create_ids_shard(SHARD_FORENSIC, 0);
+    IdsShard *packet = create_ids_shard(SHARD_FORENSIC, 0);
+    int batch_alerts = 0, packet_alerts = 0;
+
+    set_tunnel_depth(1);
+    build_mix(area, page, refs, VXLAN_PORT);
+    for (size_t i = 0; i < PACKETS; i += ANALYZE_BATCH_MAX) {
+        size_t n = PACKETS - i < ANALYZE_BATCH_MAX ? PACKETS - i : ANALYZE_BATCH_MAX;
+        batch_alerts += analyze_batch_shard(batch, &refs[i], n);
+    }
+    for (size_t i = 0; i < PACKETS; i++) {
+        packet_alerts += analyze_packet_shard(packet, refs[i].data, (int)refs[i].caplen, (int)refs[i].len, refs[i].ts_ns);
+    }
+
+    get_tracker_stats(batch, &batch_stats);
+    get_tracker_stats(packet, &packet_stats);
+    CHECK(batch_stats.tracked == packet_stats.tracked, "lote rastreou %llu origens, pacote a pacote %llu",
+          batch_stats.tracked, packet_stats.tracked);
+    CHECK(batch_alerts == packet_alerts, "lote sinalizou %d pacotes, pacote a pacote %d", batch_alerts, packet_alerts);
+
+    destroy_ids_shard(batch);
+    destroy_ids_shard(packet);
+    return 0;
+}
+
+int main(void) {
+    static PacketRef refs[PACKETS];
+    long page = sysconf(_SC_PAGESIZE);
+    size_t size = (size_t)page * 2 * PACKETS;
+    uint8_t *area = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    for (size_t i = 0; i < PACKETS; i++) {
+        if (mprotect(area + (size_t)page * (2 * i + 1), (size_t)page, PROT_NONE) != 0) {
+            perror("mprotect");
+            return 1;
+        }
+    }
+
+    int failures = 0;
+
+    disable_queue();
+    set_flow_budget(0);
+    set_topk_size(0);
+
+    failures += test_kernels(area, page, refs);
+    failures += test_batch_matches_packets(area, page, refs);
+
+    if (failures == 0) {
+        printf("kernel de cabeçalhos: escalar até %s idênticos ao decodificador\n", header_kernel_name(header_kernel_detect()));
+    }
+    munmap(area, size);
+    return failures ? 1 : 0;
+}
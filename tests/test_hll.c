@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_support.h"
+#include "../include/hll.h"
+
+/* ========================================================================= *
+ * HYPERLOGLOG: PROMOÇÃO ESPARSO -> DENSO E MESCLAGEM                        *
+ * ========================================================================= *
+ * Os registradores de cada sketch são extraídos (em qualquer modo) e        *
+ * comparados com os calculados à parte. A mesclagem de shards tem de        *
+ * reproduzir exatamente o sketch de uma passada serial, e a estimativa não  *
+ * pode depender do modo em que os registradores estão guardados.            */
+
+#define PARTS 4
+
+/**
+ * @brief Registradores do sketch como vetor denso, qualquer que seja o modo.
+ * @return 0 se a lista esparsa está ordenada e sem índices repetidos.
+ */
+static int sketch_registers(const HllSketch *sketch, uint8_t *registers) {
+    if (sketch->capacity == HLL_DENSE) {
+        memcpy(registers, sketch->dense, HLL_REGISTERS);
+        return 0;
+    }
+
+    const uint16_t *items = sketch->capacity == 0 ? sketch->small : sketch->sparse;
+    memset(registers, 0, HLL_REGISTERS);
+    for (uint32_t i = 0; i < sketch->count; i++) {
+        CHECK(i == 0 || (items[i] >> 8) > (items[i - 1] >> 8), "lista esparsa fora de ordem na posição %u", i);
+        CHECK((items[i] & 0xff) != 0, "registrador nulo guardado na lista esparsa");
+        registers[items[i] >> 8] = (uint8_t)(items[i] & 0xff);
+    }
+    return 0;
+}
+
+/**
+ * @brief Aplica o hash ao vetor de referência, como hll_add() faria.
+ * @return 1 se algum registrador subiu.
+ */
+static int reference_add(uint8_t *registers, uint64_t hash) {
+    uint32_t index = (uint32_t)(hash >> (64 - HLL_PRECISION));
+    uint64_t rest = hash << HLL_PRECISION;
+    uint8_t rho = rest ? (uint8_t)(__builtin_clzll(rest) + 1) : (uint8_t)(64 - HLL_PRECISION + 1);
+
+    if (registers[index] >= rho) return 0;
+    registers[index] = rho;
+    return 1;
+}
+
+static int nonzero_registers(const uint8_t *registers) {
+    int count = 0;
+    for (int i = 0; i < HLL_REGISTERS; i++) count += registers[i] != 0;
+    return count;
+}
+
+/**
+ * @brief Elementos distintos um a um: registradores, modo e precisão da estimativa.
+ */
+static int test_promotion(void) {
+    uint8_t expected[HLL_REGISTERS] = {0}, actual[HLL_REGISTERS];
+    HllSketch sketch = {0};
+
+    for (uint64_t n = 1; n <= 100000; n++) {
+        uint64_t hash = hll_hash(n);
+        int raised = reference_add(expected, hash);
+
+        CHECK(hll_add(&sketch, hash) == raised, "hll_add do elemento %llu devolveu %d", (unsigned long long)n, !raised);
+        CHECK(hll_add(&sketch, hash) == 0, "elemento repetido alterou o sketch");
+        if (n > 2000 && n % 1000 != 0) continue;
+
+        if (sketch_registers(&sketch, actual)) return 1;
+        CHECK(memcmp(actual, expected, HLL_REGISTERS) == 0, "registradores divergentes após %llu elementos", (unsigned long long)n);
+
+        // Esparso enquanto couber em HLL_SPARSE_MAX registradores; depois denso, para sempre
+        int nonzero = nonzero_registers(expected);
+        if (nonzero <= HLL_SPARSE_INLINE) {
+            CHECK(sketch.capacity == 0, "%d registradores fora do modo inline", nonzero);
+        } else if (nonzero <= HLL_SPARSE_MAX) {
+            CHECK(sketch.capacity != HLL_DENSE && sketch.capacity >= nonzero, "%d registradores: lista esperada", nonzero);
+        } else {
+            CHECK(sketch.capacity == HLL_DENSE, "%d registradores fora do modo denso", nonzero);
+        }
+        CHECK(hll_heap_bytes(&sketch) == (sketch.capacity == HLL_DENSE ? HLL_REGISTERS : sketch.capacity * sizeof(uint16_t)),
+              "heap_bytes incoerente com o modo");
+
+        // Erro padrão de 6,5%: tolera 4 desvios (e 2 unidades nas contagens pequenas)
+        double error = (double)hll_count(&sketch) - (double)n;
+        double tolerance = n * 0.26 > 2.0 ? n * 0.26 : 2.0;
+        CHECK(error <= tolerance && -error <= tolerance, "estimativa %u para %llu elementos", hll_count(&sketch),
+              (unsigned long long)n);
+    }
+
+    hll_free(&sketch);
+    CHECK(sketch.capacity == 0 && sketch.count == 0 && hll_count(&sketch) == 0, "free não esvaziou o sketch");
+    return 0;
+}
+
+/**
+ * @brief Um fluxo dividido entre PARTS shards e mesclado equivale à passada serial.
+ * * Os tamanhos das partes variam de vazio a denso, de modo que a mesclagem
+ * percorre os pares esparso/esparso, esparso/denso, denso/esparso e denso/denso.
+ */
+static int test_merge(void) {
+    static const uint32_t sizes[] = { 0, 3, 20, 60, 150, 5000 };
+    const size_t size_count = sizeof(sizes) / sizeof(sizes[0]);
+    uint8_t serial_registers[HLL_REGISTERS], merged_registers[HLL_REGISTERS];
+    uint64_t rng = 0x853c49e6748fea9bull;
+
+    for (size_t s = 0; s < size_count * size_count; s++) {
+        HllSketch serial = {0}, parts[PARTS] = {{0}}, forward = {0}, backward = {0};
+        uint32_t total = sizes[s / size_count] + sizes[s % size_count];
+
+        // Elementos repetidos entre as partes, como uma origem vista por vários workers
+        for (uint32_t i = 0; i < total; i++) {
+            uint64_t hash = hll_hash(test_random(&rng) % (total + 1));
+            hll_add(&serial, hash);
+            hll_add(&parts[i < sizes[s / size_count] ? test_random(&rng) % 2 : 2 + test_random(&rng) % 2], hash);
+        }
+
+        for (int p = 0; p < PARTS; p++) hll_merge(&forward, &parts[p]);
+        for (int p = PARTS - 1; p >= 0; p--) hll_merge(&backward, &parts[p]);
+
+        if (sketch_registers(&serial, serial_registers)) return 1;
+        if (sketch_registers(&forward, merged_registers)) return 1;
+        CHECK(memcmp(serial_registers, merged_registers, HLL_REGISTERS) == 0, "mesclagem difere da passada serial (%u elementos)", total);
+        CHECK(hll_count(&forward) == hll_count(&serial), "estimativa mesclada %u, serial %u", hll_count(&forward), hll_count(&serial));
+        if (sketch_registers(&backward, merged_registers)) return 1;
+        CHECK(memcmp(serial_registers, merged_registers, HLL_REGISTERS) == 0, "mesclagem depende da ordem dos shards");
+        CHECK(hll_count(&backward) == hll_count(&serial), "estimativa depende da ordem dos shards");
+
+        hll_free(&serial);
+        hll_free(&forward);
+        hll_free(&backward);
+        for (int p = 0; p < PARTS; p++) hll_free(&parts[p]);
+    }
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_promotion();
+    failures += test_merge();
+
+    if (failures == 0) printf("HyperLogLog: promoção e mesclagem conferem\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_support.h"
+#include "../include/ip_table.h"
+#include "../include/ip6_table.h"
+
+/* ========================================================================= *
+ * ÍNDICE HASH DE ORIGENS CONTRA UM MAPA DE REFERÊNCIA                       *
+ * ========================================================================= *
+ * Sequências aleatórias de inserção, remoção e atualização sobre um         *
+ * universo pequeno de chaves: a tabela cresce a partir da capacidade        *
+ * mínima, os clusters se formam e se desfazem (backward-shift) e cada       *
+ * passo é conferido contra um vetor indexado pela chave.                    */
+
+#define KEYS 4096               // Universo de chaves (o mapa de referência é um vetor)
+#define OPERATIONS 400000
+#define ABSENT (-1)
+
+/**
+ * @brief Confere a tabela inteira: cada chave do universo e a contagem.
+ */
+static int check_ip_table(const IpTable *table, const uint32_t *keys, const int32_t *expected, uint32_t present) {
+    CHECK(table->count == present, "count %u, esperado %u", table->count, present);
+    for (int k = 0; k < KEYS; k++) {
+        int32_t found = ip_table_find(table, keys[k]);
+        CHECK(found == expected[k], "chave %08x: %d, esperado %d", keys[k], found, expected[k]);
+        CHECK(ip_table_find_hashed(table, keys[k], ip_table_hash(keys[k])) == found, "find_hashed diverge de find");
+    }
+    return 0;
+}
+
+/**
+ * @brief IpTable: inserção, remoção (presente ou não), atualização e limpeza.
+ */
+static int test_ip_table(void) {
+    static uint32_t keys[KEYS];
+    static int32_t expected[KEYS];
+    uint64_t rng = 0x9e3779b97f4a7c15ull;
+    uint32_t present = 0;
+    IpTable table;
+
+    // 0.0.0.0 é uma chave válida; as demais vêm de dois /20, como numa varredura
+    for (int k = 0; k < KEYS; k++) {
+        keys[k] = k == 0 ? 0 : htonl((k & 1 ? 0x0a000000u : 0xc0a80000u) + (uint32_t)(k >> 1));
+        expected[k] = ABSENT;
+    }
+
+    ip_table_init(&table, 0);
+    for (int op = 0; op < OPERATIONS; op++) {
+        uint64_t r = test_random(&rng);
+        int k = (int)(r % KEYS);
+        int32_t value = (int32_t)(r >> 40);
+
+        switch ((r >> 32) % 4) {
+            case 0:
+            case 1:
+                if (expected[k] != ABSENT) break;
+                ip_table_insert(&table, keys[k], value);
+                expected[k] = value;
+                present++;
+                break;
+            case 2:
+                ip_table_remove(&table, keys[k]);
+                if (expected[k] != ABSENT) present--;
+                expected[k] = ABSENT;
+                break;
+            default:
+                ip_table_update(&table, keys[k], value);
+                if (expected[k] != ABSENT) expected[k] = value;
+                break;
+        }
+
+        // Conferência completa de tempos em tempos; a chave tocada, sempre
+        CHECK(ip_table_find(&table, keys[k]) == expected[k], "operação %d: chave %08x divergente", op, keys[k]);
+        CHECK(table.count * 2 <= table.mask + 1, "ocupação acima de 50%% (%u/%u)", table.count, table.mask + 1);
+        if (op % 10000 == 0 && check_ip_table(&table, keys, expected, present)) return 1;
+    }
+    if (check_ip_table(&table, keys, expected, present)) return 1;
+
+    // Esvaziar remove tudo sem perder a capacidade
+    uint32_t capacity = table.mask + 1;
+    ip_table_clear(&table);
+    for (int k = 0; k < KEYS; k++) expected[k] = ABSENT;
+    CHECK(table.mask + 1 == capacity, "clear alterou a capacidade");
+    if (check_ip_table(&table, keys, expected, 0)) return 1;
+
+    ip_table_free(&table);
+    return 0;
+}
+
+/**
+ * @brief Confere a tabela IPv6 inteira: cada chave do universo e a contagem.
+ */
+static int check_ip6_table(const Ip6Table *table, const Ip6Key *keys, const int32_t *expected, uint32_t present) {
+    CHECK(table->count == present, "count %u, esperado %u", table->count, present);
+    for (int k = 0; k < KEYS; k++) {
+        int32_t found = ip6_table_find(table, keys[k]);
+        CHECK(found == expected[k], "chave %d: %d, esperado %d", k, found, expected[k]);
+        CHECK(ip6_table_find_hashed(table, keys[k], ip6_table_hash(keys[k])) == found, "find_hashed diverge de find");
+    }
+    return 0;
+}
+
+/**
+ * @brief Ip6Table: mesma sequência do IPv4, com chaves que diferem só em hi ou só em lo.
+ * * Prefixos /64 vizinhos e endereços de uma mesma rede exercitam as duas
+ * metades do hash; a chave :: é válida, como 0.0.0.0 no IPv4.
+ */
+static int test_ip6_table(void) {
+    static Ip6Key keys[KEYS];
+    static int32_t expected[KEYS];
+    uint64_t rng = 0xc2b2ae3d27d4eb4full;
+    uint32_t present = 0;
+    Ip6Table table;
+
+    for (int k = 0; k < KEYS; k++) {
+        uint8_t addr[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+        if (k & 1) {
+            addr[6] = (uint8_t)(k >> 9);        // 2001:db8:0:XX00::/64, um prefixo por chave
+            addr[7] = (uint8_t)(k >> 1);
+        } else {
+            addr[14] = (uint8_t)(k >> 9);       // 2001:db8::XX, uma rede com vários hosts
+            addr[15] = (uint8_t)(k >> 1);
+        }
+        keys[k] = k == 0 ? (Ip6Key){ 0, 0 } : ip6_key(addr);
+        expected[k] = ABSENT;
+    }
+
+    // Ida e volta entre bytes e chave, e máscara do prefixo
+    uint8_t bytes[16];
+    ip6_key_bytes(keys[3], bytes);
+    CHECK(ip6_key_equal(ip6_key(bytes), keys[3]), "ip6_key_bytes/ip6_key não são inversas");
+    CHECK(ip6_key_equal(ip6_key_mask(keys[2], 64), ip6_key_mask(keys[4], 64)), "hosts da mesma /64 com prefixos diferentes");
+    CHECK(!ip6_key_equal(ip6_key_mask(keys[1], 64), ip6_key_mask(keys[3], 64)), "redes /64 distintas com o mesmo prefixo");
+
+    ip6_table_init(&table, 0);
+    for (int op = 0; op < OPERATIONS; op++) {
+        uint64_t r = test_random(&rng);
+        int k = (int)(r % KEYS);
+        int32_t value = (int32_t)(r >> 40);
+
+        switch ((r >> 32) % 4) {
+            case 0:
+            case 1:
+                if (expected[k] != ABSENT) break;
+                ip6_table_insert(&table, keys[k], value);
+                expected[k] = value;
+                present++;
+                break;
+            case 2:
+                ip6_table_remove(&table, keys[k]);
+                if (expected[k] != ABSENT) present--;
+                expected[k] = ABSENT;
+                break;
+            default:
+                ip6_table_update(&table, keys[k], value);
+                if (expected[k] != ABSENT) expected[k] = value;
+                break;
+        }
+
+        CHECK(ip6_table_find(&table, keys[k]) == expected[k], "operação %d: chave %d divergente", op, k);
+        CHECK(table.count * 2 <= table.mask + 1, "ocupação acima de 50%% (%u/%u)", table.count, table.mask + 1);
+        if (op % 10000 == 0 && check_ip6_table(&table, keys, expected, present)) return 1;
+    }
+    if (check_ip6_table(&table, keys, expected, present)) return 1;
+
+    ip6_table_clear(&table);
+    for (int k = 0; k < KEYS; k++) expected[k] = ABSENT;
+    if (check_ip6_table(&table, keys, expected, 0)) return 1;
+
+    ip6_table_free(&table);
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_ip_table();
+    failures += test_ip6_table();
+
+    if (failures == 0) printf("tabelas de origens: conferem com o mapa de referência\n");
+    return failures ? 1 : 0;
+}
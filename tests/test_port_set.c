@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_support.h"
+#include "../include/port_set.h"
+
+/* ========================================================================= *
+ * CONJUNTO ADAPTATIVO DE PORTAS                                             *
+ * ========================================================================= *
+ * O mesmo conjunto de portas tem de ser indistinguível nos três modos       *
+ * (inline, vetor ordenado, bitmap): pertinência, contagem, união de shards  *
+ * e diferença são conferidas contra um vetor de 65536 bytes.                */
+
+#define PORTS 65536
+
+// Tamanhos nas bordas de cada modo: vazio, inline, vetor, bitmap
+static const uint32_t sizes[] = { 0, 1, 4, 5, 33, 64, 65, 300, 20000 };
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+
+/**
+ * @brief Confere pertinência e contagem de todas as portas contra a referência.
+ */
+static int check_port_set(const PortSet *set, const uint8_t *expected) {
+    uint32_t count = 0;
+
+    for (uint32_t port = 0; port < PORTS; port++) {
+        CHECK(port_set_contains(set, (uint16_t)port) == expected[port], "porta %u: pertinência divergente (modo %u)",
+              port, set->capacity);
+        count += expected[port];
+    }
+    CHECK(port_set_count(set) == count, "count %u, esperado %u", port_set_count(set), count);
+    return 0;
+}
+
+/**
+ * @brief Modo esperado para a contagem: inline até PORT_SET_INLINE, vetor até PORT_SET_ARRAY_MAX, depois bitmap.
+ */
+static int check_mode(const PortSet *set) {
+    uint32_t count = port_set_count(set);
+
+    if (count <= PORT_SET_INLINE) {
+        CHECK(set->capacity == 0, "%u portas fora do modo inline (capacity %u)", count, set->capacity);
+    } else if (count <= PORT_SET_ARRAY_MAX) {
+        CHECK(set->capacity != PORT_SET_BITMAP && set->capacity >= count, "%u portas: vetor esperado (capacity %u)",
+              count, set->capacity);
+    } else {
+        CHECK(set->capacity == PORT_SET_BITMAP, "%u portas fora do modo bitmap (capacity %u)", count, set->capacity);
+    }
+    CHECK(port_set_heap_bytes(set) == (set->capacity == PORT_SET_BITMAP ? PORT_SET_WORDS * sizeof(uint64_t)
+                                                                       : (size_t)set->capacity * sizeof(uint16_t)),
+          "heap_bytes incoerente com o modo");
+    return 0;
+}
+
+/**
+ * @brief Sorteia 'size' portas distintas; metade das vezes num intervalo estreito, para forçar sobreposição.
+ */
+static void random_ports(PortSet *set, uint8_t *expected, uint32_t size, uint64_t *rng) {
+    uint32_t range = (test_random(rng) & 1) ? PORTS : size * 2 + 8;
+    if (range > PORTS) range = PORTS;
+
+    memset(set, 0, sizeof(*set));
+    memset(expected, 0, PORTS);
+    for (uint32_t added = 0; added < size; ) {
+        uint16_t port = (uint16_t)(test_random(rng) % range);
+        if (expected[port]) continue;
+        port_set_add(set, port);
+        expected[port] = 1;
+        added++;
+    }
+}
+
+/**
+ * @brief Inserção em ordem aleatória, com repetições, atravessando as duas promoções.
+ */
+static int test_promotion(void) {
+    static uint8_t expected[PORTS];
+    uint64_t rng = 0x2545f4914f6cdd1dull;
+    PortSet set = {0};
+
+    // Inclui as portas extremas, que caem no primeiro e no último bit do bitmap
+    uint16_t edges[] = { 0, 65535, 63, 64 };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        CHECK(port_set_add(&set, edges[i]) == 1, "porta %u não foi tratada como nova", edges[i]);
+        expected[edges[i]] = 1;
+    }
+
+    for (int i = 0; i < 3000; i++) {
+        uint16_t port = (uint16_t)(test_random(&rng) % 2000);
+        int fresh = !expected[port];
+
+        CHECK(port_set_add(&set, port) == fresh, "add(%u) devolveu %d, esperado %d", port, !fresh, fresh);
+        expected[port] = 1;
+        if (check_mode(&set)) return 1;
+        if ((i < 100 || i % 500 == 0) && check_port_set(&set, expected)) return 1;
+    }
+    if (check_port_set(&set, expected)) return 1;
+
+    port_set_free(&set);
+    CHECK(port_set_count(&set) == 0 && set.capacity == 0 && port_set_heap_bytes(&set) == 0, "free não esvaziou o conjunto");
+    return 0;
+}
+
+/**
+ * @brief União e diferença para todas as combinações de modos.
+ * * A união de dois shards precisa ser o conjunto que um único shard teria
+ * construído com todas as portas, qualquer que seja o modo de cada lado.
+ */
+static int test_union_difference(void) {
+    static uint8_t in_a[PORTS], in_b[PORTS], in_union[PORTS];
+    uint64_t rng = 0x9e3779b97f4a7c15ull;
+
+    for (size_t i = 0; i < SIZE_COUNT; i++) {
+        for (size_t j = 0; j < SIZE_COUNT; j++) {
+            PortSet a, b, serial = {0};
+            uint32_t a_minus_b = 0, b_minus_a = 0;
+
+            random_ports(&a, in_a, sizes[i], &rng);
+            random_ports(&b, in_b, sizes[j], &rng);
+            for (uint32_t port = 0; port < PORTS; port++) {
+                in_union[port] = in_a[port] | in_b[port];
+                a_minus_b += in_a[port] && !in_b[port];
+                b_minus_a += in_b[port] && !in_a[port];
+                if (in_union[port]) port_set_add(&serial, (uint16_t)port);
+            }
+
+            CHECK(port_set_difference_count(&a, &b) == a_minus_b, "|A \\ B| com |A|=%u, |B|=%u: %u, esperado %u",
+                  sizes[i], sizes[j], port_set_difference_count(&a, &b), a_minus_b);
+            CHECK(port_set_difference_count(&b, &a) == b_minus_a, "|B \\ A| com |A|=%u, |B|=%u: %u, esperado %u",
+                  sizes[i], sizes[j], port_set_difference_count(&b, &a), b_minus_a);
+
+            port_set_union(&a, &b);
+            if (check_port_set(&a, in_union) || check_port_set(&b, in_b)) return 1;
+            CHECK(port_set_count(&a) == port_set_count(&serial), "união (%u) difere do conjunto serial (%u)",
+                  port_set_count(&a), port_set_count(&serial));
+            CHECK(port_set_difference_count(&a, &b) == a_minus_b, "diferença mudou após a união");
+
+            port_set_free(&a);
+            port_set_free(&b);
+            port_set_free(&serial);
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_promotion();
+    failures += test_union_difference();
+
+    if (failures == 0) printf("conjunto de portas: modos, união e diferença conferem\n");
+    return failures ? 1 : 0;
+}
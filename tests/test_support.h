@@ -0,0 +1,133 @@
+#ifndef NETWORK_TRAFFIC_ANALYZER_TEST_SUPPORT_H
+#define NETWORK_TRAFFIC_ANALYZER_TEST_SUPPORT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+/**
+ * @brief Falha o teste corrente (a função devolve 1) com a posição e a mensagem.
+ */
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        return 1; \
+    } \
+} while (0)
+
+/* ========================================================================= *
+ * GERADOR DETERMINÍSTICO                                                    *
+ * ========================================================================= */
+
+/**
+ * @brief xorshift64*: mesma sequência em qualquer libc, para falhas reproduzíveis.
+ */
+static inline uint64_t test_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1Dull;
+}
+
+/* ========================================================================= *
+ * QUADROS E CAPTURAS SINTÉTICAS                                             *
+ * ========================================================================= */
+
+#define TEST_FRAME_MAX 256
+#define TEST_L4_OFFSET 34               // Ethernet (14) + IPv4 sem opções (20)
+
+/**
+ * @struct TestFrame
+ * @brief Quadro Ethernet/IPv4 montado pelos testes.
+ */
+typedef struct {
+    uint8_t data[TEST_FRAME_MAX];
+    size_t len;
+} TestFrame;
+
+static inline uint32_t test_ip(const char *dotted) {
+    struct in_addr addr;
+    inet_pton(AF_INET, dotted, &addr);
+    return addr.s_addr;
+}
+
+static inline void put16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+/**
+ * @brief Cabeçalhos Ethernet e IPv4 (sem opções) com l4_len bytes de transporte.
+ * @param src Endereço de origem (formato de rede).
+ */
+static inline void frame_ipv4(TestFrame *frame, uint32_t src, uint32_t dst, uint8_t proto, size_t l4_len) {
+    static const uint8_t macs[12] = { 0x02, 0, 0, 0, 0, 0x01, 0x02, 0, 0, 0, 0, 0x02 };
+    uint8_t *ip = frame->data + 14;
+
+    memset(frame->data, 0, TEST_L4_OFFSET + l4_len);
+    memcpy(frame->data, macs, sizeof(macs));
+    put16(frame->data + 12, 0x0800);
+    ip[0] = 0x45;
+    put16(ip + 2, (uint16_t)(20 + l4_len));
+    ip[8] = 64;
+    ip[9] = proto;
+    memcpy(ip + 12, &src, 4);
+    memcpy(ip + 16, &dst, 4);
+    frame->len = TEST_L4_OFFSET + l4_len;
+}
+
+static inline void frame_tcp(TestFrame *frame, uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport, uint8_t flags) {
+    frame_ipv4(frame, src, dst, 6, 20);
+    uint8_t *tcp = frame->data + TEST_L4_OFFSET;
+    put16(tcp, sport);
+    put16(tcp + 2, dport);
+    tcp[12] = 5 << 4;
+    tcp[13] = flags;
+    put16(tcp + 14, 65535);
+}
+
+static inline void frame_udp(TestFrame *frame, uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport, size_t payload) {
+    frame_ipv4(frame, src, dst, 17, 8 + payload);
+    uint8_t *udp = frame->data + TEST_L4_OFFSET;
+    put16(udp, sport);
+    put16(udp + 2, dport);
+    put16(udp + 4, (uint16_t)(8 + payload));
+}
+
+/**
+ * @brief ICMP port-unreachable de 'from' citando o cabeçalho IP e os 8 primeiros bytes de quoted.
+ */
+static inline void frame_port_unreachable(TestFrame *frame, uint32_t from, const TestFrame *quoted) {
+    uint32_t prober;
+    memcpy(&prober, quoted->data + 14 + 12, 4);
+    frame_ipv4(frame, from, prober, 1, 8 + 28);
+    uint8_t *icmp = frame->data + TEST_L4_OFFSET;
+    icmp[0] = 3;                        // Destination unreachable
+    icmp[1] = 3;                        // Port unreachable
+    memcpy(icmp + 8, quoted->data + 14, 28);
+}
+
+/**
+ * @brief Abre um pcap clássico (microssegundos, DLT_EN10MB) para escrita.
+ */
+static inline FILE *pcap_writer_open(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return NULL;
+
+    uint32_t header[6] = { 0xa1b2c3d4, 2 | (4u << 16), 0, 0, 65535, 1 };
+    fwrite(header, sizeof(header), 1, file);
+    return file;
+}
+
+static inline void pcap_writer_add(FILE *file, uint64_t ts_ns, const TestFrame *frame) {
+    uint32_t record[4] = { (uint32_t)(ts_ns / 1000000000ull), (uint32_t)(ts_ns % 1000000000ull / 1000),
+                           (uint32_t)frame->len, (uint32_t)frame->len };
+    fwrite(record, sizeof(record), 1, file);
+    fwrite(frame->data, frame->len, 1, file);
+}
+
+#endif
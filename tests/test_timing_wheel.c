@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_support.h"
+#include "../include/timing_wheel.h"
+
+/* ========================================================================= *
+ * RODA DE TEMPORIZAÇÃO: CASCATA ENTRE NÍVEIS                                *
+ * ========================================================================= *
+ * Cada entrada precisa sair exatamente na primeira chamada de expire() com  *
+ * o relógio no seu tick ou além, tenha ela sido agendada no nível 0 ou      *
+ * descido de um nível superior. Os testes conferem isso contra os deadlines *
+ * guardados à parte, com avanços de um tick e saltos longos.                */
+
+#define POOL 2048
+#define WHEEL_SPAN_TICKS ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+#define UNSCHEDULED UINT64_MAX
+
+static uint64_t tick_ns(uint64_t tick) {
+    return tick << WHEEL_TICK_SHIFT;
+}
+
+/**
+ * @brief Drena a roda até now e confere as saídas contra os deadlines de referência.
+ * @param deadlines Tick de cada entrada agendada (UNSCHEDULED fora da roda); atualizado.
+ * @param ids Entradas em uso (os índices 0..ids-1).
+ */
+static int drain(TimingWheel *wheel, uint64_t now, uint64_t *deadlines, int ids, int *scheduled) {
+    int32_t id;
+
+    while ((id = timing_wheel_expire(wheel, tick_ns(now))) != WHEEL_NONE) {
+        CHECK(id >= 0 && id < ids, "índice %d fora do pool", id);
+        CHECK(deadlines[id] != UNSCHEDULED, "entrada %d expirou sem estar agendada", id);
+        CHECK(deadlines[id] <= now, "entrada %d expirou no tick %llu, antes do prazo %llu",
+              id, (unsigned long long)now, (unsigned long long)deadlines[id]);
+        deadlines[id] = UNSCHEDULED;
+        (*scheduled)--;
+    }
+
+    // Tudo o que venceu até aqui já saiu
+    for (int i = 0; i < ids; i++) {
+        CHECK(deadlines[i] == UNSCHEDULED || deadlines[i] > now, "entrada %d (prazo %llu) não expirou no tick %llu",
+              i, (unsigned long long)deadlines[i], (unsigned long long)now);
+    }
+    CHECK(wheel->count == *scheduled, "count %d, esperado %d", wheel->count, *scheduled);
+    return 0;
+}
+
+/**
+ * @brief Deadlines nas bordas de cada nível, com o relógio avançando tick a tick.
+ */
+static int test_level_boundaries(void) {
+    static uint64_t deadlines[POOL];
+    static const uint64_t edges[] = { 1, WHEEL_SLOTS, (uint64_t)WHEEL_SLOTS * WHEEL_SLOTS, WHEEL_SPAN_TICKS };
+    TimingWheel wheel;
+    int scheduled = 0, n = 0;
+    uint64_t start = 1000;  // Fora do alinhamento de qualquer nível
+
+    timing_wheel_init(&wheel, POOL);
+    for (int i = 0; i < POOL; i++) deadlines[i] = UNSCHEDULED;
+
+    // Relógio parado em start: expire() com a roda vazia só o acompanha
+    CHECK(timing_wheel_expire(&wheel, tick_ns(start)) == WHEEL_NONE, "roda vazia devolveu uma entrada");
+
+    for (size_t e = 0; e < sizeof(edges) / sizeof(edges[0]); e++) {
+        for (int64_t d = -2; d <= 2; d++) {
+            uint64_t delta = edges[e] + (uint64_t)d;
+            if (delta < 1 || delta >= WHEEL_SPAN_TICKS) continue;
+
+            // Borda relativa ao relógio e borda absoluta (slot 0 do nível seguinte)
+            deadlines[n] = start + delta;
+            timing_wheel_schedule(&wheel, n, tick_ns(deadlines[n]));
+            n++;
+            deadlines[n] = (start & ~(edges[e] - 1)) + edges[e] + (uint64_t)d;
+            timing_wheel_schedule(&wheel, n, tick_ns(deadlines[n]) + (1u << (WHEEL_TICK_SHIFT - 1)));
+            n++;
+            scheduled += 2;
+        }
+    }
+
+    for (uint64_t now = start; scheduled > 0; now++) {
+        CHECK(now <= start + WHEEL_SPAN_TICKS, "entradas presas na roda: %d restantes", scheduled);
+        if (drain(&wheel, now, deadlines, n, &scheduled)) return 1;
+    }
+
+    timing_wheel_free(&wheel);
+    return 0;
+}
+
+/**
+ * @brief Agendamentos, cancelamentos e movimentações aleatórias com saltos de relógio de todos os tamanhos.
+ */
+static int test_random_schedule(void) {
+    static uint64_t deadlines[POOL];
+    TimingWheel wheel;
+    uint64_t rng = 0x5851f42d4c957f2dull;
+    uint64_t now = 12345;
+    int scheduled = 0;
+
+    timing_wheel_init(&wheel, POOL);
+    for (int i = 0; i < POOL; i++) deadlines[i] = UNSCHEDULED;
+
+    for (int step = 0; step < 20000; step++) {
+        uint64_t r = test_random(&rng);
+        int id = (int)(r % POOL);
+
+        switch ((r >> 16) % 8) {
+            case 0:
+            case 1:
+            case 2: {
+                if (deadlines[id] != UNSCHEDULED) break;
+                // Prazo em um dos três níveis, escolhido uniformemente
+                uint64_t span = (uint64_t)1 << (WHEEL_BITS * (1 + (r >> 24) % WHEEL_LEVELS));
+                deadlines[id] = now + 1 + (r >> 32) % (span - 1);
+                timing_wheel_schedule(&wheel, id, tick_ns(deadlines[id]));
+                scheduled++;
+                break;
+            }
+            case 3:
+                timing_wheel_cancel(&wheel, id);
+                if (deadlines[id] != UNSCHEDULED) scheduled--;
+                deadlines[id] = UNSCHEDULED;
+                break;
+            case 4: {
+                // O pool do chamador compacta: a entrada muda de índice dentro da roda
+                int to = (int)((r >> 32) % POOL);
+                if (deadlines[to] != UNSCHEDULED || to == id) break;
+                timing_wheel_move(&wheel, id, to);
+                deadlines[to] = deadlines[id];
+                deadlines[id] = UNSCHEDULED;
+                break;
+            }
+            default: {
+                // Avanço curto (dentro do nível 0) ou salto que atravessa níveis
+                uint64_t jump = (r >> 20) % 4 == 0 ? (r >> 32) % ((uint64_t)WHEEL_SLOTS * WHEEL_SLOTS * 2) : (r >> 32) % 8;
+                now += jump;
+                if (drain(&wheel, now, deadlines, POOL, &scheduled)) return 1;
+                break;
+            }
+        }
+    }
+
+    // Até o fim do maior prazo possível, nada pode sobrar
+    now += WHEEL_SPAN_TICKS;
+    if (drain(&wheel, now, deadlines, POOL, &scheduled)) return 1;
+    CHECK(scheduled == 0, "%d entradas não expiraram", scheduled);
+
+    timing_wheel_free(&wheel);
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_level_boundaries();
+    failures += test_random_schedule();
+
+    if (failures == 0) printf("roda de temporização: cascata entre níveis confere\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "test_support.h"
+#include "../include/analyzer.h"
+#include "../include/publisher.h"
+#include "../include/stats.h"
+
+/* ========================================================================= *
+ * RASTREADOR AO VIVO SOB ORÇAMENTO                                          *
+ * ========================================================================= *
+ * Um flood de origens falsificadas (um SYN cada) enche o pool de um shard   *
+ * pequeno; o despejo CLOCK precisa manter a memória fixa e preservar um     *
+ * varredor que segue abaixo do limiar no meio do flood.                     */
+
+#define TRACKER_BUDGET (256 * 1024)
+#define FLOOD_SOURCES 200000
+#define SCANNER_SHARE 4         // O varredor volta a cada capacidade/4 origens do flood (antes de o pool girar)
+#define SCANNER_PORTS (SCAN_THRESHOLD - 1)
+
+static int analyze(IdsShard *shard, const TestFrame *frame, uint64_t ts_ns) {
+    return analyze_packet_shard(shard, frame->data, (int)frame->len, (int)frame->len, ts_ns);
+}
+
+/**
+ * @brief Flood de origens distintas com um varredor intercalado, seguido da expiração por inatividade.
+ */
+static int test_budget_eviction(void) {
+    TrackerStats stats;
+    TestFrame frame;
+    uint64_t ts = 1700000000ull * NSEC_PER_SEC;
+    uint32_t scanner = test_ip("10.66.0.1");
+    uint32_t scanner_packets = 0;
+
+    IdsShard *shard = create_ids_shard(SHARD_LIVE, TRACKER_BUDGET);
+    get_tracker_stats(shard, &stats);
+    CHECK(stats.capacity > 0 && stats.capacity < FLOOD_SOURCES, "capacidade %llu fora do esperado", stats.capacity);
+    unsigned long long capacity = stats.capacity;
+    unsigned long long fixed_bytes = stats.memory_bytes;
+    CHECK(fixed_bytes <= TRACKER_BUDGET, "pool e índices (%llu bytes) acima do orçamento", fixed_bytes);
+    uint32_t scanner_every = (uint32_t)(capacity / SCANNER_SHARE);
+
+    for (uint32_t i = 0; i < FLOOD_SOURCES; i++) {
+        frame_tcp(&frame, htonl(0x0b000000u + i), test_ip("192.168.0.10"), 40000, 80, 0x02);
+        analyze(shard, &frame, ts += 1000);
+
+        if (i % scanner_every == 0) {
+            frame_tcp(&frame, scanner, test_ip("192.168.0.20"), 50000, (uint16_t)(1000 + scanner_packets % SCANNER_PORTS), 0x02);
+            analyze(shard, &frame, ts += 1000);
+            scanner_packets++;
+        }
+
+        if (i % 10000 == 0) {
+            get_tracker_stats(shard, &stats);
+            CHECK(stats.tracked <= capacity, "%llu origens rastreadas com capacidade %llu", stats.tracked, capacity);
+            CHECK(stats.memory_bytes == fixed_bytes, "memória do rastreador variou: %llu -> %llu", fixed_bytes, stats.memory_bytes);
+        }
+    }
+
+    // Nada expira em 0,4 s: toda origem que saiu do pool foi despejada
+    get_tracker_stats(shard, &stats);
+    CHECK(stats.tracked == capacity, "pool não ficou cheio (%llu/%llu)", stats.tracked, capacity);
+    CHECK(stats.expirations == 0, "%llu expirações durante o flood", stats.expirations);
+    CHECK(stats.evictions == FLOOD_SOURCES + 1 - stats.tracked, "despejos %llu, esperado %llu",
+          stats.evictions, FLOOD_SOURCES + 1 - stats.tracked);
+    CHECK(stats.evictions_suspects == 0, "varredor despejado %llu vez(es) a meio caminho do alerta", stats.evictions_suspects);
+
+    // Depois do prazo de inatividade, uma origem ativa drena a roda aos poucos
+    ts += 301ull * NSEC_PER_SEC;
+    frame_tcp(&frame, test_ip("10.77.0.1"), test_ip("192.168.0.10"), 40000, 443, 0x18);
+    for (unsigned long long p = 0; p <= capacity; p++) analyze(shard, &frame, ts += 1000);
+
+    get_tracker_stats(shard, &stats);
+    CHECK(stats.tracked == 1, "%llu origens restantes após a inatividade", stats.tracked);
+    CHECK(stats.expirations == capacity, "expirações %llu, esperado %llu", stats.expirations, capacity);
+
+    destroy_ids_shard(shard);
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    disable_queue();
+    set_enabled_detectors(DETECT_PORT_SCAN);
+    set_promote_threshold(1);
+    set_flow_budget(0);
+    set_topk_size(0);
+
+    failures += test_budget_eviction();
+
+    if (failures == 0) printf("rastreador: orçamento respeitado, varredor preservado, inativos expirados\n");
+    return failures ? 1 : 0;
+}